@@ -68,11 +68,12 @@ class FieldsBuilder:
         self,
         indices: Union[Sequence[_Axis], _Axis],
         dimensions: Union[Sequence[int], int],
+        morton: bool = False,
     ):
         """Same as :func:`taichi.lang.snode.SNode.dense`"""
         self._check_not_finalized()
         self.empty = False
-        return self.root.dense(indices, dimensions)
+        return self.root.dense(indices, dimensions, morton)
 
     def pointer(
         self,
@@ -86,9 +87,16 @@ class FieldsBuilder:
         self.empty = False
         return self.root.pointer(indices, dimensions)
 
-    def _hash(self, indices, dimensions):
+    def hash(
+        self,
+        indices: Union[Sequence[_Axis], _Axis],
+        dimensions: Union[Sequence[int], int],
+        capacity: int = 65536,
+    ):
         """Same as :func:`taichi.lang.snode.SNode.hash`"""
-        raise NotImplementedError()
+        self._check_not_finalized()
+        self.empty = False
+        return self.root.hash(indices, dimensions, capacity)
 
     def dynamic(
         self,
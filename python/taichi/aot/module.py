@@ -57,6 +57,7 @@ class KernelTemplate:
             else:
                 injected_args.append(0)
         kernel.ensure_compiled(*injected_args)
+        self._aot_module._flush_kernels()
         self._aot_module._aot_builder.add_kernel_template(name, key_p, kernel.kernel_cpp)
 
         # kernel AOT
@@ -109,6 +110,9 @@ class Module:
         rtm._finalize_root_fb_for_aot()
         self._aot_builder = rtm.prog.make_aot_module_builder(arch, caps)
         self._content = []
+        # Kernels are handed to the builder in batches so that they can be
+        # compiled concurrently.
+        self._pending_kernels = []
 
     def add_field(self, name, field):
         """Add a taichi field to the AOT module.
@@ -168,14 +172,20 @@ class Module:
         else:
             injected_args = produce_injected_args(kernel)
         kernel.ensure_compiled(*injected_args)
-        self._aot_builder.add(kernel_name, kernel.kernel_cpp)
+        self._pending_kernels.append((kernel_name, kernel.kernel_cpp))
 
         # kernel AOT
         self._kernels.append(kernel)
 
         self._content += ["kernel:" + kernel_name]
 
+    def _flush_kernels(self):
+        if self._pending_kernels:
+            self._aot_builder.add_kernels(self._pending_kernels)
+            self._pending_kernels = []
+
     def add_graph(self, name, graph):
+        self._flush_kernels()
         self._aot_builder.add_graph(name, graph._compiled_graph)
         self._content += ["cgraph:" + name]
 
@@ -220,6 +230,7 @@ class Module:
           filepath (str): path to a folder to store aot files.
         """
         filepath = str(PurePosixPath(Path(filepath)))
+        self._flush_kernels()
         self._aot_builder.dump(filepath, "")
         with open(f"{filepath}/__content__", "w") as f:
             f.write("\n".join(self._content))
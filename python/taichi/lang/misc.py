@@ -179,6 +179,17 @@ def timeline_save(fn):
     return impl.get_runtime().prog.timeline_save(fn)
 
 
+def compile_profiler_clear():
+    return impl.get_runtime().prog.compile_profiler_clear()
+
+
+def compile_profiler_save(fn):
+    """Saves the time and IR statement counts of every compilation pass
+    recorded with ``ti.init(compile_profiler=True)`` to a JSON file.
+    """
+    return impl.get_runtime().prog.compile_profiler_save(fn)
+
+
 extension = _ti_core.Extension
 """An instance of Taichi extension.
 
@@ -346,9 +357,23 @@ def init(
             https://github.com/taichi-dev/taichi/blob/master/taichi/program/compile_config.h.
 
             * ``cpu_max_num_threads`` (int): Sets the number of threads used by the CPU thread pool.
+            * ``cpu_async_launch`` (bool): Launches CPU kernels asynchronously, blocking only on synchronization points such as ``ti.sync()``. Default to False.
+            * ``slp_vectorization`` (bool): Packs isomorphic scalar arithmetic into SIMD vector operations on CPU. Default to False.
+            * ``cpu_loop_tiling`` (bool): Visits dense multi-dimensional struct-for loops tile by tile on CPU for better cache reuse. Default to True.
+            * ``cpu_loop_tile_size`` (int): The tile edge used by ``cpu_loop_tiling``, or 0 to choose it from the field layout. Default to 0.
+            * ``offload_fusion`` (bool): Fuses adjacent parallel loops over the same range or dense field into one task when they only depend on each other element by element. Default to True.
+            * ``listgen_reuse`` (bool): Skips regenerating the element lists of a sparse field for a struct-for when no cell has been activated or deactivated since the last one (LLVM backends). Default to True.
+            * ``graph_fusion`` (bool): Compiles consecutive kernel dispatches of a ``ti.graph`` into a single kernel, so that they are launched once. Default to True.
+            * ``ad_checkpointing`` (bool): Stores only periodic checkpoints of long loops on the autodiff stacks and recomputes the loop bodies in between during the backward pass, trading compute for stack memory. Default to False.
+            * ``ad_block_local_adjoints`` (bool): In the backward kernels of struct-for loops that cache fields with ``ti.block_local``, accumulates the gradients of those fields in block-local buffers instead of with one global atomic per access. On CPUs, the buffer is a stack array of the thread processing the block, and only accumulated fields are cached. Default to True.
             * ``debug`` (bool): Enables the debug mode, under which Taichi does a few more things like boundary checks.
             * ``print_ir`` (bool): Prints the CHI IR of the Taichi kernels.
+            * ``compile_profiler`` (bool): Records the time and IR statement count of each compilation pass of each kernel, see ``ti.compile_profiler_save``. Default to False.
+            * ``llvm_task_cache`` (bool): Shares the generated code of identical offloaded tasks between kernels on LLVM backends, e.g. between instantiations of a template. Default to True.
             *``offline_cache`` (bool): Enables offline cache of the compiled kernels. Default to True. When this is enabled Taichi will cache compiled kernel on your local disk to accelerate future calls.
+            *``offline_cache_single_file`` (bool): Stores the offline cache in a single memory-mapped container file instead of one file per kernel. Default to False.
+            *``offline_cache_multi_process`` (bool): Lets concurrently running processes share one offline cache directory, compiling each kernel only once. Default to False.
+            *``offline_cache_warm_up_kernels`` (int): Number of most recently used kernels to load from the offline cache in the background at startup. Default to 0.
             *``random_seed`` (int): Sets the seed of the random generator. The default is 0.
     """
     # Check version for users every 7 days if not disabled by users.
@@ -798,6 +823,8 @@ __all__ = [
     "assume_in_range",
     "block_local",
     "cache_read_only",
+    "compile_profiler_clear",
+    "compile_profiler_save",
     "init",
     "mesh_local",
     "no_activate",
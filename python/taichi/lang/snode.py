@@ -23,18 +23,27 @@ class SNode:
     def __init__(self, ptr):
         self.ptr = ptr
 
-    def dense(self, axes, dimensions):
+    def dense(self, axes, dimensions, morton=False):
         """Adds a dense SNode as a child component of `self`.
 
+        With `morton=True` the cells are stored in Morton (Z-curve) order
+        instead of row-major order, so that neighbours along every axis stay
+        close in memory. All dimensions must then be powers of two; if they
+        differ, the cells are grouped into cubic bricks of the smallest
+        dimension, stored in row-major order. Kernels need no change.
+
         Args:
             axes (List[Axis]): Axes to activate.
             dimensions (Union[List[int], int]): Shape of each axis.
+            morton (bool): Whether to store the cells in Morton order.
 
         Returns:
             The added :class:`~taichi.lang.SNode` instance.
         """
         if isinstance(dimensions, numbers.Number):
             dimensions = [dimensions] * len(axes)
+        if morton:
+            return SNode(self.ptr.morton_dense(axes, dimensions, _ti_core.DebugInfo(get_traceback())))
         return SNode(self.ptr.dense(axes, dimensions, _ti_core.DebugInfo(get_traceback())))
 
     def pointer(self, axes, dimensions):
@@ -53,14 +62,27 @@ class SNode:
             dimensions = [dimensions] * len(axes)
         return SNode(self.ptr.pointer(axes, dimensions, _ti_core.DebugInfo(get_traceback())))
 
-    @staticmethod
-    def _hash(axes, dimensions):
-        # original code is #def hash(self,axes, dimensions) without #@staticmethod   before fix pylint R0201
-        """Not supported."""
-        raise RuntimeError("hash not yet supported")
-        # if isinstance(dimensions, int):
-        #     dimensions = [dimensions] * len(axes)
-        # return SNode(self.ptr.hash(axes, dimensions))
+    def hash(self, axes, dimensions, capacity=65536):
+        """Adds a hash SNode as a child component of `self`.
+
+        Unlike a pointer SNode, which keeps a slot for every cell, a hash SNode
+        keeps a hash table of `capacity` slots, so that very large and sparse
+        domains only pay for the cells that are active. Only supported on CPU,
+        and only as a child of the root.
+
+        Args:
+            axes (List[Axis]): Axes to activate.
+            dimensions (Union[List[int], int]): Shape of each axis.
+            capacity (int): The maximum number of active cells, a power of two.
+
+        Returns:
+            The added :class:`~taichi.lang.SNode` instance.
+        """
+        if impl.current_cfg().arch not in (_ti_core.x64, _ti_core.arm64):
+            raise TaichiRuntimeError("Hash SNode is only supported on CPU backends.")
+        if isinstance(dimensions, numbers.Number):
+            dimensions = [dimensions] * len(axes)
+        return SNode(self.ptr.hash(axes, dimensions, capacity, _ti_core.DebugInfo(get_traceback())))
 
     def dynamic(self, axis, dimension, chunk_size=None):
         """Adds a dynamic SNode as a child component of `self`.
@@ -68,7 +90,8 @@ class SNode:
         Args:
             axis (List[Axis]): Axis to activate, must be 1.
             dimension (int): Shape of the axis.
-            chunk_size (int): Chunk size.
+            chunk_size (int): Chunk size. Small chunks allocate memory at a
+                finer grain, but take more directory lookups per access.
 
         Returns:
             The added :class:`~taichi.lang.SNode` instance.
@@ -289,7 +312,7 @@ class SNode:
         for c in ch:
             c.deactivate_all()
         SNodeType = _ti_core.SNodeType
-        if self.ptr.type == SNodeType.pointer or self.ptr.type == SNodeType.bitmasked:
+        if self.ptr.type in (SNodeType.pointer, SNodeType.hash, SNodeType.bitmasked):
             from taichi._kernels import snode_deactivate  # pylint: disable=C0415
 
             snode_deactivate(self)
@@ -375,6 +398,10 @@ def append(node, indices, val):
         node (:class:`~taichi.SNode`): Input SNode.
         indices (Union[int, :class:`~taichi.Vector`]): the indices to visit.
         val (Union[:mod:`~taichi.types.primitive_types`, :mod:`~taichi.types.compound_types`]): the data to be appended.
+
+    Returns:
+        The index `val` is appended at. If the list is full, `val` is dropped
+        and the returned index is out of range; in debug mode this is an error.
     """
     ptrs = expr._get_flattened_ptrs(val)
     append_expr = expr.Expr(
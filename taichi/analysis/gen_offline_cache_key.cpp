@@ -1,5 +1,7 @@
 #include "offline_cache_util.h"
 
+#include <unordered_set>
+
 #include "taichi/ir/expr.h"
 #include "taichi/ir/frontend_ir.h"
 #include "taichi/ir/ir.h"
@@ -53,18 +55,11 @@ class ASTSerializer : public IRVisitor, public ExpressionVisitor {
   using IRVisitor::visit;
 
  public:
-  explicit ASTSerializer(std::ostream *os) : ExpressionVisitor(false), os_(os) {
+  explicit ASTSerializer(Hash128Builder *hasher)
+      : ExpressionVisitor(false), hasher_(hasher) {
     this->allow_undefined_visitor = false;
   }
 
-  void set_ostream(std::ostream *os) {
-    this->os_ = os;
-  }
-
-  std::ostream *get_ostream() {
-    return this->os_;
-  }
-
   void visit(Expression *expr) override {
     this->ExpressionVisitor::visit(expr);
   }
@@ -424,55 +419,48 @@ class ASTSerializer : public IRVisitor, public ExpressionVisitor {
     emit(stmt->outputs);
   }
 
-  static void run(IRNode *ast, std::ostream *os) {
-    ASTSerializer serializer(os);
+  static Hash128 run(IRNode *ast) {
+    Hash128Builder hasher;
+    ASTSerializer serializer(&hasher);
     ast->accept(&serializer);
     serializer.emit_dependencies();
+    return hasher.finish();
   }
 
  private:
   void emit_dependencies() {
-    // Serialize dependent real-functions
-    emit(real_funcs_.size());
+    // Serialize dependent real-functions (by the digest of their AST),
+    // in the order they were first referenced.
+    std::vector<Function *> funcs(real_funcs_.size());
     for (auto &[func, id] : real_funcs_) {
+      funcs[id] = func;
+    }
+    emit(real_funcs_.size());
+    for (auto *func : funcs) {
       if (auto &ast_str = func->try_get_ast_serialization_data();
           ast_str.has_value()) {
         emit_bytes(ast_str->c_str(), ast_str->size());
       }
     }
 
-    // Serialize snode_trees(Temporary: using offline-cache-key of SNode)
-    // Note: The result of serializing snode_tree_roots_ is not parsable now
+    // Serialize snode_trees (using the memoized offline-cache-key of SNode)
     emit(static_cast<std::size_t>(snode_tree_roots_.size()));
     for (const auto *snode : snode_tree_roots_) {
-      std::string key;
-      if (snode_key_cache_.find(snode) == snode_key_cache_.end()) {
-        key = get_hashed_offline_cache_key_of_snode(snode);
-        snode_key_cache_[snode] = key;
-      } else {
-        key = snode_key_cache_[snode];
-      }
-      snode_key_cache_[snode] = key;
+      const auto key = get_hashed_offline_cache_key_of_snode(snode);
       emit_bytes(key.c_str(), key.size());
     }
-
-    // Dump string-pool
-    emit(static_cast<std::size_t>(string_pool_.size()));
-    emit_bytes(string_pool_.data(), string_pool_.size());
   }
 
   template <typename T>
   void emit_pod(const T &val) {
     static_assert(std::is_pod<T>::value);
-    TI_ASSERT(os_);
-    os_->write((const char *)&val, sizeof(T));
+    hasher_->update_pod(val);
   }
 
   void emit_bytes(const char *bytes, std::size_t len) {
-    TI_ASSERT(os_);
     if (!bytes)
       return;
-    os_->write(bytes, len);
+    hasher_->update(bytes, len);
   }
 
   template <typename T>
@@ -508,11 +496,8 @@ class ASTSerializer : public IRVisitor, public ExpressionVisitor {
   }
 
   void emit(const std::string &str) {
-    std::size_t size = str.size();
-    std::size_t offset = string_pool_.size();
-    string_pool_.insert(string_pool_.end(), str.begin(), str.end());
-    emit(size);
-    emit(offset);
+    emit(str.size());
+    emit_bytes(str.data(), str.size());
   }
 
   void emit(Function *func) {
@@ -539,7 +524,9 @@ class ASTSerializer : public IRVisitor, public ExpressionVisitor {
       emit(static_cast<std::size_t>(snode->get_snode_tree_id()));
       emit(static_cast<std::size_t>(snode->id));
       const auto *root = snode->get_root();
-      snode_tree_roots_.push_back(root);
+      if (snode_tree_root_set_.insert(root).second) {
+        snode_tree_roots_.push_back(root);
+      }
     } else {
       emit(std::numeric_limits<std::size_t>::max());
       emit(std::numeric_limits<std::size_t>::max());
@@ -586,11 +573,22 @@ class ASTSerializer : public IRVisitor, public ExpressionVisitor {
     if (expr) {
       emit(expr.const_value);
       emit(expr.atomic);
+      // Expressions are often shared (e.g. loop indices and fields), so each
+      // one is hashed once and then referred to by its digest.
       auto *e = expr.expr.get();
-      emit(e->get_flattened_stmt());
-      emit(e->attributes);
-      emit(e->ret_type);
-      expr.expr->accept(this);
+      auto iter = expr_hashes_.find(e);
+      if (iter == expr_hashes_.end()) {
+        Hash128Builder hasher;
+        auto *parent_hasher = hasher_;
+        hasher_ = &hasher;
+        emit(e->get_flattened_stmt());
+        emit(e->attributes);
+        emit(e->ret_type);
+        e->accept(this);
+        hasher_ = parent_hasher;
+        iter = expr_hashes_.insert({e, hasher.finish()}).first;
+      }
+      hasher_->update(iter->second);
     } else {
       emit(ExprOpCode::NIL);
     }
@@ -662,17 +660,17 @@ class ASTSerializer : public IRVisitor, public ExpressionVisitor {
 
 #undef DEFINE_EMIT_ENUM
 
-  std::ostream *os_{nullptr};
+  Hash128Builder *hasher_{nullptr};
   std::vector<const SNode *> snode_tree_roots_;
-  std::unordered_map<const SNode *, std::string> snode_key_cache_;
+  std::unordered_set<const SNode *> snode_tree_root_set_;
+  std::unordered_map<const Expression *, Hash128> expr_hashes_;
   std::map<Function *, std::size_t> real_funcs_;
-  std::vector<char> string_pool_;
 };
 
 }  // namespace
 
-void gen_offline_cache_key(IRNode *ast, std::ostream *os) {
-  ASTSerializer::run(ast, os);
+Hash128 gen_offline_cache_key(IRNode *ast) {
+  return ASTSerializer::run(ast);
 }
 
 }  // namespace taichi::lang
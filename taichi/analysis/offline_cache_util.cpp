@@ -8,8 +8,7 @@
 #include "taichi/program/kernel.h"
 #include "taichi/rhi/device_capability.h"
 
-#include "picosha2.h"
-
+#include <mutex>
 #include <vector>
 
 namespace taichi::lang {
@@ -65,6 +64,8 @@ static std::vector<std::uint8_t> get_offline_cache_key_of_compile_config(
   }
   serializer(config.ad_stack_size);
   serializer(config.default_ad_stack_size);
+  serializer(config.ad_checkpointing);
+  serializer(config.ad_block_local_adjoints);
   serializer(config.random_seed);
   if (config.arch == Arch::opengl || config.arch == Arch::gles) {
     serializer(config.allow_nv_shader_extension);
@@ -80,6 +81,11 @@ static std::vector<std::uint8_t> get_offline_cache_key_of_compile_config(
   serializer(config.real_matrix_scalarize);
   serializer(config.force_scalarize_matrix);
   serializer(config.half2_vectorization);
+  serializer(config.slp_vectorization);
+  serializer(config.cpu_loop_tiling);
+  serializer(config.cpu_loop_tile_size);
+  serializer(config.offload_fusion);
+  serializer(config.listgen_reuse);
   serializer.finalize();
 
   return serializer.data;
@@ -145,13 +151,24 @@ static void get_offline_cache_key_of_snode_impl(
   serializer(snode->is_path_all_dense);
   serializer(snode->node_type_name);
   serializer(snode->type);
-  serializer(snode->_morton);
+  serializer(snode->morton_bits);
   serializer(snode->get_snode_tree_id());
 }
 
 std::string get_hashed_offline_cache_key_of_snode(const SNode *snode) {
   TI_ASSERT(snode);
 
+  // Kernels only refer to materialized trees, which no longer change, so the
+  // key of a root is computed once and shared by all kernels using the tree.
+  static std::mutex memo_mut;
+  const bool is_root = snode->parent == nullptr;
+  if (is_root) {
+    std::lock_guard<std::mutex> _(memo_mut);
+    if (!snode->offline_cache_key_of_tree.empty()) {
+      return snode->offline_cache_key_of_tree;
+    }
+  }
+
   BinaryOutputSerializer serializer;
   serializer.initialize();
   {
@@ -160,41 +177,47 @@ std::string get_hashed_offline_cache_key_of_snode(const SNode *snode) {
   }
   serializer.finalize();
 
-  picosha2::hash256_one_by_one hasher;
-  hasher.process(serializer.data.begin(), serializer.data.end());
-  hasher.finish();
-
-  return picosha2::get_hash_hex_string(hasher);
+  Hash128Builder hasher;
+  hasher.update(serializer.data.data(), serializer.data.size());
+  auto key = hasher.finish().to_hex();
+  if (is_root) {
+    std::lock_guard<std::mutex> _(memo_mut);
+    snode->offline_cache_key_of_tree = key;
+  }
+  return key;
 }
 
 std::string get_hashed_offline_cache_key(const CompileConfig &config,
                                          const DeviceCapabilityConfig &caps,
                                          Kernel *kernel) {
   std::vector<std::uint8_t> kernel_params_string, kernel_rets_string;
-  std::string kernel_body_string;
+  Hash128 kernel_body_hash;
   if (kernel) {  // param_list, rets, body
     kernel_params_string =
         get_offline_cache_key_of_parameter_list(kernel->parameter_list);
     kernel_rets_string = get_offline_cache_key_of_rets(kernel->rets);
-    std::ostringstream oss;
-    gen_offline_cache_key(kernel->ir.get(), &oss);
-    kernel_body_string = oss.str();
+    kernel_body_hash = gen_offline_cache_key(kernel->ir.get());
   }
 
   auto compile_config_key = get_offline_cache_key_of_compile_config(config);
   auto device_caps_key = get_offline_cache_key_of_device_caps(caps);
   std::string autodiff_mode =
       std::to_string(static_cast<std::size_t>(kernel->autodiff_mode));
-  picosha2::hash256_one_by_one hasher;
-  hasher.process(compile_config_key.begin(), compile_config_key.end());
-  hasher.process(device_caps_key.begin(), device_caps_key.end());
-  hasher.process(kernel_params_string.begin(), kernel_params_string.end());
-  hasher.process(kernel_rets_string.begin(), kernel_rets_string.end());
-  hasher.process(kernel_body_string.begin(), kernel_body_string.end());
-  hasher.process(autodiff_mode.begin(), autodiff_mode.end());
-  hasher.finish();
-
-  auto res = picosha2::get_hash_hex_string(hasher);
+  // Each part is prefixed by its size, so that parts cannot run into each
+  // other.
+  Hash128Builder hasher;
+  auto update = [&](const auto &bytes) {
+    hasher.update_pod(static_cast<std::uint64_t>(bytes.size()));
+    hasher.update(bytes.data(), bytes.size());
+  };
+  update(compile_config_key);
+  update(device_caps_key);
+  update(kernel_params_string);
+  update(kernel_rets_string);
+  hasher.update(kernel_body_hash);
+  update(autodiff_mode);
+
+  auto res = hasher.finish().to_hex();
   res.insert(res.begin(), 'T');  // The key must start with a letter
   return res;
 }
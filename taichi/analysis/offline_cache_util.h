@@ -3,6 +3,7 @@
 #include <string>
 
 #include "taichi/rhi/arch.h"
+#include "taichi/util/hash128.h"
 
 namespace taichi::lang {
 
@@ -13,10 +14,14 @@ class IRNode;
 class SNode;
 class Kernel;
 
+// Memoized for a whole materialized SNode tree (i.e. |snode| is its root).
 std::string get_hashed_offline_cache_key_of_snode(const SNode *snode);
+// 'T' followed by the 32 hex digits of a 128-bit hash.
 std::string get_hashed_offline_cache_key(const CompileConfig &config,
                                          const DeviceCapabilityConfig &caps,
                                          Kernel *kernel);
-void gen_offline_cache_key(IRNode *ast, std::ostream *os);
+// Structural hash of a frontend AST, including the real functions and SNode
+// trees it refers to.
+Hash128 gen_offline_cache_key(IRNode *ast);
 
 }  // namespace taichi::lang
@@ -1,4 +1,5 @@
 #pragma once
+#include <memory>
 #include <vector>
 #include <string>
 #include <unordered_map>
@@ -165,6 +166,9 @@ struct CompiledDispatch {
 struct TI_DLL_EXPORT CompiledGraph {
   std::vector<CompiledDispatch> dispatches;
   std::unordered_map<std::string, aot::Arg> args;
+  // Kernels created by GraphBuilder::compile() that fuse several dispatches.
+  // Not serialized: AOT modules store their compiled code by kernel name.
+  std::vector<std::shared_ptr<taichi::lang::Kernel>> fused_kernels;
 
   void run(const std::unordered_map<std::string, IValue> &args) const;
   void jit_run(const CompileConfig &compile_config,
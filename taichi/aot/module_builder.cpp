@@ -7,6 +7,19 @@ void AotModuleBuilder::add(const std::string &identifier, Kernel *kernel) {
   add_per_backend(identifier, kernel);
 }
 
+void AotModuleBuilder::add_kernels(
+    const std::vector<std::pair<std::string, Kernel *>> &kernels) {
+  std::vector<Kernel *> kernel_defs;
+  kernel_defs.reserve(kernels.size());
+  for (const auto &[_, kernel] : kernels) {
+    kernel_defs.push_back(kernel);
+  }
+  precompile_per_backend(kernel_defs);
+  for (const auto &[identifier, kernel] : kernels) {
+    add_per_backend(identifier, kernel);
+  }
+}
+
 void AotModuleBuilder::add_field(const std::string &identifier,
                                  const SNode *rep_snode,
                                  bool is_scalar,
@@ -60,9 +73,7 @@ void AotModuleBuilder::add_graph(const std::string &name,
   for (const auto &dispatch : graph.dispatches) {
     kernels[dispatch.kernel_name] = dispatch.ti_kernel;
   }
-  for (auto &e : kernels) {
-    add(e.first, e.second);
-  }
+  add_kernels({kernels.begin(), kernels.end()});
   graphs_[name] = graph;
 }
 }  // namespace taichi::lang
@@ -20,6 +20,11 @@ class AotModuleBuilder {
 
   void add(const std::string &identifier, Kernel *kernel);
 
+  // Same as calling add() for each kernel, but lets the backend compile the
+  // kernels concurrently first.
+  void add_kernels(
+      const std::vector<std::pair<std::string, Kernel *>> &kernels);
+
   void add_field(const std::string &identifier,
                  const SNode *rep_snode,
                  bool is_scalar,
@@ -45,6 +50,10 @@ class AotModuleBuilder {
    */
   virtual void add_per_backend(const std::string &identifier,
                                Kernel *kernel) = 0;
+  // Compiles |kernels| ahead of add_per_backend(), e.g. in parallel. No-op by
+  // default.
+  virtual void precompile_per_backend(const std::vector<Kernel *> &kernels) {
+  }
   virtual void add_field_per_backend(const std::string &identifier,
                                      const SNode *rep_snode,
                                      bool is_scalar,
@@ -2,6 +2,9 @@
 
 #include "codegen.h"
 
+#include <future>
+
+
 #if defined(TI_WITH_LLVM)
 #include "taichi/codegen/cpu/codegen_cpu.h"
 #include "taichi/runtime/llvm/llvm_offline_cache.h"
@@ -16,8 +19,10 @@
 #if defined(TI_WITH_AMDGPU)
 #include "taichi/codegen/amdgpu/codegen_amdgpu.h"
 #endif
+#include "taichi/system/compile_profiler.h"
 #include "taichi/system/timer.h"
 #include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
 #include "taichi/ir/transforms.h"
 #include "taichi/analysis/offline_cache_util.h"
 
@@ -76,28 +81,73 @@ std::unique_ptr<KernelCodeGen> KernelCodeGen::create(
 
 LLVMCompiledKernel KernelCodeGen::compile_kernel_to_module() {
   auto block = dynamic_cast<Block *>(ir);
-  auto &worker = get_llvm_program(kernel->program)->compilation_workers;
+  auto *llvm_prog = get_llvm_program(kernel->program);
+  auto &worker = llvm_prog->compilation_workers;
+  auto *task_cache =
+      compile_config_.llvm_task_cache ? &llvm_prog->task_cache : nullptr;
   TI_ASSERT(block);
 
   auto &offloads = block->statements;
   std::vector<std::unique_ptr<LLVMCompiledTask>> data(offloads.size());
+  std::vector<std::future<void>> compiled;
   for (int i = 0; i < offloads.size(); i++) {
     auto compile_func = [&, i] {
       tlctx_.fetch_this_thread_struct_module();
       auto offload = irpass::analysis::clone(offloads[i].get());
       irpass::re_id(offload.get());
 
+      std::optional<Hash128> key;
+      std::unique_ptr<Stmt> uncompiled;
+      if (task_cache) {
+        auto *stmt = offload->as<OffloadedStmt>();
+        key = LLVMTaskCache::make_key(kernel, stmt);
+        if (key) {
+          CompileProfiler::Scope _(kernel->get_name(), stmt->task_name(),
+                                   "load_cached_task");
+          if (auto cached =
+                  task_cache->try_load(*key, stmt, kernel, i, tlctx_)) {
+            data[i] = std::make_unique<LLVMCompiledTask>(std::move(*cached));
+            return;
+          }
+          uncompiled = irpass::analysis::clone(stmt);
+        }
+      }
+
       Block blk;
       blk.insert(std::move(offload));
       auto new_data = this->compile_task(i, compile_config_, nullptr, &blk);
+      if (key) {
+        task_cache->store(*key,
+                          std::unique_ptr<OffloadedStmt>(
+                              uncompiled.release()->as<OffloadedStmt>()),
+                          kernel, i, new_data);
+      }
       data[i] = std::make_unique<LLVMCompiledTask>(std::move(new_data));
     };
-    worker.enqueue(compile_func);
+    // The workers are shared between kernels that are compiled
+    // concurrently, so wait for the tasks of this kernel only.
+    auto task = std::make_shared<std::packaged_task<void()>>(compile_func);
+    compiled.push_back(task->get_future());
+    worker.enqueue([task] { (*task)(); });
+  }
+  // Wait for all of them before rethrowing, as the tasks refer to |data|.
+  for (auto &future : compiled) {
+    future.wait();
+  }
+  for (auto &future : compiled) {
+    future.get();
   }
-  worker.flush();
 
-  auto llvm_compiled_kernel = tlctx_.link_compiled_tasks(std::move(data));
-  optimize_module(llvm_compiled_kernel.module.get());
+  const auto name = kernel->get_name();
+  LLVMCompiledKernel llvm_compiled_kernel;
+  {
+    CompileProfiler::Scope _(name, "", "link");
+    llvm_compiled_kernel = tlctx_.link_compiled_tasks(std::move(data));
+  }
+  {
+    CompileProfiler::Scope _(name, "", "llvm_optimize");
+    optimize_module(llvm_compiled_kernel.module.get());
+  }
   return llvm_compiled_kernel;
 }
 
@@ -1,4 +1,7 @@
 #include "compiled_kernel_data.h"
+
+#include <cstring>
+
 #include "taichi/common/logging.h"
 
 #include "picosha2.h"
@@ -26,14 +29,14 @@ CompiledKernelDataFile::Err CompiledKernelDataFile::dump(std::ostream &os) {
     update_hash();
     std::uint32_t arch = static_cast<std::uint32_t>(arch_);
     std::uint64_t metadata_size = metadata_.size();
-    std::uint64_t src_code_size = src_code_.size();
+    std::uint64_t src_code_size = src_code().size();
     bool io_success =
         os.write(head_, std::size(head_)) &&
         os.write((const char *)&arch, sizeof(arch)) &&
         os.write((const char *)&metadata_size, sizeof(metadata_size)) &&
         os.write((const char *)&src_code_size, sizeof(src_code_size)) &&
         os.write((const char *)metadata_.data(), metadata_size) &&
-        os.write((const char *)src_code_.data(), src_code_size) &&
+        os.write(src_code().data(), src_code_size) &&
         os.write((const char *)hash_.data(), kHashSize);
     if (!io_success) {
       return Err::kIOStreamError;
@@ -63,6 +66,7 @@ CompiledKernelDataFile::Err CompiledKernelDataFile::load(std::istream &is) {
     arch_ = static_cast<Arch>(arch);
     metadata_.resize(metadata_size);
     src_code_.resize(src_code_size);
+    src_code_ref_ = {};
     hash_.resize(kHashSize);
     io_success = is.read((char *)metadata_.data(), metadata_size) &&
                  is.read((char *)src_code_.data(), src_code_size) &&
@@ -79,10 +83,57 @@ CompiledKernelDataFile::Err CompiledKernelDataFile::load(std::istream &is) {
   return Err::kNoError;
 }
 
+CompiledKernelDataFile::Err CompiledKernelDataFile::load(const char *data,
+                                                        std::size_t size) {
+  try {
+    std::size_t pos = 0;
+    auto read = [&](void *dst, std::size_t n) {
+      if (size - pos < n) {
+        return false;
+      }
+      std::memcpy(dst, data + pos, n);
+      pos += n;
+      return true;
+    };
+    if (!read(head_, std::size(head_))) {
+      return Err::kIOStreamError;
+    } else if (std::strncmp(head_, kHeadStr, kHeadSize) != 0) {
+      return Err::kNotTicFile;
+    }
+    std::uint32_t arch;
+    std::uint64_t metadata_size;
+    std::uint64_t src_code_size;
+    if (!read(&arch, sizeof(arch)) ||
+        !read(&metadata_size, sizeof(metadata_size)) ||
+        !read(&src_code_size, sizeof(src_code_size)) ||
+        size - pos < metadata_size ||
+        size - pos - metadata_size < src_code_size) {
+      return Err::kIOStreamError;
+    }
+    arch_ = static_cast<Arch>(arch);
+    metadata_.assign(data + pos, metadata_size);
+    pos += metadata_size;
+    src_code_.clear();
+    src_code_ref_ = std::string_view(data + pos, src_code_size);
+    pos += src_code_size;
+    hash_.resize(kHashSize);
+    if (!read(hash_.data(), kHashSize)) {
+      return Err::kIOStreamError;
+    }
+    if (update_hash()) {
+      return Err::kCorruptedFile;
+    }
+  } catch (std::bad_alloc &) {
+    return Err::kOutOfMemory;
+  }
+  return Err::kNoError;
+}
+
 bool CompiledKernelDataFile::update_hash() {
   picosha2::hash256_one_by_one hasher;
+  const auto src_code = this->src_code();
   hasher.process(metadata_.begin(), metadata_.end());
-  hasher.process(src_code_.begin(), src_code_.end());
+  hasher.process(src_code.begin(), src_code.end());
   hasher.finish();
   auto hash = picosha2::get_hash_hex_string(hasher);
   if (hash == hash_) {
@@ -131,11 +182,27 @@ CompiledKernelData::Err CompiledKernelData::dump(std::ostream &os) const {
 // static functions
 std::unique_ptr<CompiledKernelData> CompiledKernelData::load(std::istream &is,
                                                              Err *p_err) {
+  return load_with(
+      [&](CompiledKernelDataFile &file) { return file.load(is); }, p_err);
+}
+
+std::unique_ptr<CompiledKernelData> CompiledKernelData::load(const char *data,
+                                                             std::size_t size,
+                                                             Err *p_err) {
+  return load_with(
+      [&](CompiledKernelDataFile &file) { return file.load(data, size); },
+      p_err);
+}
+
+template <typename LoadFile>
+std::unique_ptr<CompiledKernelData> CompiledKernelData::load_with(
+    const LoadFile &load_file,
+    Err *p_err) {
   Err err = Err::kNoError;
   CompiledKernelDataFile file;
   std::unique_ptr<CompiledKernelData> result{nullptr};
   try {
-    err = translate_err(file.load(is));
+    err = translate_err(load_file(file));
     if (err == Err::kNoError) {
       result = create(file.arch(), err);
     }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <memory>
 #include <optional>
 #include <algorithm>
@@ -38,6 +39,9 @@ class CompiledKernelDataFile {
 
   Err dump(std::ostream &os);
   Err load(std::istream &is);
+  // Load from memory without copying the source code, which then refers to
+  // |data| (e.g. a memory-mapped cache container) and must not outlive it.
+  Err load(const char *data, std::size_t size);
 
   CompiledKernelDataFile() {
     std::copy(kHeadStr, kHeadStr + kHeadSize, head_);
@@ -53,6 +57,7 @@ class CompiledKernelDataFile {
 
   void set_src_code(std::string src) {
     src_code_ = std::move(src);
+    src_code_ref_ = {};
   }
 
   const Arch &arch() const {
@@ -63,8 +68,8 @@ class CompiledKernelDataFile {
     return metadata_;
   }
 
-  const std::string &src_code() const {
-    return src_code_;
+  std::string_view src_code() const {
+    return src_code_ref_.data() ? src_code_ref_ : std::string_view(src_code_);
   }
 
  private:
@@ -74,6 +79,8 @@ class CompiledKernelDataFile {
   Arch arch_;
   std::string metadata_;
   std::string src_code_;
+  // Set instead of |src_code_| when loaded from memory.
+  std::string_view src_code_ref_;
   std::string hash_;
 };
 
@@ -125,6 +132,9 @@ class CompiledKernelData {
   }
 
   static std::unique_ptr<CompiledKernelData> load(std::istream &is, Err *p_err);
+  static std::unique_ptr<CompiledKernelData> load(const char *data,
+                                                  std::size_t size,
+                                                  Err *p_err);
 
   static std::string get_err_msg(Err err);
 
@@ -139,6 +149,11 @@ class CompiledKernelData {
 
   static std::unique_ptr<CompiledKernelData> create(Arch arch, Err &err);
 
+  template <typename LoadFile>
+  static std::unique_ptr<CompiledKernelData> load_with(
+      const LoadFile &load_file,
+      Err *p_err);
+
   mutable std::optional<KernelLaunchHandle> kernel_launch_handle_;
 };
 
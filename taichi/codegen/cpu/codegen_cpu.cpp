@@ -147,26 +147,21 @@ class TaskCodeGenCPU : public TaskCodeGenLLVM {
          tlctx->get_constant(stmt->tls_size));
   }
 
-  void create_bls_buffer(OffloadedStmt *stmt) {
-    auto type = llvm::ArrayType::get(llvm::Type::getInt8Ty(*llvm_context),
-                                     stmt->bls_size);
-    bls_buffer = new llvm::GlobalVariable(
-        *module, type, false, llvm::GlobalValue::ExternalLinkage, nullptr,
-        "bls_buffer", nullptr, llvm::GlobalVariable::LocalExecTLSModel, 0);
-    /* module->getOrInsertGlobal("bls_buffer", type);
-    bls_buffer = module->getNamedGlobal("bls_buffer");
-    bls_buffer->setAlignment(llvm::MaybeAlign(8));*/ // TODO(changyu): Fix JIT session error: Symbols not found: [ __emutls_get_address ] in python 3.10
-
-    // initialize the variable with an undef value to ensure it is added to the
-    // symbol table
-    bls_buffer->setInitializer(llvm::UndefValue::get(type));
+  void visit(BlockLocalPtrStmt *stmt) override {
+    // A block is processed by a single thread on CPU, which runs the BLS
+    // prologue, the loop body and the BLS epilogue in one task function. So
+    // the BLS buffer is just a stack array of that function.
+    if (bls_buffer == nullptr) {
+      auto type = llvm::ArrayType::get(llvm::Type::getInt8Ty(*llvm_context),
+                                       current_offload->bls_size);
+      bls_buffer = create_entry_block_alloca(type, /*alignment=*/8);
+    }
+    TaskCodeGenLLVM::visit(stmt);
   }
 
   void visit(OffloadedStmt *stmt) override {
     TI_ASSERT(current_offload == nullptr);
     current_offload = stmt;
-    if (stmt->bls_size > 0)
-      create_bls_buffer(stmt);
     using Type = OffloadedStmt::TaskType;
     auto offloaded_task_name = init_offloaded_task_function(stmt);
     if (compile_config.kernel_profiler && arch_is_cpu(compile_config.arch)) {
@@ -186,7 +181,15 @@ class TaskCodeGenCPU : public TaskCodeGenLLVM {
     } else if (stmt->task_type == Type::listgen) {
       emit_list_gen(stmt);
     } else if (stmt->task_type == Type::gc) {
-      emit_gc(stmt);
+      if (stmt->snode->type == SNodeType::hash) {
+        call("node_gc_hash", get_runtime(),
+             cast_pointer(emit_struct_meta(stmt->snode->parent), "StructMeta"),
+             cast_pointer(emit_struct_meta(stmt->snode), "StructMeta"));
+      }
+      // Recycle on the thread pool instead of node_gc's serial loop
+      call("node_gc_cpu_parallel", get_runtime(),
+           tlctx->get_constant(stmt->snode->id),
+           tlctx->get_constant(compile_config.cpu_max_num_threads));
     } else {
       TI_NOT_IMPLEMENTED
     }
@@ -199,6 +202,7 @@ class TaskCodeGenCPU : public TaskCodeGenLLVM {
     offloaded_tasks.push_back(*current_task);
     current_task = nullptr;
     current_offload = nullptr;
+    bls_buffer = nullptr;
   }
 
   void visit(ExternalFuncCallStmt *stmt) override {
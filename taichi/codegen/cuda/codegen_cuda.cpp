@@ -637,11 +637,12 @@ class TaskCodeGenCUDA : public TaskCodeGenLLVM {
   void create_bls_buffer(OffloadedStmt *stmt) {
     auto type = llvm::ArrayType::get(llvm::Type::getInt8Ty(*llvm_context),
                                      stmt->bls_size);
-    bls_buffer = new GlobalVariable(
+    auto buffer = new GlobalVariable(
         *module, type, false, llvm::GlobalValue::ExternalLinkage, nullptr,
         "bls_buffer", nullptr, llvm::GlobalVariable::NotThreadLocal,
         3 /*addrspace=shared*/);
-    bls_buffer->setAlignment(llvm::MaybeAlign(8));
+    buffer->setAlignment(llvm::MaybeAlign(8));
+    bls_buffer = buffer;
   }
 
   void visit(OffloadedStmt *stmt) override {
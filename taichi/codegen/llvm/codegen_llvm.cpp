@@ -13,6 +13,7 @@
 #include "taichi/program/extension.h"
 #include "taichi/runtime/program_impls/llvm/llvm_program.h"
 #include "taichi/codegen/llvm/struct_llvm.h"
+#include "taichi/system/compile_profiler.h"
 #include "taichi/util/file_sequence_writer.h"
 #include "taichi/codegen/codegen_utils.h"
 
@@ -231,10 +232,14 @@ std::unique_ptr<RuntimeObject> TaskCodeGenLLVM::emit_struct_meta_object(
   if (snode->type == SNodeType::dense) {
     meta = std::make_unique<RuntimeObject>("DenseMeta", this, builder.get());
     emit_struct_meta_base("Dense", meta->ptr, snode);
-    meta->call("set_morton_dim", tlctx->get_constant((int)snode->_morton));
+    meta->call("set_morton_bits", tlctx->get_constant(snode->morton_bits));
   } else if (snode->type == SNodeType::pointer) {
     meta = std::make_unique<RuntimeObject>("PointerMeta", this, builder.get());
     emit_struct_meta_base("Pointer", meta->ptr, snode);
+  } else if (snode->type == SNodeType::hash) {
+    meta = std::make_unique<RuntimeObject>("HashMeta", this, builder.get());
+    emit_struct_meta_base("Hash", meta->ptr, snode);
+    meta->call("set_capacity", tlctx->get_constant(snode->chunk_size));
   } else if (snode->type == SNodeType::root) {
     meta = std::make_unique<RuntimeObject>("RootMeta", this, builder.get());
     emit_struct_meta_base("Root", meta->ptr, snode);
@@ -242,6 +247,10 @@ std::unique_ptr<RuntimeObject> TaskCodeGenLLVM::emit_struct_meta_object(
     meta = std::make_unique<RuntimeObject>("DynamicMeta", this, builder.get());
     emit_struct_meta_base("Dynamic", meta->ptr, snode);
     meta->call("set_chunk_size", tlctx->get_constant(snode->chunk_size));
+    meta->call("set_page_bits",
+               tlctx->get_constant(snode->dynamic_page_bits()));
+    meta->call("set_directory_depth",
+               tlctx->get_constant(snode->dynamic_directory_depth()));
   } else if (snode->type == SNodeType::bitmasked) {
     meta =
         std::make_unique<RuntimeObject>("BitmaskedMeta", this, builder.get());
@@ -266,7 +275,8 @@ void TaskCodeGenLLVM::emit_struct_meta_base(const std::string &name,
         StructCompilerLLVM::get_llvm_body_type(module.get(), snode);
     auto element_ty = body_type->getArrayElementType();
     element_size = tlctx->get_type_size(element_ty);
-  } else if (snode->type == SNodeType::pointer) {
+  } else if (snode->type == SNodeType::pointer ||
+             snode->type == SNodeType::hash) {
     auto element_ty = StructCompilerLLVM::get_llvm_node_type(
         module.get(), snode->ch[0].get());
     element_size = tlctx->get_type_size(element_ty);
@@ -1138,12 +1148,18 @@ void TaskCodeGenLLVM::emit_list_gen(OffloadedStmt *listgen) {
   auto snode_parent = listgen->snode->parent;
   auto meta_child = cast_pointer(emit_struct_meta(snode_child), "StructMeta");
   auto meta_parent = cast_pointer(emit_struct_meta(snode_parent), "StructMeta");
-  if (snode_parent->type == SNodeType::root) {
+  auto num_threads = tlctx->get_constant(compile_config.cpu_max_num_threads);
+  if (snode_child->type == SNodeType::hash) {
+    // Only the active slots of the table are listed.
+    call("element_listgen_hash", get_runtime(), meta_parent, meta_child,
+         num_threads);
+  } else if (snode_parent->type == SNodeType::root) {
     // Since there's only one container to expand, we need a special kernel for
     // more parallelism.
     call("element_listgen_root", get_runtime(), meta_parent, meta_child);
   } else {
-    call("element_listgen_nonroot", get_runtime(), meta_parent, meta_child);
+    call("element_listgen_nonroot", get_runtime(), meta_parent, meta_child,
+         num_threads);
   }
 }
 
@@ -1806,6 +1822,7 @@ void TaskCodeGenLLVM::visit(SNodeLookupStmt *stmt) {
         builder->CreateGEP(parent_ty, parent, llvm_val[stmt->input_index]);
   } else if (snode->type == SNodeType::dense ||
              snode->type == SNodeType::pointer ||
+             snode->type == SNodeType::hash ||
              snode->type == SNodeType::dynamic ||
              snode->type == SNodeType::bitmasked) {
     if (stmt->activate) {
@@ -2247,7 +2264,8 @@ void TaskCodeGenLLVM::create_offload_struct_for(OffloadedStmt *stmt) {
                                       builder.get(), new_coordinates);
 
     if (leaf_block->type == SNodeType::bitmasked ||
-        leaf_block->type == SNodeType::pointer) {
+        leaf_block->type == SNodeType::pointer ||
+        leaf_block->type == SNodeType::hash) {
       // test whether the current voxel is active or not
       auto is_active = call(leaf_block, element.get("element"), "is_active",
                             {builder->CreateLoad(loop_index_ty, loop_index)});
@@ -2289,6 +2307,10 @@ void TaskCodeGenLLVM::create_offload_struct_for(OffloadedStmt *stmt) {
 
   int list_element_size = std::min(leaf_block->max_num_elements(),
                                    (int64)taichi_listgen_max_element_size);
+  if (leaf_block->type == SNodeType::hash) {
+    // See element_listgen_hash.
+    list_element_size = 1;
+  }
   int num_splits = std::max(1, list_element_size / stmt->block_dim +
                                    (list_element_size % stmt->block_dim != 0));
 
@@ -2402,8 +2424,10 @@ void TaskCodeGenLLVM::visit(ThreadLocalPtrStmt *stmt) {
 void TaskCodeGenLLVM::visit(BlockLocalPtrStmt *stmt) {
   TI_ASSERT(bls_buffer);
   auto base = bls_buffer;
+  auto base_type = llvm::ArrayType::get(llvm::Type::getInt8Ty(*llvm_context),
+                                        current_offload->bls_size);
   auto ptr =
-      builder->CreateGEP(base->getValueType(), base,
+      builder->CreateGEP(base_type, base,
                          {tlctx->get_constant(0), llvm_val[stmt->offset]});
   auto ptr_type = llvm::PointerType::get(
       tlctx->get_data_type(stmt->ret_type.ptr_removed()), 0);
@@ -2415,7 +2439,8 @@ void TaskCodeGenLLVM::visit(ClearListStmt *stmt) {
   auto snode_parent = stmt->snode->parent;
   auto meta_child = cast_pointer(emit_struct_meta(snode_child), "StructMeta");
   auto meta_parent = cast_pointer(emit_struct_meta(snode_parent), "StructMeta");
-  call("clear_list", get_runtime(), meta_parent, meta_child);
+  call("clear_list", get_runtime(), meta_parent, meta_child,
+       tlctx->get_constant(compile_config.listgen_reuse));
 }
 
 void TaskCodeGenLLVM::visit(InternalFuncStmt *stmt) {
@@ -2723,14 +2748,24 @@ LLVMCompiledTask TaskCodeGenLLVM::run_compilation() {
         /*lower_global_access=*/true,
         /*make_thread_local=*/config.make_thread_local,
         /*make_block_local=*/
-        is_extension_supported(config.arch, Extension::bls) &&
+        (is_extension_supported(config.arch, Extension::bls) ||
+         arch_is_cpu(config.arch)) &&
             config.make_block_local);
   };
 
   offload_to_executable(ir, compile_config, kernel);
 
-  emit_to_module();
-  eliminate_unused_functions();
+  {
+    std::string task;
+    if (auto block = ir->cast<Block>(); block && block->size() == 1) {
+      if (auto offload = block->statements[0]->cast<OffloadedStmt>()) {
+        task = offload->task_name();
+      }
+    }
+    CompileProfiler::Scope _(kernel->get_name(), task, "codegen");
+    emit_to_module();
+    eliminate_unused_functions();
+  }
 
   if (compile_config.arch == Arch::cuda) {
     // CUDA specific metadata
@@ -43,7 +43,8 @@ class TaskCodeGenLLVM : public IRVisitor, public LLVMModuleBuilder {
   llvm::Value *current_coordinates;
   llvm::Value *parent_coordinates{nullptr};
   llvm::Value *block_corner_coordinates{nullptr};
-  llvm::GlobalVariable *bls_buffer{nullptr};
+  // Shared memory on GPUs, a stack array of the task function on CPUs
+  llvm::Value *bls_buffer{nullptr};
   // Mainly for supporting continue stmt
   llvm::BasicBlock *current_loop_reentry;
   // Mainly for supporting break stmt
@@ -53,7 +53,9 @@ CompiledKernelData::Err CompiledKernelData::load_impl(
     return Err::kParseMetadataFailed;
   }
   llvm::SMDiagnostic err;
-  auto ret = llvm::parseAssemblyString(file.src_code(), err, llvm_ctx_);
+  const auto src_code = file.src_code();
+  auto ret = llvm::parseAssemblyString(
+      llvm::StringRef(src_code.data(), src_code.size()), err, llvm_ctx_);
   if (!ret) {  // File not found or Parse failed
     TI_DEBUG("Fail to parse llvm::Module from string: {}",
              err.getMessage().str());
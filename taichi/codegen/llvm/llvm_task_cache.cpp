@@ -0,0 +1,153 @@
+#include "taichi/codegen/llvm/llvm_task_cache.h"
+
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Support/raw_ostream.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/program/kernel.h"
+#include "taichi/runtime/llvm/llvm_context.h"
+
+namespace taichi::lang {
+
+std::optional<Hash128> LLVMTaskCache::make_key(const Kernel *kernel,
+                                               OffloadedStmt *offload) {
+  // Blocks other than the body are not compared by same_statements, and
+  // mesh-fors keep their mesh information outside of the statement fields.
+  if (offload->task_type == OffloadedTaskType::mesh_for ||
+      offload->tls_prologue || offload->mesh_prologue ||
+      offload->bls_prologue || offload->bls_epilogue ||
+      offload->tls_epilogue) {
+    return std::nullopt;
+  }
+  // Calls are compiled together with their callee, which is not part of the
+  // task IR.
+  auto calls = irpass::analysis::gather_statements(offload, [](Stmt *stmt) {
+    return stmt->is<FuncCallStmt>() || stmt->is<ExternalFuncCallStmt>();
+  });
+  if (!calls.empty() || !kernel->argpack_types.empty()) {
+    return std::nullopt;
+  }
+
+  Hash128Builder hasher;
+  auto update = [&](const std::string &str) {
+    hasher.update_pod(static_cast<std::uint64_t>(str.size()));
+    hasher.update(str.data(), str.size());
+  };
+  std::string ir;
+  irpass::print(offload, &ir);
+  update(ir);
+  // The codegen of arguments and return values depends on the kernel.
+  update(kernel->args_type ? kernel->args_type->to_string() : "");
+  update(kernel->ret_type ? kernel->ret_type->to_string() : "");
+  hasher.update_pod(kernel->autodiff_mode);
+  return hasher.finish();
+}
+
+std::string LLVMTaskCache::get_task_name_prefix(const Kernel *kernel,
+                                                int task_codegen_id) {
+  // See TaskCodeGenLLVM::init_offloaded_task_function
+  return fmt::format("{}_kernel_{}_", kernel->name, task_codegen_id);
+}
+
+std::optional<LLVMCompiledTask> LLVMTaskCache::try_load(
+    const Hash128 &key,
+    OffloadedStmt *offload,
+    const Kernel *kernel,
+    int task_codegen_id,
+    TaichiLLVMContext &tlctx) {
+  std::string bitcode;
+  std::string name_prefix;
+  LLVMCompiledTask task;
+  {
+    std::lock_guard<std::mutex> _(mut_);
+    auto iter = entries_.find(key);
+    if (iter == entries_.end()) {
+      return std::nullopt;
+    }
+    const Entry *found = nullptr;
+    for (const auto &entry : iter->second) {
+      if (irpass::analysis::same_statements(offload, entry.offload.get())) {
+        found = &entry;
+        break;
+      }
+    }
+    if (!found) {
+      return std::nullopt;
+    }
+    bitcode = found->bitcode;
+    name_prefix = found->name_prefix;
+    task.tasks = found->tasks;
+    task.used_tree_ids = found->used_tree_ids;
+    task.struct_for_tls_sizes = found->struct_for_tls_sizes;
+  }
+
+  auto module = llvm::parseBitcodeFile(
+      llvm::MemoryBufferRef(bitcode, "cached_task"),
+      *tlctx.get_this_thread_context());
+  if (!module) {
+    llvm::consumeError(module.takeError());
+    TI_WARN("Failed to load the cached LLVM module of a task");
+    return std::nullopt;
+  }
+  task.module = std::move(module.get());
+
+  const auto new_prefix = get_task_name_prefix(kernel, task_codegen_id);
+  for (auto &t : task.tasks) {
+    auto new_name = new_prefix + t.name.substr(name_prefix.size());
+    auto *func = task.module->getFunction(t.name);
+    TI_ASSERT(func);
+    func->setName(new_name);
+    t.name = std::move(new_name);
+  }
+  return task;
+}
+
+void LLVMTaskCache::store(const Hash128 &key,
+                          std::unique_ptr<OffloadedStmt> offload,
+                          const Kernel *kernel,
+                          int task_codegen_id,
+                          const LLVMCompiledTask &task) {
+  Entry entry;
+  entry.name_prefix = get_task_name_prefix(kernel, task_codegen_id);
+  for (const auto &t : task.tasks) {
+    if (!starts_with(t.name, entry.name_prefix)) {
+      return;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> _(mut_);
+    if (num_entries_ >= kMaxEntries) {
+      return;
+    }
+  }
+  // The module belongs to the calling thread's context.
+  llvm::raw_string_ostream os(entry.bitcode);
+  llvm::WriteBitcodeToFile(*task.module, os);
+  os.flush();
+  entry.offload = std::move(offload);
+  entry.tasks = task.tasks;
+  entry.used_tree_ids = task.used_tree_ids;
+  entry.struct_for_tls_sizes = task.struct_for_tls_sizes;
+
+  std::lock_guard<std::mutex> _(mut_);
+  if (num_entries_ >= kMaxEntries) {
+    return;
+  }
+  entries_[key].push_back(std::move(entry));
+  num_entries_++;
+}
+
+void LLVMTaskCache::clear() {
+  std::lock_guard<std::mutex> _(mut_);
+  entries_.clear();
+  num_entries_ = 0;
+}
+
+std::size_t LLVMTaskCache::size() {
+  std::lock_guard<std::mutex> _(mut_);
+  return num_entries_;
+}
+
+}  // namespace taichi::lang
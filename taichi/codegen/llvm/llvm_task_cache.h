@@ -0,0 +1,87 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "taichi/codegen/llvm/llvm_compiled_data.h"
+#include "taichi/ir/ir.h"
+#include "taichi/util/hash128.h"
+
+namespace taichi::lang {
+
+class Kernel;
+class OffloadedStmt;
+class TaichiLLVMContext;
+
+// Shares the generated LLVM code of offloaded tasks between kernels.
+//
+// Instantiations of the same template often lower to some identical tasks
+// (e.g. the listgen tasks of a struct-for, or a sub-step that does not depend
+// on the template arguments). Such a task is only lowered by
+// offload_to_executable and generated once; later kernels get a copy of its
+// unoptimized module with the task functions renamed, and link and optimize
+// it as usual.
+//
+// Tasks are looked up by a hash of their IR and confirmed with
+// irpass::analysis::same_statements, so a hash collision never shares code.
+class LLVMTaskCache {
+ public:
+  // Returns std::nullopt for tasks that must not be shared, e.g. tasks that
+  // call real functions. |offload| must have been re_id'ed.
+  static std::optional<Hash128> make_key(const Kernel *kernel,
+                                         OffloadedStmt *offload);
+
+  // The task compiled earlier for the same key and identical IR, renamed to
+  // the names TaskCodeGenLLVM would give it as task |task_codegen_id| of
+  // |kernel|. The module lives in the calling thread's context.
+  std::optional<LLVMCompiledTask> try_load(const Hash128 &key,
+                                           OffloadedStmt *offload,
+                                           const Kernel *kernel,
+                                           int task_codegen_id,
+                                           TaichiLLVMContext &tlctx);
+
+  // |offload| is the IR before it was compiled to |task|.
+  void store(const Hash128 &key,
+             std::unique_ptr<OffloadedStmt> offload,
+             const Kernel *kernel,
+             int task_codegen_id,
+             const LLVMCompiledTask &task);
+
+  // Must be called when a SNode tree is destroyed, since the ids of its
+  // SNodes may be reused.
+  void clear();
+
+  std::size_t size();
+
+  static constexpr std::size_t kMaxEntries = 4096;
+
+ private:
+  struct Entry {
+    std::unique_ptr<OffloadedStmt> offload;
+    // Prefix of the task function names, see get_task_name_prefix().
+    std::string name_prefix;
+    std::string bitcode;
+    std::vector<OffloadedTask> tasks;
+    std::unordered_set<int> used_tree_ids;
+    std::unordered_set<int> struct_for_tls_sizes;
+  };
+
+  struct HashOfHash128 {
+    std::size_t operator()(const Hash128 &hash) const {
+      return hash.lo;
+    }
+  };
+
+  static std::string get_task_name_prefix(const Kernel *kernel,
+                                          int task_codegen_id);
+
+  std::mutex mut_;
+  std::unordered_map<Hash128, std::vector<Entry>, HashOfHash128> entries_;
+  std::size_t num_entries_{0};
+};
+
+}  // namespace taichi::lang
@@ -68,7 +68,6 @@ void StructCompilerLLVM::generate_types(SNode &snode) {
 
   llvm::Type *body_type = nullptr, *aux_type = nullptr;
   if (type == SNodeType::dense || type == SNodeType::bitmasked) {
-    TI_ASSERT(snode._morton == false);
     body_type = llvm::ArrayType::get(ch_type, snode.max_num_elements());
     if (type == SNodeType::bitmasked) {
       aux_type = llvm::ArrayType::get(llvm::Type::getInt32Ty(*llvm_ctx_),
@@ -106,12 +105,22 @@ void StructCompilerLLVM::generate_types(SNode &snode) {
                                     snode.max_num_elements());
     body_type = llvm::ArrayType::get(llvm::PointerType::getInt8PtrTy(*ctx),
                                      snode.max_num_elements());
+  } else if (type == SNodeType::hash) {
+    TI_ERROR_IF(!arch_is_cpu(arch_),
+                "hash SNodes are only supported on CPU backends.");
+    // key and mutex of each slot, see node_hash.h
+    aux_type = llvm::ArrayType::get(llvm::Type::getInt64Ty(*ctx),
+                                    snode.chunk_size);
+    body_type = llvm::ArrayType::get(llvm::PointerType::getInt8PtrTy(*ctx),
+                                     snode.chunk_size);
   } else if (type == SNodeType::dynamic) {
     // mutex and n (number of elements)
     aux_type =
         llvm::StructType::get(*ctx, {llvm::PointerType::getInt32Ty(*ctx),
                                      llvm::PointerType::getInt32Ty(*ctx)});
-    body_type = llvm::PointerType::getInt8PtrTy(*ctx);
+    // root of the chunk directory, see node_dynamic.h
+    body_type = llvm::ArrayType::get(llvm::PointerType::getInt8PtrTy(*ctx),
+                                     snode.dynamic_num_root_entries());
   } else {
     TI_P(snode.type_name());
     TI_NOT_IMPLEMENTED;
@@ -168,9 +177,53 @@ void StructCompilerLLVM::generate_refine_coordinates(SNode *snode) {
   auto outp_coords = args[1];
   auto l = args[2];
 
+  // Morton layouts: bricks of 2^m cells per axis in row-major order, and
+  // Z-order within a brick (see ScalarPointerLowerer).
+  const int m = snode->morton_bits;
+  int d = 0;
   for (int i = 0; i < taichi_max_num_indices; i++) {
+    d += (int)snode->extractors[i].active;
+  }
+  const auto steps = SNode::morton_dilation_steps(m, d);
+  const int low_bits = (1 << m) - 1;
+  llvm::Value *code = nullptr, *brick = nullptr;
+  if (m > 0) {
+    code = builder.CreateAnd(l, tlctx_->get_constant((1 << (m * d)) - 1));
+    brick = builder.CreateLShr(l, tlctx_->get_constant(m * d));
+  }
+
+  for (int i = 0, q = 0; i < taichi_max_num_indices; i++) {
     auto addition = tlctx_->get_constant(0);
-    if (snode->extractors[i].shape > 1) {
+    if (m > 0 && snode->extractors[i].active) {
+      // The number of active axes after this one.
+      const int num_minor_axes = d - 1 - q++;
+      auto bits = code;
+      if (num_minor_axes > 0) {
+        bits = builder.CreateLShr(bits, tlctx_->get_constant(num_minor_axes));
+      }
+      bits = builder.CreateAnd(
+          bits, tlctx_->get_constant(steps.empty() ? low_bits
+                                                   : steps.back().second));
+      for (int s = (int)steps.size() - 1; s >= 0; s--) {
+        auto shifted =
+            builder.CreateLShr(bits, tlctx_->get_constant(steps[s].first));
+        bits = builder.CreateAnd(
+            builder.CreateOr(bits, shifted),
+            tlctx_->get_constant(s > 0 ? steps[s - 1].second : low_bits));
+      }
+      addition = bits;
+      const int brick_shape = snode->extractors[i].shape >> m;
+      if (brick_shape > 1) {
+        const int brick_acc_shape =
+            snode->extractors[i].acc_shape >> (m * num_minor_axes);
+        auto prev = tlctx_->get_constant(brick_acc_shape * brick_shape);
+        auto next = tlctx_->get_constant(brick_acc_shape);
+        auto brick_index =
+            builder.CreateUDiv(builder.CreateURem(brick, prev), next);
+        addition = builder.CreateOr(
+            builder.CreateShl(brick_index, tlctx_->get_constant(m)), addition);
+      }
+    } else if (snode->extractors[i].shape > 1) {
       auto prev = tlctx_->get_constant(snode->extractors[i].acc_shape *
                                        snode->extractors[i].shape);
       auto next = tlctx_->get_constant(snode->extractors[i].acc_shape);
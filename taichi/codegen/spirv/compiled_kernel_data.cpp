@@ -66,7 +66,7 @@ CompiledKernelData::Err CompiledKernelData::src2str(
 }
 
 CompiledKernelData::Err CompiledKernelData::str2src(
-    const std::string &str,
+    std::string_view str,
     InternalData::Source &result) {
   return read_from_binary(result, str.data(), str.size())
              ? Err::kNoError
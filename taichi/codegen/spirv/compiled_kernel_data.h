@@ -42,7 +42,7 @@ class CompiledKernelData : public lang::CompiledKernelData {
 
  private:
   static Err src2str(const InternalData::Source &src, std::string &result);
-  static Err str2src(const std::string &str, InternalData::Source &result);
+  static Err str2src(std::string_view str, InternalData::Source &result);
 
   Arch arch_;
   InternalData data_;
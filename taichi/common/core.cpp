@@ -15,6 +15,8 @@
 #include "taichi/platform/windows/windows.h"
 #else
 // Mac and Linux
+#include <cerrno>
+#include <signal.h>
 #include <unistd.h>
 #endif
 
@@ -88,6 +90,24 @@ std::string get_cuda_version_string() {
   return CUDA_VERSION;
 }
 
+std::string get_host_name() {
+#if defined(TI_PLATFORM_WINDOWS)
+  char name[MAX_COMPUTERNAME_LENGTH + 1];
+  DWORD size = sizeof(name);
+  if (!GetComputerNameA(name, &size)) {
+    return "";
+  }
+  return std::string(name, size);
+#else
+  char name[256];
+  if (gethostname(name, sizeof(name)) != 0) {
+    return "";
+  }
+  name[sizeof(name) - 1] = '\0';
+  return name;
+#endif
+}
+
 int PID::get_pid() {
 #if defined(TI_PLATFORM_WINDOWS)
   return (int)GetCurrentProcessId();
@@ -105,4 +125,19 @@ int PID::get_parent_pid() {
 #endif
 }
 
+bool PID::is_alive(int pid) {
+#if defined(TI_PLATFORM_WINDOWS)
+  HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, (DWORD)pid);
+  if (process == nullptr) {
+    return GetLastError() == ERROR_ACCESS_DENIED;
+  }
+  bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+  CloseHandle(process);
+  return alive;
+#else
+  // Signal 0 only checks for the existence of the process.
+  return kill(pid, 0) == 0 || errno == EPERM;
+#endif
+}
+
 }  // namespace taichi
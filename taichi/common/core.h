@@ -327,10 +327,14 @@ std::string get_commit_hash();
 
 std::string get_cuda_version_string();
 
+std::string get_host_name();
+
 class PID {
  public:
   static int get_pid();
   static int get_parent_pid();
+  // Whether a process with |pid| exists on this host.
+  static bool is_alive(int pid);
 };
 
 }  // namespace taichi
@@ -1,7 +1,17 @@
 #include "taichi/compilation_manager/kernel_compilation_manager.h"
 
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+
 #include "taichi/analysis/offline_cache_util.h"
 #include "taichi/codegen/compiled_kernel_data.h"
+#include "taichi/program/parallel_executor.h"
 #include "taichi/util/offline_cache.h"
 
 namespace taichi::lang {
@@ -44,22 +54,91 @@ struct CacheCleanerUtils<CacheData> {
   static bool is_valid_cache_file(const CacheCleanerConfig &config,
                                   const std::string &name) {
     std::string ext = filename_extension(name);
-    return ext == kTiCacheFilenameExt;
+    return ext == kTiCacheFilenameExt || ext == kTiCacheContainerFilenameExt ||
+           ext == kTiCacheJournalFilenameExt;
   }
 };
 
 }  // namespace offline_cache
 
+namespace {
+
+std::unordered_set<std::string> cached_keys(const CacheData &data) {
+  std::unordered_set<std::string> keys;
+  for (const auto &[key, _] : data.kernels) {
+    keys.insert(key);
+  }
+  return keys;
+}
+
+// Tells this process apart from an earlier one that had the same pid.
+std::uint64_t process_nonce() {
+  static const std::uint64_t nonce =
+      (std::uint64_t(std::random_device{}()) << 32) | std::random_device{}();
+  return nonce;
+}
+
+// Records the calling process as the owner of the claim at |path|.
+void write_claim_owner(const std::string &path) {
+  std::ofstream fs{path};
+  fs << get_host_name() << ' ' << PID::get_pid() << ' ' << process_nonce()
+     << std::endl;
+}
+
+bool is_claim_stale(const std::string &path,
+                    int unchecked_stale_seconds,
+                    int max_claim_seconds) {
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  auto claimed_at = fs::last_write_time(path, ec);
+  if (ec) {
+    return false;
+  }
+  auto age = fs::file_time_type::clock::now() - claimed_at;
+  std::ifstream ifs{path};
+  std::string host;
+  int pid{0};
+  std::uint64_t nonce{0};
+  if (ifs >> host >> pid >> nonce && host == get_host_name()) {
+    if (pid == PID::get_pid()) {
+      // Either another thread of this process holds the claim, or a crashed
+      // process whose pid has been reused by this one.
+      return nonce != process_nonce();
+    }
+    // The pid may have been reused by an unrelated process since the owner
+    // exited.
+    return !PID::is_alive(pid) || age > std::chrono::seconds(max_claim_seconds);
+  }
+  return age > std::chrono::seconds(unchecked_stale_seconds);
+}
+
+}  // namespace
+
 KernelCompilationManager::KernelCompilationManager(Config config)
     : config_(std::move(config)) {
   TI_DEBUG("Create KernelCompilationManager with offline_cache_file_path = {}",
            config_.offline_cache_path);
   auto filepath = join_path(config_.offline_cache_path, kMetadataFilename);
   auto lock_path = join_path(config_.offline_cache_path, kMetadataLockName);
-  if (path_exists(filepath)) {
+  if (config_.single_file && config_.multi_process) {
+    TI_WARN("The single-file offline cache does not support multi-process "
+            "mode; falling back to the metadata lock");
+    config_.multi_process = false;
+  }
+  if (config_.multi_process) {
+    // The metadata is only ever replaced by a rename, so it can be read
+    // without the lock.
+    if (path_exists(filepath)) {
+      offline_cache::load_metadata_with_checking(cached_data_, filepath);
+    }
+  } else if (path_exists(filepath)) {
     if (lock_with_file(lock_path)) {
       auto _ = make_unlocker(lock_path);
       offline_cache::load_metadata_with_checking(cached_data_, filepath);
+      if (config_.single_file) {
+        container_ = CacheContainer::open(
+            join_path(config_.offline_cache_path, kContainerFilename));
+      }
     } else {
       TI_WARN(
           "Lock {} failed. Please run 'ti cache clean -p {}' and try again.",
@@ -81,10 +160,136 @@ const CompiledKernelData &KernelCompilationManager::load_or_compile(
                                                   caps, kernel_def);
 }
 
+void KernelCompilationManager::warm_up(Arch arch,
+                                       std::size_t max_kernels,
+                                       int num_threads) {
+  TI_ASSERT(!warm_up_workers_);
+  std::vector<const KernelCacheData *> candidates;
+  candidates.reserve(cached_data_.kernels.size());
+  for (const auto &[_, k] : cached_data_.kernels) {
+    candidates.push_back(&k);
+  }
+  const auto n = std::min(max_kernels, candidates.size());
+  std::partial_sort(candidates.begin(), candidates.begin() + n,
+                    candidates.end(),
+                    [](const KernelCacheData *a, const KernelCacheData *b) {
+                      return a->last_used_at > b->last_used_at;
+                    });
+  if (n == 0) {
+    return;
+  }
+
+  TI_DEBUG("Warm up {} kernels from offline cache {}", n,
+           config_.offline_cache_path);
+  warm_up_workers_ = std::make_unique<ParallelExecutor>(
+      "cache_warm_up", std::min<int>(num_threads, n));
+  for (std::size_t i = 0; i < n; i++) {
+    const auto &kernel_key = candidates[i]->kernel_key;
+    auto promise =
+        std::make_shared<std::promise<std::unique_ptr<CompiledKernelData>>>();
+    warming_up_kernels_[kernel_key] = promise->get_future();
+    warm_up_workers_->enqueue([this, promise, kernel_key, arch]() {
+      std::unique_ptr<CompiledKernelData> ckd;
+      try {
+        ckd = load_ckd(kernel_key, arch);
+      } catch (...) {
+        // Fall back to loading (or compiling) on the critical path.
+      }
+      promise->set_value(std::move(ckd));
+    });
+  }
+}
+
+std::size_t KernelCompilationManager::compile_kernels(
+    const CompileConfig &compile_config,
+    const DeviceCapabilityConfig &caps,
+    const std::vector<CompileRequest> &requests) {
+  struct PendingKernel {
+    std::string kernel_key;
+    const Kernel *kernel_def;
+    int priority;
+    std::unique_ptr<CompiledKernelData> compiled_kernel_data;
+    bool published{false};
+  };
+
+  // Deduplicate against the batch itself and the in-memory and disk caches.
+  // This touches the caches, so it stays on the calling thread.
+  std::vector<PendingKernel> pending;
+  std::unordered_set<std::string> seen_keys;
+  for (const auto &req : requests) {
+    TI_ASSERT(req.kernel_def != nullptr);
+    const auto &kernel_def = *req.kernel_def;
+    auto kernel_key = make_kernel_key(compile_config, caps, kernel_def);
+    if (!seen_keys.insert(kernel_key).second) {
+      continue;
+    }
+    auto cache_mode = get_cache_mode(compile_config, kernel_def);
+    if (try_load_cached_kernel(kernel_def, kernel_key, compile_config.arch,
+                               cache_mode)) {
+      continue;
+    }
+    pending.push_back({std::move(kernel_key), &kernel_def, req.priority});
+  }
+  if (pending.empty()) {
+    return 0;
+  }
+  std::stable_sort(pending.begin(), pending.end(),
+                   [](const PendingKernel &a, const PendingKernel &b) {
+                     return a.priority > b.priority;
+                   });
+
+  const int num_threads = std::min<int>(
+      compile_config.print_ir ? 1 : compile_config.num_compile_threads,
+      (int)pending.size());
+  std::mutex error_mut;
+  std::exception_ptr error;
+  {
+    // Bound the queue so that lower-priority requests are only materialized
+    // into tasks once workers are about to become free.
+    ParallelExecutor executor("compile_batch", num_threads,
+                              /*max_queued_tasks=*/std::max(num_threads, 1));
+    for (auto &k : pending) {
+      executor.enqueue(
+          [&] {
+            try {
+              k.compiled_kernel_data =
+                  use_compile_once(compile_config, *k.kernel_def)
+                      ? compile_kernel_once(k.kernel_key, compile_config,
+                                            caps, *k.kernel_def, &k.published)
+                      : compile_kernel(compile_config, caps, *k.kernel_def);
+            } catch (...) {
+              std::lock_guard<std::mutex> _(error_mut);
+              if (!error) {
+                error = std::current_exception();
+              }
+            }
+          },
+          k.priority);
+    }
+    executor.flush();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  for (auto &k : pending) {
+    if (k.published) {
+      published_kernels_.insert(k.kernel_key);
+    }
+    cache_kernel(k.kernel_key, compile_config, *k.kernel_def,
+                 std::move(k.compiled_kernel_data));
+  }
+  return pending.size();
+}
+
 void KernelCompilationManager::dump() {
   if (caching_kernels_.empty()) {
     return;
   }
+  if (config_.multi_process) {
+    dump_multi_process();
+    return;
+  }
 
   taichi::create_directories(config_.offline_cache_path);
   auto filepath = join_path(config_.offline_cache_path, kMetadataFilename);
@@ -122,8 +327,20 @@ void KernelCompilationManager::dump() {
   // Clear caching_kernels_
   caching_kernels_.clear();
   // Dump cached CompiledKernelData to disk
+  std::vector<std::pair<std::string, std::string>> container_blobs;
   for (auto &[_, k] : kernels) {
-    if (k.compiled_kernel_data) {
+    if (k.compiled_kernel_data && config_.single_file) {
+      std::ostringstream oss{std::ios::out | std::ios::binary};
+      auto err = k.compiled_kernel_data->dump(oss);
+      if (err == CompiledKernelData::Err::kNoError) {
+        container_blobs.emplace_back(k.kernel_key, oss.str());
+        k.size = container_blobs.back().second.size();
+        data.size += k.size;
+      } else {
+        TI_DEBUG("Dump cached CompiledKernelData(kernel_key={}) failed: {}",
+                 k.kernel_key, CompiledKernelData::get_err_msg(err));
+      }
+    } else if (k.compiled_kernel_data) {
       auto cache_filename = make_filename(k.kernel_key);
       std::ofstream fs{cache_filename, std::ios::out | std::ios::binary};
       TI_ASSERT(fs.is_open());
@@ -138,6 +355,11 @@ void KernelCompilationManager::dump() {
       }
     }
   }
+  if (!container_blobs.empty() && !write_container(data, container_blobs)) {
+    TI_WARN("Failed to write {} kernels to the offline cache container in {}",
+            container_blobs.size(), config_.offline_cache_path);
+    return;
+  }
   // Dump offline cache metadata
   if (!kernels.empty()) {
     write_to_binary_file(data, filepath);
@@ -147,7 +369,7 @@ void KernelCompilationManager::dump() {
 void KernelCompilationManager::clean_offline_cache(
     offline_cache::CleanCachePolicy policy,
     int max_bytes,
-    double cleaning_factor) const {
+    double cleaning_factor) {
   using CacheCleaner = offline_cache::CacheCleaner<CacheData>;
   offline_cache::CacheCleanerConfig config;
   config.path = config_.offline_cache_path;
@@ -157,7 +379,68 @@ void KernelCompilationManager::clean_offline_cache(
   config.metadata_filename = kMetadataFilename;
   config.debugging_metadata_filename = "";
   config.metadata_lock_name = kMetadataLockName;
+  if (config_.multi_process) {
+    // Let the cleaner see the kernels of the other processes.
+    merge_journals();
+  }
   CacheCleaner::run(config);
+  if (config_.single_file) {
+    clean_container();
+  }
+}
+
+bool KernelCompilationManager::write_container(
+    const CacheData &data,
+    const std::vector<std::pair<std::string, std::string>> &blobs) {
+  auto path = join_path(config_.offline_cache_path, kContainerFilename);
+  auto container = CacheContainer::open(path);
+  bool compact =
+      container &&
+      container->file_size() > kContainerCompactionFactor * data.size;
+  container.reset();
+  // Windows does not replace a file that is mapped, by this or by any other
+  // process, so compaction may fail. Appending still works then.
+  container_.reset();
+  bool ok = (compact && CacheContainer::compact(path, cached_keys(data),
+                                                blobs)) ||
+            CacheContainer::append(path, blobs);
+  container_ = CacheContainer::open(path);
+  return ok;
+}
+
+void KernelCompilationManager::clean_container() {
+  // The cleaner only updates the metadata. Drop the blobs of the kernels it
+  // removed, and the stale bytes left by appends, from the container.
+  auto path = join_path(config_.offline_cache_path, kContainerFilename);
+  auto lock_path = join_path(config_.offline_cache_path, kMetadataLockName);
+  if (!taichi::path_exists(path) || !lock_with_file(lock_path)) {
+    return;
+  }
+  auto _ = make_unlocker(lock_path);
+  CacheData data;
+  auto error = offline_cache::load_metadata_with_checking(
+      data, join_path(config_.offline_cache_path, kMetadataFilename));
+  if (error == offline_cache::LoadMetadataError::kFileNotFound) {
+    // All the kernels were removed
+    container_.reset();
+    if (!taichi::remove(path)) {
+      TI_DEBUG("Failed to remove the offline cache container {}", path);
+    }
+    return;
+  }
+  auto container = CacheContainer::open(path);
+  if (error != offline_cache::LoadMetadataError::kNoError || !container ||
+      container->file_size() <= kContainerCompactionFactor * data.size) {
+    return;
+  }
+  container.reset();
+  container_.reset();
+  if (!CacheContainer::compact(path, cached_keys(data))) {
+    // The container stays as it is. Its stale blobs are unreachable, since
+    // kernels are only looked up by the keys in the metadata.
+    TI_DEBUG("Failed to compact the offline cache container {}", path);
+  }
+  container_ = CacheContainer::open(path);
 }
 
 std::string KernelCompilationManager::make_filename(
@@ -177,6 +460,198 @@ std::unique_ptr<CompiledKernelData> KernelCompilationManager::compile_kernel(
   return ckd;
 }
 
+std::unique_ptr<CompiledKernelData>
+KernelCompilationManager::compile_kernel_once(
+    const std::string &kernel_key,
+    const CompileConfig &compile_config,
+    const DeviceCapabilityConfig &caps,
+    const Kernel &kernel_def,
+    bool *published) {
+  // Kernel keys are content hashes, so a cache file with the same name holds
+  // the same kernel no matter which process wrote it.
+  const auto filename = make_filename(kernel_key);
+  const auto claim_path = join_path(
+      config_.offline_cache_path, fmt::format(kClaimFilenameFormat, kernel_key));
+  create_directories(config_.offline_cache_path);
+  *published = false;
+  while (true) {
+    if (auto ckd = load_ckd(kernel_key, compile_config.arch)) {
+      *published = true;
+      return ckd;
+    }
+    if (try_lock_with_file(claim_path)) {
+      auto _ = make_unlocker(claim_path);
+      write_claim_owner(claim_path);
+      // The owner of the previous claim may have published the kernel just
+      // before we claimed it.
+      if (auto ckd = load_ckd(kernel_key, compile_config.arch)) {
+        *published = true;
+        return ckd;
+      }
+      auto ckd = compile_kernel(compile_config, caps, kernel_def);
+      *published = dump_atomically(filename, [&](std::ostream &os) {
+        return ckd->dump(os) == CompiledKernelData::Err::kNoError;
+      });
+      return ckd;
+    }
+    if (is_claim_stale(claim_path, kStaleClaimSeconds, kMaxClaimSeconds)) {
+      TI_WARN("Removing stale offline cache claim {}", claim_path);
+      unlock_with_file(claim_path);
+      continue;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+}
+
+bool KernelCompilationManager::dump_atomically(
+    const std::string &filename,
+    const std::function<bool(std::ostream &)> &dump) {
+  const auto tmp_filename =
+      fmt::format("{}.{:x}.tmp", filename, std::random_device{}());
+  {
+    std::ofstream fs{tmp_filename, std::ios::out | std::ios::binary};
+    if (!fs.is_open() || !dump(fs) || !fs.flush()) {
+      fs.close();
+      taichi::remove(tmp_filename);
+      return false;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp_filename, filename, ec);
+  if (ec) {
+    TI_DEBUG("Rename {} to {} failed: {}", tmp_filename, filename,
+             ec.message());
+    taichi::remove(tmp_filename);
+    return false;
+  }
+  return true;
+}
+
+void KernelCompilationManager::dump_multi_process() {
+  namespace fs = std::filesystem;
+
+  // Publish the kernels that are not on disk yet, then keep only metadata.
+  std::unordered_map<std::string, KernelCacheData> new_kernels;
+  for (auto &[kernel_key, kernel] : caching_kernels_) {
+    if (kernel.cache_mode != CacheData::MemAndDiskCache) {
+      continue;
+    }
+    const auto filename = make_filename(kernel_key);
+    if (!published_kernels_.count(kernel_key) &&
+        !dump_atomically(filename, [&](std::ostream &os) {
+          return kernel.compiled_kernel_data->dump(os) ==
+                 CompiledKernelData::Err::kNoError;
+        })) {
+      continue;
+    }
+    std::error_code ec;
+    KernelCacheData k;
+    k.kernel_key = kernel_key;
+    k.size = fs::file_size(filename, ec);
+    k.created_at = kernel.created_at;
+    k.last_used_at = kernel.last_used_at;
+    new_kernels[kernel_key] = std::move(k);
+  }
+  // Kernels that were only used carry no creation time, see
+  // merge_journals().
+  for (const auto *e : updated_data_) {
+    auto &k = new_kernels[e->kernel_key];
+    if (k.kernel_key.empty()) {
+      k.kernel_key = e->kernel_key;
+      k.last_used_at = e->last_used_at;
+    }
+  }
+  caching_kernels_.clear();
+  published_kernels_.clear();
+  if (new_kernels.empty()) {
+    return;
+  }
+
+  // Each process writes its entries to a journal of its own, so no entry is
+  // lost to a concurrent writer. Journals are folded into the metadata by
+  // whichever process gets the metadata lock.
+  CacheData journal;
+  journal.version[0] = TI_VERSION_MAJOR;
+  journal.version[1] = TI_VERSION_MINOR;
+  journal.version[2] = TI_VERSION_PATCH;
+  journal.kernels = std::move(new_kernels);
+  const auto journal_path =
+      join_path(config_.offline_cache_path,
+                fmt::format(kJournalFilenameFormat,
+                            fmt::format("{:x}{:x}", std::random_device{}(),
+                                        std::random_device{}())));
+  if (!dump_atomically(journal_path, [&](std::ostream &os) {
+        write_to_binary_stream(journal, os);
+        return bool(os);
+      })) {
+    TI_DEBUG("Failed to write offline cache journal {}", journal_path);
+    return;
+  }
+  merge_journals();
+}
+
+void KernelCompilationManager::merge_journals() const {
+  auto filepath = join_path(config_.offline_cache_path, kMetadataFilename);
+  auto lock_path = join_path(config_.offline_cache_path, kMetadataLockName);
+  if (!lock_with_file(lock_path)) {
+    // The journals stay until the next dump or cleaning.
+    TI_DEBUG("Lock {} failed; offline cache journals are merged later",
+             lock_path);
+    return;
+  }
+  auto _ = make_unlocker(lock_path);
+  CacheData data;
+  data.version[0] = TI_VERSION_MAJOR;
+  data.version[1] = TI_VERSION_MINOR;
+  data.version[2] = TI_VERSION_PATCH;
+  offline_cache::load_metadata_with_checking(data, filepath);
+  std::vector<std::string> journals;
+  taichi::traverse_directory(
+      config_.offline_cache_path, [&](const std::string &name, bool is_dir) {
+        if (!is_dir && filename_extension(name) ==
+                           offline_cache::kTiCacheJournalFilenameExt) {
+          journals.push_back(join_path(config_.offline_cache_path, name));
+        }
+      });
+  if (journals.empty()) {
+    return;
+  }
+  for (const auto &journal_path : journals) {
+    CacheData journal;
+    // Journals of other versions are dropped.
+    if (offline_cache::load_metadata_with_checking(journal, journal_path) !=
+        offline_cache::LoadMetadataError::kNoError) {
+      continue;
+    }
+    for (auto &[kernel_key, k] : journal.kernels) {
+      auto iter = data.kernels.find(kernel_key);
+      if (iter != data.kernels.end()) {
+        iter->second.last_used_at =
+            std::max(iter->second.last_used_at, k.last_used_at);
+      } else if (k.created_at != 0) {
+        // Not an entry of a kernel that was only used; that kernel may have
+        // been cleaned since.
+        data.kernels[kernel_key] = std::move(k);
+      }
+    }
+  }
+  data.size = 0;
+  for (const auto &[_, k] : data.kernels) {
+    data.size += k.size;
+  }
+  if (!dump_atomically(filepath, [&](std::ostream &os) {
+        write_to_binary_stream(data, os);
+        return bool(os);
+      })) {
+    TI_DEBUG("Failed to merge offline cache journals in {}",
+             config_.offline_cache_path);
+    return;
+  }
+  for (const auto &journal_path : journals) {
+    taichi::remove(journal_path);
+  }
+}
+
 std::string KernelCompilationManager::make_kernel_key(
     const CompileConfig &compile_config,
     const DeviceCapabilityConfig &caps,
@@ -219,7 +694,7 @@ const CompiledKernelData *KernelCompilationManager::try_load_cached_kernel(
         TI_DEBUG("Create kernel '{}' from cache (key='{}')",
                  kernel_def.get_name(), kernel_key);
         return k.compiled_kernel_data.get();
-      } else if (auto loaded = load_ckd(kernel_key, arch)) {
+      } else if (auto loaded = take_warmed_up_ckd(kernel_key, arch)) {
         TI_DEBUG("Create kernel '{}' from cache (key='{}')",
                  kernel_def.get_name(), kernel_key);
         TI_ASSERT(loaded->arch() == arch);
@@ -238,6 +713,25 @@ const CompiledKernelData &KernelCompilationManager::compile_and_cache_kernel(
     const CompileConfig &compile_config,
     const DeviceCapabilityConfig &caps,
     const Kernel &kernel_def) {
+  if (use_compile_once(compile_config, kernel_def)) {
+    bool published = false;
+    auto ckd = compile_kernel_once(kernel_key, compile_config, caps,
+                                   kernel_def, &published);
+    if (published) {
+      published_kernels_.insert(kernel_key);
+    }
+    return cache_kernel(kernel_key, compile_config, kernel_def,
+                        std::move(ckd));
+  }
+  return cache_kernel(kernel_key, compile_config, kernel_def,
+                      compile_kernel(compile_config, caps, kernel_def));
+}
+
+const CompiledKernelData &KernelCompilationManager::cache_kernel(
+    const std::string &kernel_key,
+    const CompileConfig &compile_config,
+    const Kernel &kernel_def,
+    std::unique_ptr<CompiledKernelData> compiled_kernel_data) {
   auto cache_mode = get_cache_mode(compile_config, kernel_def);
   TI_DEBUG_IF(cache_mode == CacheData::MemAndDiskCache,
               "Cache kernel '{}' (key='{}')", kernel_def.get_name(),
@@ -246,7 +740,7 @@ const CompiledKernelData &KernelCompilationManager::compile_and_cache_kernel(
   KernelCacheData k;
   k.kernel_key = kernel_key;
   k.created_at = k.last_used_at = std::time(nullptr);
-  k.compiled_kernel_data = compile_kernel(compile_config, caps, kernel_def);
+  k.compiled_kernel_data = std::move(compiled_kernel_data);
   k.size = 0;  // Populate `size` within the KernelCompilationManager::dump()
   k.cache_mode = cache_mode;
   const auto &kernel_data = (caching_kernels_[kernel_key] = std::move(k));
@@ -256,6 +750,27 @@ const CompiledKernelData &KernelCompilationManager::compile_and_cache_kernel(
 std::unique_ptr<CompiledKernelData> KernelCompilationManager::load_ckd(
     const std::string &kernel_key,
     Arch arch) {
+  if (config_.single_file) {
+    // Deserialize straight from the mapping; the source code is not copied
+    // before it is handed to the backend.
+    auto blob = container_ ? container_->find(kernel_key) : std::nullopt;
+    if (!blob) {
+      return nullptr;
+    }
+    CompiledKernelData::Err err;
+    auto ckd = CompiledKernelData::load(blob->data(), blob->size(), &err);
+    if (err != CompiledKernelData::Err::kNoError) {
+      TI_DEBUG("Load kernel {} from cache container failed: {}", kernel_key,
+               CompiledKernelData::get_err_msg(err));
+      return nullptr;
+    }
+    if (auto err = ckd->check(); err != CompiledKernelData::Err::kNoError) {
+      TI_DEBUG("Check CompiledKernelData of kernel {} failed: {}", kernel_key,
+               CompiledKernelData::get_err_msg(err));
+      return nullptr;
+    }
+    return ckd;
+  }
   const auto filename = make_filename(kernel_key);
   if (std::ifstream ifs(filename, std::ios::in | std::ios::binary);
       ifs.is_open()) {
@@ -276,6 +791,21 @@ std::unique_ptr<CompiledKernelData> KernelCompilationManager::load_ckd(
   return nullptr;
 }
 
+std::unique_ptr<CompiledKernelData>
+KernelCompilationManager::take_warmed_up_ckd(const std::string &kernel_key,
+                                             Arch arch) {
+  auto iter = warming_up_kernels_.find(kernel_key);
+  if (iter == warming_up_kernels_.end()) {
+    return load_ckd(kernel_key, arch);
+  }
+  auto ckd = iter->second.get();
+  warming_up_kernels_.erase(iter);
+  if (ckd && ckd->arch() != arch) {
+    return nullptr;
+  }
+  return ckd;
+}
+
 CacheData::CacheMode KernelCompilationManager::get_cache_mode(
     const CompileConfig &compile_config,
     const Kernel &kernel_def) {
@@ -1,13 +1,18 @@
 #pragma once
 
 #include <ctime>
+#include <functional>
+#include <future>
 #include <string>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 
+#include "taichi/util/cache_container.h"
 #include "taichi/util/offline_cache.h"
 #include "taichi/codegen/kernel_compiler.h"
 #include "taichi/codegen/compiled_kernel_data.h"
+#include "taichi/program/parallel_executor.h"
 
 namespace taichi::lang {
 
@@ -47,6 +52,19 @@ class KernelCompilationManager final {
   static constexpr char kMetadataFilename[] = "ticache.tcb";
   static constexpr char kCacheFilenameFormat[] = "{}.tic";
   static constexpr char kMetadataLockName[] = "ticache.lock";
+  static constexpr char kContainerFilename[] = "ticache.ticc";
+  static constexpr char kClaimFilenameFormat[] = "{}.claim";
+  static constexpr char kJournalFilenameFormat[] = "ticache.{}.tcj";
+  // The container is compacted once it is this many times larger than the
+  // kernels it holds.
+  static constexpr std::size_t kContainerCompactionFactor = 2;
+  // A claim is stale once the process that recorded itself in it has exited.
+  // Claims whose owner cannot be checked (on another host, or not recorded
+  // yet) are assumed stale after this long.
+  static constexpr int kStaleClaimSeconds = 600;
+  // Claims of live processes on this host are assumed stale after this long,
+  // in case the pid of their owner has been reused.
+  static constexpr int kMaxClaimSeconds = 6 * 3600;
 
   using KernelCacheData = CacheData::KernelData;
   using CachingKernels = std::unordered_map<std::string, KernelCacheData>;
@@ -54,6 +72,19 @@ class KernelCompilationManager final {
   struct Config {
     std::string offline_cache_path;
     std::unique_ptr<KernelCompiler> kernel_compiler;
+    // Store all kernels in one memory-mapped container instead of one file
+    // per kernel.
+    bool single_file{false};
+    // Share the cache directory between concurrently running processes
+    // without waiting for the metadata lock. See compile_kernel_once() and
+    // dump_multi_process().
+    bool multi_process{false};
+  };
+
+  struct CompileRequest {
+    const Kernel *kernel_def{nullptr};
+    // Requests with a higher priority are compiled first.
+    int priority{0};
   };
 
   explicit KernelCompilationManager(Config init_params);
@@ -63,13 +94,25 @@ class KernelCompilationManager final {
                                             const DeviceCapabilityConfig &caps,
                                             const Kernel &kernel_def);
 
+  // Compile the kernels that are neither in memory nor on disk concurrently,
+  // and cache them in memory so that later calls to load_or_compile() hit.
+  // Returns the number of kernels actually compiled.
+  std::size_t compile_kernels(const CompileConfig &compile_config,
+                              const DeviceCapabilityConfig &caps,
+                              const std::vector<CompileRequest> &requests);
+
+  // Start loading the |max_kernels| most recently used kernels of the offline
+  // cache on background threads. load_or_compile() picks up the results
+  // instead of reading the cache files again.
+  void warm_up(Arch arch, std::size_t max_kernels, int num_threads);
+
   // Dump the cached data in memory to disk
   void dump();
 
   // Run offline cache cleaning
   void clean_offline_cache(offline_cache::CleanCachePolicy policy,
                            int max_bytes,
-                           double cleaning_factor) const;
+                           double cleaning_factor);
 
  private:
   std::string make_filename(const std::string &kernel_key) const;
@@ -79,6 +122,45 @@ class KernelCompilationManager final {
       const DeviceCapabilityConfig &caps,
       const Kernel &kernel_def) const;
 
+  // Multi-process mode: loads the kernel if another process has already
+  // cached it; otherwise claims it, compiles it and publishes it with an
+  // atomic rename. Waits while another live process holds the claim.
+  std::unique_ptr<CompiledKernelData> compile_kernel_once(
+      const std::string &kernel_key,
+      const CompileConfig &compile_config,
+      const DeviceCapabilityConfig &caps,
+      const Kernel &kernel_def,
+      bool *published);
+
+  bool use_compile_once(const CompileConfig &compile_config,
+                        const Kernel &kernel_def) const {
+    return config_.multi_process &&
+           get_cache_mode(compile_config, kernel_def) ==
+               CacheData::MemAndDiskCache;
+  }
+
+  // Writes to a temporary file and renames it to |filename|, so that other
+  // processes never observe a partially written file.
+  static bool dump_atomically(const std::string &filename,
+                              const std::function<bool(std::ostream &)> &dump);
+
+  // Multi-process replacement of dump(): writes the new entries to a journal
+  // of this process, then merges the journals into the metadata.
+  void dump_multi_process();
+
+  // Folds all the journals into the metadata and removes them, if the
+  // metadata lock can be taken. Otherwise leaves them for a later call.
+  void merge_journals() const;
+
+  // Appends |blobs| to the container, or compacts it if it has grown too
+  // large. Must be called with the metadata lock held. Remaps container_.
+  bool write_container(
+      const CacheData &data,
+      const std::vector<std::pair<std::string, std::string>> &blobs);
+
+  // Drops the blobs of the kernels removed from the metadata.
+  void clean_container();
+
   std::string make_kernel_key(const CompileConfig &compile_config,
                               const DeviceCapabilityConfig &caps,
                               const Kernel &kernel_def) const;
@@ -95,9 +177,19 @@ class KernelCompilationManager final {
       const DeviceCapabilityConfig &caps,
       const Kernel &kernel_def);
 
+  const CompiledKernelData &cache_kernel(
+      const std::string &kernel_key,
+      const CompileConfig &compile_config,
+      const Kernel &kernel_def,
+      std::unique_ptr<CompiledKernelData> compiled_kernel_data);
+
   std::unique_ptr<CompiledKernelData> load_ckd(const std::string &kernel_key,
                                                Arch arch);
 
+  std::unique_ptr<CompiledKernelData> take_warmed_up_ckd(
+      const std::string &kernel_key,
+      Arch arch);
+
   static CacheData::CacheMode get_cache_mode(
       const CompileConfig &compile_config,
       const Kernel &kernel_def);
@@ -106,6 +198,18 @@ class KernelCompilationManager final {
   CachingKernels caching_kernels_;
   CacheData cached_data_;
   std::vector<KernelCacheData *> updated_data_;
+  // Only set if |config_.single_file|.
+  std::unique_ptr<CacheContainer> container_;
+  // Multi-process mode: kernels whose cache file is already on disk.
+  std::unordered_set<std::string> published_kernels_;
+  // Kernels being loaded by warm_up(), keyed by kernel key. Only accessed on
+  // the thread that owns |this|.
+  std::unordered_map<std::string,
+                     std::future<std::unique_ptr<CompiledKernelData>>>
+      warming_up_kernels_;
+  // Declared last so that it is flushed before anything it writes to is
+  // destroyed.
+  std::unique_ptr<ParallelExecutor> warm_up_workers_;
 };
 
 }  // namespace taichi::lang
@@ -27,6 +27,12 @@ constexpr std::size_t taichi_result_buffer_runtime_query_id = 31;
 
 constexpr int taichi_listgen_max_element_size = 1024;
 
+// The number of chunk directory entries kept in a dynamic SNode container.
+// Longer directories get more levels, see node_dynamic.h.
+constexpr int taichi_dynamic_max_root_entries = 4;
+// Dynamic SNode chunks double as directory pages of at least two entries.
+constexpr std::size_t taichi_dynamic_min_chunk_bytes = 16;
+
 // By default, CUDA could allocate up to 48KB static shared arrays.
 // It requires dynamic shared memory to allocate a larger array.
 // Therefore, when one shared array request for size greater than 48KB,
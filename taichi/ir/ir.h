@@ -13,6 +13,7 @@
 #include "taichi/common/one_or_more.h"
 #include "taichi/ir/snode.h"
 #include "taichi/ir/mesh.h"
+#include "taichi/ir/stmt_arena.h"
 #include "taichi/ir/type_factory.h"
 #include "taichi/util/short_name.h"
 
@@ -409,6 +410,16 @@ class Stmt : public IRNode {
   Stmt();
   Stmt(const Stmt &stmt);
 
+  // Statements are allocated from StmtArena. The deleting destructor passes
+  // the size of the most-derived statement.
+  static void *operator new(std::size_t size) {
+    return StmtArena::allocate(size);
+  }
+
+  static void operator delete(void *ptr, std::size_t size) {
+    StmtArena::deallocate(ptr, size);
+  }
+
   virtual bool is_container_statement() const {
     return false;
   }
@@ -80,8 +80,28 @@ class AnalysisManager {
     result_[PassT::id] = std::make_unique<ResultModelT>(std::move(result));
   }
 
+  // Dirty tracking: a pass records the fingerprint of an IR subtree it has
+  // left at a fixpoint. The subtree stays clean for that pass as long as it
+  // still has the same fingerprint, i.e. until some pass modifies it.
+  void mark_clean(const PassID &pass, const IRNode *node, uint64 fingerprint) {
+    clean_[pass][node] = fingerprint;
+  }
+
+  bool is_clean(const PassID &pass,
+                const IRNode *node,
+                uint64 fingerprint) const {
+    auto pass_it = clean_.find(pass);
+    if (pass_it == clean_.end()) {
+      return false;
+    }
+    auto it = pass_it->second.find(node);
+    return it != pass_it->second.end() && it->second == fingerprint;
+  }
+
  private:
   std::unordered_map<PassID, std::unique_ptr<AnalysisResultConcept>> result_;
+  std::unordered_map<PassID, std::unordered_map<const IRNode *, uint64>>
+      clean_;
 };
 
 }  // namespace taichi::lang
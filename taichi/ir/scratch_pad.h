@@ -221,8 +221,15 @@ class ScratchPads {
   }
 
   void finalize() {
-    for (auto &pad : pads) {
-      pad.second.finalize();
+    // A field cached in a loop may not be accessed by every kernel compiled
+    // from it, e.g. the backward one.
+    for (auto it = pads.begin(); it != pads.end();) {
+      if (it->second.accesses.empty()) {
+        it = pads.erase(it);
+      } else {
+        it->second.finalize();
+        ++it;
+      }
     }
   }
 
@@ -1,5 +1,6 @@
 #include "taichi/ir/snode.h"
 
+#include <algorithm>
 #include <limits>
 
 #include "taichi/ir/ir.h"
@@ -129,10 +130,70 @@ SNode &SNode::dynamic(const Axis &expr,
                       int chunk_size,
                       const DebugInfo &dbg_info) {
   auto &snode = create_node({expr}, {n}, SNodeType::dynamic, dbg_info);
+  if (chunk_size <= 0) {
+    ErrorEmitter(
+        TaichiRuntimeError(), &dbg_info,
+        fmt::format("Chunk size must be positive, got {}.", chunk_size));
+  }
   snode.chunk_size = chunk_size;
   return snode;
 }
 
+SNode &SNode::morton_dense(const std::vector<Axis> &axes,
+                           const std::vector<int> &sizes,
+                           const DebugInfo &dbg_info) {
+  auto &snode = create_node(axes, sizes, SNodeType::dense, dbg_info);
+  int num_axes = 0;
+  int bits = std::numeric_limits<int>::max();
+  for (int i = 0; i < taichi_max_num_indices; i++) {
+    const auto &extractor = snode.extractors[i];
+    if (!extractor.active) {
+      continue;
+    }
+    if (!bit::is_power_of_two(extractor.shape)) {
+      ErrorEmitter(TaichiRuntimeError(), &dbg_info,
+                   fmt::format("Every dimension of a Morton dense SNode must "
+                               "be a power of two, got {} on axis {}.",
+                               extractor.shape, char('i' + i)));
+    }
+    num_axes++;
+    bits = std::min(bits, (int)bit::log2int(extractor.shape));
+  }
+  if (snode.num_cells_per_container > std::numeric_limits<int>::max()) {
+    ErrorEmitter(TaichiRuntimeError(), &dbg_info,
+                 fmt::format("A Morton dense SNode can have at most 2^31 - 1 "
+                             "cells, got {}.",
+                             snode.num_cells_per_container));
+  }
+  // With a single axis, or a unit dimension, Z-order is row-major order.
+  if (num_axes > 1 && bits > 0) {
+    snode.morton_bits = bits;
+  }
+  return snode;
+}
+
+SNode &SNode::hash(const std::vector<Axis> &axes,
+                   const std::vector<int> &sizes,
+                   int capacity,
+                   const DebugInfo &dbg_info) {
+  auto &snode = create_node(axes, sizes, SNodeType::hash, dbg_info);
+  if (capacity <= 0 || (capacity & (capacity - 1)) != 0) {
+    ErrorEmitter(TaichiRuntimeError(), &dbg_info,
+                 fmt::format("The capacity of a hash SNode must be a positive "
+                             "power of two, got {}.",
+                             capacity));
+  }
+  // The table keys are 32-bit cell indices plus one.
+  if (snode.num_cells_per_container >= std::numeric_limits<int32>::max()) {
+    ErrorEmitter(TaichiRuntimeError(), &dbg_info,
+                 fmt::format("A hash SNode can have at most 2^31 - 2 cells, "
+                             "got {}.",
+                             snode.num_cells_per_container));
+  }
+  snode.chunk_size = capacity;
+  return snode;
+}
+
 SNode &SNode::bit_struct(BitStructType *bit_struct_type,
                          const DebugInfo &dbg_info) {
   auto &snode = create_node({}, {}, SNodeType::bit_struct, dbg_info);
@@ -145,6 +206,10 @@ SNode &SNode::quant_array(const std::vector<Axis> &axes,
                           const std::vector<int> &sizes,
                           int bits,
                           const DebugInfo &dbg_info) {
+  if (morton_bits > 0) {
+    ErrorEmitter(TaichiRuntimeError(), &dbg_info,
+                 "A quant array cannot be a child of a Morton dense SNode.");
+  }
   auto &snode = create_node(axes, sizes, SNodeType::quant_array, dbg_info);
   snode.physical_type =
       TypeFactory::get_instance().get_primitive_int_type(bits, false);
@@ -159,6 +224,25 @@ bool SNode::is_scalar() const {
   return is_place() && (num_active_indices == 0);
 }
 
+std::vector<std::pair<int, int>> SNode::morton_dilation_steps(int num_bits,
+                                                              int stride) {
+  TI_ASSERT(num_bits * stride < 32);
+  std::vector<std::pair<int, int>> steps;
+  if (num_bits <= 1) {
+    return steps;
+  }
+  // Halve the distance that each group of bits moves in every step.
+  for (int group = (int)bit::least_pot_bound(num_bits) / 2; group >= 1;
+       group /= 2) {
+    int mask = 0;
+    for (int t = 0; t < num_bits; t++) {
+      mask |= 1 << (t + (stride - 1) * (t & ~(group - 1)));
+    }
+    steps.emplace_back(group * (stride - 1), mask);
+  }
+  return steps;
+}
+
 SNode *SNode::get_least_sparse_ancestor() const {
   if (is_path_all_dense) {
     return nullptr;
@@ -176,6 +260,42 @@ int SNode::shape_along_axis(int i) const {
   return extractor.num_elements_from_root;
 }
 
+std::size_t SNode::dynamic_chunk_bytes(std::size_t cell_size_bytes,
+                                       int chunk_size) {
+  return std::max(cell_size_bytes * chunk_size,
+                  taichi_dynamic_min_chunk_bytes);
+}
+
+int SNode::dynamic_page_bits() const {
+  TI_ASSERT(type == SNodeType::dynamic);
+  auto entries = dynamic_chunk_bytes(cell_size_bytes, chunk_size) /
+                 sizeof(void *);
+  int bits = 0;
+  while ((std::size_t(2) << bits) <= entries) {
+    bits++;
+  }
+  return bits;
+}
+
+int SNode::dynamic_directory_depth() const {
+  TI_ASSERT(type == SNodeType::dynamic);
+  auto num_entries = (max_num_elements() + chunk_size - 1) / chunk_size;
+  const int bits = dynamic_page_bits();
+  int depth = 0;
+  while (num_entries > taichi_dynamic_max_root_entries) {
+    num_entries = ((num_entries - 1) >> bits) + 1;
+    depth++;
+  }
+  return depth;
+}
+
+int SNode::dynamic_num_root_entries() const {
+  TI_ASSERT(type == SNodeType::dynamic);
+  auto num_chunks = (max_num_elements() + chunk_size - 1) / chunk_size;
+  auto shift = dynamic_directory_depth() * dynamic_page_bits();
+  return (int)(((num_chunks - 1) >> shift) + 1);
+}
+
 int64 SNode::read_int(const std::vector<int> &i) {
   return snode_rw_accessors_bank_->get(this).read_int(i);
 }
@@ -224,7 +344,7 @@ SNode::SNode(int depth,
   parent = nullptr;
   has_ambient = false;
   dt = PrimitiveType::gen;
-  _morton = false;
+  morton_bits = 0;
 }
 
 SNode::SNode(const SNode &) {
@@ -342,6 +462,7 @@ SNode *SNode::get_dual() const {
 
 void SNode::set_snode_tree_id(int id) {
   snode_tree_id_ = id;
+  offline_cache_key_of_tree.clear();
   for (auto &child : ch) {
     child->set_snode_tree_id(id);
   }
@@ -95,6 +95,8 @@ class SNode {
   // See https://docs.taichi-lang.org/docs/internal for terms
   // like cell and container.
   int64 num_cells_per_container{1};
+  // The number of cells per chunk of dynamic SNodes, or the number of slots
+  // of the table of hash SNodes.
   int chunk_size{0};
   std::size_t cell_size_bytes{0};
   std::size_t offset_bytes_in_parent_cell{0};
@@ -127,7 +129,9 @@ class SNode {
 
   std::string node_type_name;
   SNodeType type;
-  bool _morton{false};
+  // For dense SNodes in Morton layout, the number of low bits of every active
+  // axis interleaved in Z-order within a brick. 0 means row-major.
+  int morton_bits{0};
 
   std::string get_node_type_name() const;
 
@@ -160,6 +164,13 @@ class SNode {
     return SNode::dense(std::vector<Axis>{axis}, size, dbg_info);
   }
 
+  // A dense SNode whose cells are stored in Z-order instead of row-major
+  // order. |sizes| must be powers of two. If they differ, the cells are
+  // grouped into cubic bricks of the smallest size, stored in row-major order.
+  SNode &morton_dense(const std::vector<Axis> &axes,
+                      const std::vector<int> &sizes,
+                      const DebugInfo &dbg_info = DebugInfo());
+
   SNode &pointer(const std::vector<Axis> &axes,
                  const std::vector<int> &sizes,
                  const DebugInfo &dbg_info = DebugInfo()) {
@@ -198,24 +209,11 @@ class SNode {
     return SNode::bitmasked(std::vector<Axis>{axis}, size, dbg_info);
   }
 
+  // |capacity| is the number of cells that can be active at the same time.
   SNode &hash(const std::vector<Axis> &axes,
               const std::vector<int> &sizes,
-              const DebugInfo &dbg_info = DebugInfo()) {
-    return create_node(axes, sizes, SNodeType::hash, dbg_info);
-  }
-
-  SNode &hash(const std::vector<Axis> &axes,
-              int sizes,
-              const DebugInfo &dbg_info = DebugInfo()) {
-    return create_node(axes, std::vector<int>{sizes}, SNodeType::hash,
-                       dbg_info);
-  }
-
-  SNode &hash(const Axis &axis,
-              int size,
-              const DebugInfo &dbg_info = DebugInfo()) {
-    return hash(std::vector<Axis>{axis}, size, dbg_info);
-  }
+              int capacity,
+              const DebugInfo &dbg_info = DebugInfo());
 
   std::string type_name() {
     return snode_type_name(type);
@@ -238,11 +236,6 @@ class SNode {
                  int chunk_size,
                  const DebugInfo &dbg_info = DebugInfo());
 
-  SNode &morton(bool val = true) {
-    _morton = val;
-    return *this;
-  }
-
   int child_id(SNode *c) {
     for (int i = 0; i < (int)ch.size(); i++) {
       if (ch[i].get() == c) {
@@ -285,6 +278,12 @@ class SNode {
 
   SNode *get_least_sparse_ancestor() const;
 
+  // The (shift, mask) steps of x = (x | x << shift) & mask that move bit t of
+  // a |num_bits|-bit integer to bit t * |stride|. Undoing them in reverse
+  // order with right shifts gathers the bits back (see Morton layouts).
+  static std::vector<std::pair<int, int>> morton_dilation_steps(int num_bits,
+                                                                int stride);
+
   std::string get_name() const {
     return node_type_name;
   }
@@ -316,6 +315,20 @@ class SNode {
 
   int shape_along_axis(int i) const;
 
+  // The size of the nodes allocated for a dynamic SNode, i.e. its chunks and
+  // the pages of its chunk directory.
+  static std::size_t dynamic_chunk_bytes(std::size_t cell_size_bytes,
+                                         int chunk_size);
+
+  // A page of the chunk directory has 2^dynamic_page_bits() entries.
+  int dynamic_page_bits() const;
+
+  // The number of directory pages between a container and a chunk.
+  int dynamic_directory_depth() const;
+
+  // The number of directory entries in each container.
+  int dynamic_num_root_entries() const;
+
   void place(Expr &expr, const std::vector<int> &offset, int id_in_bit_struct) {
     place_child(&expr, offset, id_in_bit_struct, this, snode_to_fields_);
   }
@@ -345,6 +358,11 @@ class SNode {
 
   const SNode *get_root() const;
 
+  // Memoized offline cache key of the tree rooted at this SNode. It is reset
+  // when the tree is added to a program, and must only be filled in after
+  // that (see get_hashed_offline_cache_key_of_snode).
+  mutable std::string offline_cache_key_of_tree;
+
   static void reset_counter() {
     counter = 0;
   }
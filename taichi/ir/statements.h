@@ -1419,6 +1419,10 @@ class OffloadedStmt : public Stmt {
   bool reversed{false};
   bool is_bit_vectorized{false};
   int num_cpu_threads{1};
+  // Number of consecutive iterations that form one tile of a range-for
+  // created by tile_dense_struct_fors. The loop is only split between threads
+  // on multiples of it.
+  int tile_volume{1};
   Stmt *end_stmt{nullptr};
   std::string range_hint = "";
 
@@ -1484,6 +1488,7 @@ class OffloadedStmt : public Stmt {
                      block_dim,
                      reversed,
                      num_cpu_threads,
+                     tile_volume,
                      index_offsets,
                      mem_access_opt);
   TI_DEFINE_ACCEPT
@@ -0,0 +1,330 @@
+#include "taichi/ir/stmt_arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+namespace taichi::lang {
+
+namespace {
+
+constexpr std::size_t kNumClasses =
+    StmtArena::kMaxSize / StmtArena::kGranularity;
+// Number of blocks moved between a thread cache and the shared pool at once.
+constexpr std::size_t kBatchSize = 64;
+constexpr std::size_t kMaxCachedBlocks = 2 * kBatchSize;
+// The shared pool returns the slabs whose blocks are all free to the system
+// once they add up to this many bytes and to half of the pooled bytes.
+constexpr std::size_t kMinTrimBytes = 16 * StmtArena::kSlabSize;
+
+// Slabs are aligned to their size, so that a block finds its slab by masking
+// its address. |refs| counts the blocks carved out of the slab that are in use
+// or pooled, plus one while a cache is still carving it. A slab whose |refs|
+// are all pooled blocks is free.
+struct SlabHeader {
+  std::atomic<std::size_t> refs;
+  // Guarded by the mutex of the shared pool.
+  std::size_t num_pooled;
+};
+
+constexpr std::size_t kSlabHeaderSize = StmtArena::kGranularity;
+static_assert(sizeof(SlabHeader) <= kSlabHeaderSize);
+static_assert((StmtArena::kSlabSize & (StmtArena::kSlabSize - 1)) == 0);
+
+SlabHeader *get_slab(void *ptr) {
+  return reinterpret_cast<SlabHeader *>(reinterpret_cast<std::uintptr_t>(ptr) &
+                                        ~(StmtArena::kSlabSize - 1));
+}
+
+struct FreeBlock {
+  FreeBlock *next;
+};
+
+struct FreeList {
+  FreeBlock *head{nullptr};
+  std::size_t size{0};
+
+  void push(void *ptr) {
+    auto block = static_cast<FreeBlock *>(ptr);
+    block->next = head;
+    head = block;
+    size++;
+  }
+
+  void *pop() {
+    auto block = head;
+    head = block->next;
+    size--;
+    return block;
+  }
+
+  // Moves up to |count| blocks to |dst|.
+  void move_to(FreeList &dst, std::size_t count) {
+    while (head && count--) {
+      dst.push(pop());
+    }
+  }
+};
+
+std::size_t get_size_class(std::size_t size) {
+  return (size + StmtArena::kGranularity - 1) / StmtArena::kGranularity - 1;
+}
+
+std::size_t get_class_size(std::size_t cls) {
+  return (cls + 1) * StmtArena::kGranularity;
+}
+
+class SharedPool {
+ public:
+  static SharedPool &get_instance() {
+    // Leaked, so that statements can still be freed during static destruction.
+    static auto instance = new SharedPool();
+    return *instance;
+  }
+
+  void refill(std::size_t cls, FreeList &dst) {
+    std::lock_guard<std::mutex> _(mut_);
+    for (std::size_t i = 0; i < kBatchSize && lists_[cls].head; i++) {
+      dst.push(unpool_block(cls));
+    }
+  }
+
+  void spill(std::size_t cls, FreeList &src, std::size_t count) {
+    std::lock_guard<std::mutex> _(mut_);
+    while (src.head && count--) {
+      pool_block(cls, src.pop());
+    }
+    maybe_trim();
+  }
+
+  // For threads whose cache is gone.
+  void *allocate_block(std::size_t cls) {
+    std::lock_guard<std::mutex> _(mut_);
+    if (lists_[cls].head) {
+      return unpool_block(cls);
+    }
+    const auto bytes = get_class_size(cls);
+    if (slab_end_ - slab_cur_ < (std::ptrdiff_t)bytes) {
+      retire_slab_locked(slab_cur_);
+      start_slab(slab_cur_, slab_end_);
+    }
+    return take(slab_cur_, bytes);
+  }
+
+  void release_block(std::size_t cls, void *ptr) {
+    std::lock_guard<std::mutex> _(mut_);
+    pool_block(cls, ptr);
+    maybe_trim();
+  }
+
+  // Carves |bytes| out of the slab [|cur|, |end|) of a thread cache, starting
+  // a new slab if it is too small.
+  char *carve(char *&cur, char *&end, std::size_t bytes) {
+    if (end - cur < (std::ptrdiff_t)bytes) {
+      // The rest of the old slab is dropped; it is less than kMaxSize.
+      retire_slab(cur);
+      start_slab(cur, end);
+    }
+    return take(cur, bytes);
+  }
+
+  // Called once the slab of |cur| is not carved any more.
+  void retire_slab(char *cur) {
+    std::lock_guard<std::mutex> _(mut_);
+    retire_slab_locked(cur);
+  }
+
+  StmtArena::Stats get_stats() {
+    StmtArena::Stats stats;
+    stats.bytes_reserved = bytes_reserved_;
+    stats.num_slabs = num_slabs_;
+    return stats;
+  }
+
+ private:
+  void start_slab(char *&cur, char *&end) {
+    auto slab = static_cast<char *>(::operator new(
+        StmtArena::kSlabSize, std::align_val_t{StmtArena::kSlabSize}));
+    // The reference of the carving cache.
+    new (slab) SlabHeader{{1}, 0};
+    bytes_reserved_ += StmtArena::kSlabSize;
+    num_slabs_++;
+    cur = slab + kSlabHeaderSize;
+    end = slab + StmtArena::kSlabSize;
+  }
+
+  // Only the carving cache of a slab adds references to it, so a free slab
+  // stays free until trim() returns it.
+  static char *take(char *&cur, std::size_t bytes) {
+    get_slab(cur)->refs.fetch_add(1, std::memory_order_relaxed);
+    auto ptr = cur;
+    cur += bytes;
+    return ptr;
+  }
+
+  void retire_slab_locked(char *cur) {
+    if (!cur) {
+      return;
+    }
+    // |cur| may be the end of the slab.
+    auto slab = get_slab(cur - 1);
+    if (slab->num_pooled &&
+        slab->num_pooled + 1 == slab->refs.load(std::memory_order_acquire)) {
+      num_free_slabs_++;
+    }
+    release(slab);
+  }
+
+  // Drops a reference to |slab|, and returns it to the system once nothing
+  // refers to it.
+  void release(SlabHeader *slab) {
+    if (slab->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      slab->~SlabHeader();
+      ::operator delete(slab, std::align_val_t{StmtArena::kSlabSize});
+      bytes_reserved_ -= StmtArena::kSlabSize;
+      num_slabs_--;
+    }
+  }
+
+  static bool is_free(SlabHeader *slab) {
+    return slab->num_pooled == slab->refs.load(std::memory_order_acquire);
+  }
+
+  void pool_block(std::size_t cls, void *ptr) {
+    auto slab = get_slab(ptr);
+    slab->num_pooled++;
+    if (is_free(slab)) {
+      num_free_slabs_++;
+    }
+    lists_[cls].push(ptr);
+    pooled_bytes_ += get_class_size(cls);
+  }
+
+  void *unpool_block(std::size_t cls) {
+    auto ptr = lists_[cls].pop();
+    auto slab = get_slab(ptr);
+    if (is_free(slab)) {
+      num_free_slabs_--;
+    }
+    slab->num_pooled--;
+    pooled_bytes_ -= get_class_size(cls);
+    return ptr;
+  }
+
+  // Trimming walks all pooled blocks, so it waits until it can return a good
+  // share of them.
+  void maybe_trim() {
+    const auto free_bytes = num_free_slabs_ * StmtArena::kSlabSize;
+    if (free_bytes >= kMinTrimBytes && 2 * free_bytes >= pooled_bytes_) {
+      trim();
+    }
+  }
+
+  // Returns the free slabs to the system. Their blocks are dropped from the
+  // lists; a slab stays free while they are released one by one.
+  void trim() {
+    for (std::size_t cls = 0; cls < kNumClasses; cls++) {
+      FreeList kept;
+      while (lists_[cls].head) {
+        auto ptr = lists_[cls].pop();
+        auto slab = get_slab(ptr);
+        if (is_free(slab)) {
+          slab->num_pooled--;
+          pooled_bytes_ -= get_class_size(cls);
+          release(slab);
+        } else {
+          kept.push(ptr);
+        }
+      }
+      lists_[cls] = kept;
+    }
+    num_free_slabs_ = 0;
+  }
+
+  std::mutex mut_;
+  FreeList lists_[kNumClasses];
+  std::size_t pooled_bytes_{0};
+  std::size_t num_free_slabs_{0};
+  // The slab that allocate_block() carves.
+  char *slab_cur_{nullptr};
+  char *slab_end_{nullptr};
+  std::atomic<std::size_t> bytes_reserved_{0};
+  std::atomic<std::size_t> num_slabs_{0};
+};
+
+// Trivially destructible, so it stays readable after the cache is destroyed.
+thread_local bool thread_cache_destroyed = false;
+
+struct ThreadCache {
+  FreeList lists[kNumClasses];
+  char *slab_cur{nullptr};
+  char *slab_end{nullptr};
+
+  void *carve(std::size_t bytes) {
+    return SharedPool::get_instance().carve(slab_cur, slab_end, bytes);
+  }
+
+  ~ThreadCache() {
+    auto &pool = SharedPool::get_instance();
+    for (std::size_t cls = 0; cls < kNumClasses; cls++) {
+      pool.spill(cls, lists[cls], lists[cls].size);
+    }
+    pool.retire_slab(slab_cur);
+    thread_cache_destroyed = true;
+  }
+};
+
+ThreadCache *get_thread_cache() {
+  if (thread_cache_destroyed) {
+    return nullptr;
+  }
+  thread_local ThreadCache cache;
+  return &cache;
+}
+
+}  // namespace
+
+void *StmtArena::allocate(std::size_t size) {
+  if (kEnabled && size <= kMaxSize) {
+    const auto cls = get_size_class(size);
+    auto cache = get_thread_cache();
+    if (!cache) {
+      return SharedPool::get_instance().allocate_block(cls);
+    }
+    auto &list = cache->lists[cls];
+    if (!list.head) {
+      SharedPool::get_instance().refill(cls, list);
+    }
+    if (list.head) {
+      return list.pop();
+    }
+    return cache->carve(get_class_size(cls));
+  }
+  return ::operator new(size);
+}
+
+void StmtArena::deallocate(void *ptr, std::size_t size) {
+  if (kEnabled && size <= kMaxSize) {
+    const auto cls = get_size_class(size);
+    auto cache = get_thread_cache();
+    if (!cache) {
+      SharedPool::get_instance().release_block(cls, ptr);
+      return;
+    }
+    auto &list = cache->lists[cls];
+    list.push(ptr);
+    if (list.size > kMaxCachedBlocks) {
+      SharedPool::get_instance().spill(cls, list, kBatchSize);
+    }
+    return;
+  }
+  ::operator delete(ptr);
+}
+
+StmtArena::Stats StmtArena::get_stats() {
+  return SharedPool::get_instance().get_stats();
+}
+
+}  // namespace taichi::lang
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+
+// Sanitizers can only see use-after-free of statements allocated one by one.
+#if defined(__SANITIZE_ADDRESS__)
+#define TI_STMT_ARENA_BYPASS
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define TI_STMT_ARENA_BYPASS
+#endif
+#endif
+
+namespace taichi::lang {
+
+// Memory for IR statements (see Stmt::operator new).
+//
+// Passes such as scalarize, lower_access and auto_diff create and destroy a
+// huge number of small statements. Serving them from size classes carved out
+// of large slabs avoids a malloc/free pair per statement and keeps the
+// statements of a kernel close together in memory.
+//
+// Freed blocks are cached per thread and exchanged with a shared pool in
+// batches, so a statement may be freed on another thread (e.g. a compilation
+// worker) than the one it was allocated on. Each slab counts its blocks in
+// use; once the pool holds a batch of slabs whose blocks are all free, it
+// returns them to the system.
+class StmtArena {
+ public:
+  static constexpr std::size_t kGranularity = 16;
+  // Larger statements go to the global operator new.
+  static constexpr std::size_t kMaxSize = 1024;
+  static constexpr std::size_t kSlabSize = 256 << 10;
+#if defined(TI_STMT_ARENA_BYPASS)
+  static constexpr bool kEnabled = false;
+#else
+  static constexpr bool kEnabled = true;
+#endif
+
+  struct Stats {
+    std::size_t bytes_reserved{0};
+    std::size_t num_slabs{0};
+  };
+
+  static void *allocate(std::size_t size);
+
+  // |size| must be the size passed to allocate().
+  static void deallocate(void *ptr, std::size_t size);
+
+  static Stats get_stats();
+};
+
+}  // namespace taichi::lang
@@ -69,7 +69,7 @@ bool inlining(IRNode *root,
               const CompileConfig &config,
               const InliningPass::Args &args);
 void bit_loop_vectorize(IRNode *root);
-void slp_vectorize(IRNode *root);
+bool slp_vectorize(IRNode *root, const CompileConfig &config);
 void replace_all_usages_with(IRNode *root, Stmt *old_stmt, Stmt *new_stmt);
 bool check_out_of_bound(IRNode *root,
                         const CompileConfig &config,
@@ -117,6 +117,7 @@ bool determine_ad_stack_size(IRNode *root, const CompileConfig &config);
 bool constant_fold(IRNode *root);
 void associate_continue_scope(IRNode *root, const CompileConfig &config);
 void offload(IRNode *root, const CompileConfig &config);
+bool fuse_offloads(IRNode *root, const CompileConfig &config);
 bool transform_statements(
     IRNode *root,
     std::function<bool(Stmt *)> filter,
@@ -141,6 +142,7 @@ bool replace_and_insert_statements(
 bool replace_statements(IRNode *root,
                         std::function<bool(Stmt *)> filter,
                         std::function<Stmt *(Stmt *)> finder);
+bool tile_dense_struct_fors(IRNode *root, const CompileConfig &config);
 void demote_dense_struct_fors(IRNode *root);
 void demote_no_access_mesh_fors(IRNode *root);
 bool demote_atomics(IRNode *root, const CompileConfig &config);
@@ -174,7 +176,8 @@ void compile_to_offloads(IRNode *ir,
                          bool verbose,
                          AutodiffMode autodiff_mode,
                          bool ad_use_stack,
-                         bool start_from_ast);
+                         bool start_from_ast,
+                         AnalysisManager *amgr = nullptr);
 
 void offload_to_executable(IRNode *ir,
                            const CompileConfig &config,
@@ -183,7 +186,8 @@ void offload_to_executable(IRNode *ir,
                            bool determine_ad_stack_size,
                            bool lower_global_access,
                            bool make_thread_local,
-                           bool make_block_local);
+                           bool make_block_local,
+                           AnalysisManager *amgr = nullptr);
 // compile_to_executable fully covers compile_to_offloads, and also does
 // additional optimizations so that |ir| can be directly fed into codegen.
 void compile_to_executable(IRNode *ir,
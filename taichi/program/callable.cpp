@@ -132,6 +132,10 @@ void Callable::pop_argpack_stack() {
   argpack_types[indices] = type_inner;
 }
 
+std::vector<int> Callable::insert_param(const Parameter &param) {
+  return add_parameter(param);
+}
+
 std::vector<int> Callable::add_parameter(const Parameter &param) {
   TI_ASSERT(temp_argpack_stack_.size() == temp_indices_stack_.size() &&
             temp_argpack_name_stack_.size() == temp_indices_stack_.size());
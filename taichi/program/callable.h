@@ -160,6 +160,9 @@ class TI_DLL_EXPORT Callable : public CallableBase {
                                            BufferFormat format,
                                            const std::string &name = "");
 
+  // Inserts a copy of |param|, e.g. one taken from another callable.
+  std::vector<int> insert_param(const Parameter &param);
+
   std::vector<int> insert_argpack_param_and_push(const std::string &name = "");
 
   void pop_argpack_stack();
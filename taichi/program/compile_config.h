@@ -26,12 +26,28 @@ struct CompileConfig {
   bool move_loop_invariant_outside_if;
   bool cache_loop_invariant_global_vars{true};
   bool demote_dense_struct_fors;
+  // Keep the element list of an SNode between struct-fors when no cell on its
+  // path has been activated or deactivated since it was generated, see
+  // clear_list in the LLVM runtime.
+  bool listgen_reuse{true};
+  // Fuse adjacent offloaded loops over the same iteration space that only
+  // depend on each other pointwise, see fuse_offloads.
+  bool offload_fusion{true};
+  // Fuse consecutive dispatches of a compute graph into a single kernel, see
+  // GraphBuilder::compile.
+  bool graph_fusion{true};
   bool advanced_optimization;
   bool constant_folding;
   bool use_llvm;
   bool verbose_kernel_launches;
   bool kernel_profiler;
   bool timeline{false};
+  // Record time and statement counts of each compilation pass, see
+  // CompileProfiler.
+  bool compile_profiler{false};
+  // Share the LLVM code of identical offloaded tasks between kernels, see
+  // LLVMTaskCache.
+  bool llvm_task_cache{true};
   bool verbose;
   bool fast_math;
   bool flatten_if;
@@ -41,7 +57,14 @@ struct CompileConfig {
   bool real_matrix_scalarize;
   bool force_scalarize_matrix;
   bool half2_vectorization;
+  // Pack isomorphic scalar arithmetic into vector ops after scalarization
+  // (CPU only).
+  bool slp_vectorization{false};
   bool make_cpu_multithreading_loop;
+  // Visit dense multi-dimensional struct-fors tile by tile on CPU, see
+  // tile_dense_struct_fors.
+  bool cpu_loop_tiling{true};
+  int cpu_loop_tile_size{0};  // 0 = chosen from the SNode layout
   DataType default_fp;
   DataType default_ip;
   DataType default_up;
@@ -54,10 +77,19 @@ struct CompileConfig {
   // The default size when the Taichi compiler is unable to automatically
   // determine the autodiff stack size.
   int default_ad_stack_size{32};
+  // Keep only checkpoints of long loops on the autodiff stacks and recompute
+  // the rest in the reverse pass, so that the loops fit the stack size.
+  bool ad_checkpointing{false};
+  // Accumulate the adjoints of fields cached with ti.block_local in
+  // block-local buffers in the backward kernels.
+  bool ad_block_local_adjoints{true};
 
   int saturating_grid_dim;
   int max_block_dim;
   int cpu_max_num_threads;
+  // Execute CPU kernel launches on a background stream, only blocking the
+  // caller on synchronization points.
+  bool cpu_async_launch{false};
   int random_seed;
 
   // LLVM backend options:
@@ -96,6 +128,16 @@ struct CompileConfig {
   int offline_cache_max_size_of_files{100 * 1024 *
                                       1024};   // bytes, default: 100MB
   double offline_cache_cleaning_factor{0.25};  // [0.f, 1.f]
+  // Store the cached kernels in one memory-mapped, append-only container file
+  // instead of one file per kernel.
+  bool offline_cache_single_file{false};
+  // Let many processes share one offline cache directory: each kernel is
+  // compiled by one process and published with an atomic rename, and the
+  // metadata is merged without the lock file.
+  bool offline_cache_multi_process{false};
+  // Number of most recently used kernels to load from the offline cache in
+  // the background when the program starts. 0 disables warm-up.
+  int offline_cache_warm_up_kernels{0};
 
   int num_compile_threads{4};
   std::string vk_api_version;
@@ -25,9 +25,7 @@ void Function::set_function_body(const std::function<void()> &func) {
   finalize_rets();
 
   if (program->compile_config().offline_cache) {  // For generating AST-Key
-    std::ostringstream oss;
-    gen_offline_cache_key(ir.get(), &oss);
-    ast_serialization_data_ = oss.str();
+    ast_serialization_data_ = gen_offline_cache_key(ir.get()).to_hex();
   }
 }
 
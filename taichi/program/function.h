@@ -48,7 +48,8 @@ class Function : public Callable {
 
  private:
   IRStage ir_stage_{IRStage::None};
-  std::optional<std::string> ast_serialization_data_;  // For generating AST-Key
+  // Digest of the AST, for generating AST-Key
+  std::optional<std::string> ast_serialization_data_;
 };
 
 }  // namespace taichi::lang
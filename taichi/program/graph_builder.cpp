@@ -1,8 +1,157 @@
 #include "taichi/program/graph_builder.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/program/kernel.h"
 #include "taichi/program/ndarray.h"
 #include "taichi/program/program.h"
+#include "taichi/util/hash128.h"
 
 namespace taichi::lang {
+
+namespace {
+
+// A fused kernel takes the parameters of all the kernels it replaces.
+constexpr std::size_t kMaxFusedParams = taichi_max_num_args_total;
+
+bool is_fusable(const aot::CompiledDispatch &dispatch) {
+  const Kernel *kernel = dispatch.ti_kernel;
+  return kernel != nullptr && kernel->ir != nullptr &&
+         kernel->autodiff_mode == AutodiffMode::kNone &&
+         !kernel->is_accessor && kernel->no_activate.empty() &&
+         kernel->rets.empty() && kernel->argpack_types.empty() &&
+         kernel->parameter_list.size() == dispatch.symbolic_args.size() &&
+         kernel->parameter_list.size() <= kMaxFusedParams;
+}
+
+// Returns a copy of the body of |kernel| in CHI IR.
+std::unique_ptr<Block> clone_to_chi_ir(Kernel *kernel) {
+  auto ir = irpass::analysis::clone(kernel->ir.get());
+  std::unique_ptr<Block> block(ir.release()->as<Block>());
+  block->set_parent_callable(kernel);
+  if (kernel->ir_is_ast()) {
+    irpass::frontend_type_check(block.get());
+    irpass::lower_ast(block.get());
+  }
+  return block;
+}
+
+void remap_arg_ids(Block *block, const std::vector<int> &new_ids) {
+  auto remap = [&](std::vector<int> &arg_id) {
+    arg_id[0] = new_ids[arg_id[0]];
+  };
+  irpass::analysis::gather_statements(block, [&](Stmt *stmt) {
+    if (auto arg_load = stmt->cast<ArgLoadStmt>()) {
+      remap(arg_load->arg_id);
+    } else if (auto shape = stmt->cast<ExternalTensorShapeAlongAxisStmt>()) {
+      remap(shape->arg_id);
+    } else if (auto base_ptr = stmt->cast<ExternalTensorBasePtrStmt>()) {
+      remap(base_ptr->arg_id);
+    }
+    return false;
+  });
+}
+
+/* Concatenates the bodies of the kernels of |group| into a new kernel. The
+ * kernels of a dispatch run one after another and so do the offloaded tasks
+ * of a kernel, so this never changes the result. Parameters bound to the same
+ * graph argument are shared, so that the fused kernel takes each ndarray
+ * once.
+ *
+ * The fused kernel saves launches only: offload fusion does not merge a task
+ * with one that reads the ndarrays it writes, since ndarray arguments may
+ * alias.
+ */
+aot::CompiledDispatch fuse_dispatches(
+    const std::vector<aot::CompiledDispatch> &group,
+    std::vector<std::shared_ptr<Kernel>> &fused_kernels) {
+  aot::CompiledDispatch fused;
+  std::vector<CallableBase::Parameter> params;
+  std::unordered_map<std::string, std::vector<int>> params_of_arg;
+  auto body = std::make_unique<Block>();
+  Hash128Builder hasher;
+  for (const auto &dispatch : group) {
+    Kernel *kernel = dispatch.ti_kernel;
+    std::vector<int> new_ids;
+    for (int i = 0; i < (int)kernel->parameter_list.size(); i++) {
+      const auto &param = kernel->parameter_list[i];
+      const auto &arg = dispatch.symbolic_args[i];
+      auto &candidates = params_of_arg[arg.name];
+      auto iter = std::find_if(candidates.begin(), candidates.end(),
+                               [&](int id) { return params[id] == param; });
+      if (iter != candidates.end()) {
+        new_ids.push_back(*iter);
+        continue;
+      }
+      new_ids.push_back((int)params.size());
+      candidates.push_back(new_ids.back());
+      params.push_back(param);
+      params.back().name = arg.name;
+      fused.symbolic_args.push_back(arg);
+    }
+    auto kernel_body = clone_to_chi_ir(kernel);
+    remap_arg_ids(kernel_body.get(), new_ids);
+    for (auto &stmt : kernel_body->statements) {
+      body->insert(std::move(stmt));
+    }
+
+    hasher.update(dispatch.kernel_name.data(), dispatch.kernel_name.size());
+    hasher.update_pod('\0');
+    hasher.update(new_ids.data(), new_ids.size() * sizeof(int));
+    hasher.update_pod((int)new_ids.size());
+  }
+  irpass::re_id(body.get());
+
+  // Kernels made from CHI IR are cached under their names, which therefore
+  // identify the fused kernels and the bindings of their parameters.
+  fused.kernel_name =
+      fmt::format("{}_graph_fused_{}", group.front().kernel_name,
+                  hasher.finish().to_hex().substr(0, 16));
+  auto kernel = std::make_shared<Kernel>(*group.front().ti_kernel->program,
+                                         std::move(body), fused.kernel_name);
+  for (const auto &param : params) {
+    kernel->insert_param(param);
+  }
+  kernel->finalize_params();
+  kernel->finalize_rets();
+  fused.ti_kernel = kernel.get();
+  fused_kernels.push_back(std::move(kernel));
+  return fused;
+}
+
+void fuse_consecutive_dispatches(aot::CompiledGraph &graph) {
+  std::vector<aot::CompiledDispatch> dispatches;
+  std::vector<aot::CompiledDispatch> group;
+  std::size_t num_params = 0;
+  auto flush = [&]() {
+    if (group.size() > 1) {
+      dispatches.push_back(fuse_dispatches(group, graph.fused_kernels));
+    } else {
+      dispatches.insert(dispatches.end(), group.begin(), group.end());
+    }
+    group.clear();
+    num_params = 0;
+  };
+  for (const auto &dispatch : graph.dispatches) {
+    if (!is_fusable(dispatch)) {
+      flush();
+      dispatches.push_back(dispatch);
+      continue;
+    }
+    const auto n = dispatch.ti_kernel->parameter_list.size();
+    if (!group.empty() &&
+        (num_params + n > kMaxFusedParams ||
+         dispatch.ti_kernel->program != group.front().ti_kernel->program)) {
+      flush();
+    }
+    group.push_back(dispatch);
+    num_params += n;
+  }
+  flush();
+  graph.dispatches = std::move(dispatches);
+}
+
+}  // namespace
 void Dispatch::compile(
     std::vector<aot::CompiledDispatch> &compiled_dispatches) {
   aot::CompiledDispatch dispatch;
@@ -57,6 +206,10 @@ std::unique_ptr<aot::CompiledGraph> GraphBuilder::compile() {
   std::vector<aot::CompiledDispatch> dispatches;
   seq()->compile(dispatches);
   aot::CompiledGraph graph{dispatches, all_args_};
+  if (!dispatches.empty() && dispatches.front().ti_kernel &&
+      dispatches.front().ti_kernel->program->compile_config().graph_fusion) {
+    fuse_consecutive_dispatches(graph);
+  }
   return std::make_unique<aot::CompiledGraph>(std::move(graph));
 }
 
@@ -60,6 +60,9 @@ class GraphBuilder {
   explicit GraphBuilder();
 
   // TODO: compile() can take in Arch argument
+  // Flattens the graph into a list of dispatches. With
+  // CompileConfig::graph_fusion, each run of consecutive dispatches is
+  // compiled into a single kernel, so that it is launched once.
   std::unique_ptr<aot::CompiledGraph> compile();
 
   Node *new_dispatch_node(Kernel *kernel, const std::vector<aot::Arg> &args);
@@ -186,6 +186,8 @@ TypedConstant Ndarray::read(const std::vector<int> &I) const {
 }
 
 void Ndarray::write(const std::vector<int> &I, TypedConstant val) const {
+  // Pending launches may still read the element being overwritten.
+  prog_->synchronize();
   if (get_element_data_type()->is_primitive(PrimitiveTypeID::f16)) {
     uint16_t float16 = fp16_ieee_from_fp32_value(val.val_f32);
     std::memcpy(&val.value_bits, &float16, 4);
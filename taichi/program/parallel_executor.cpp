@@ -3,9 +3,12 @@
 
 namespace taichi::lang {
 
-ParallelExecutor::ParallelExecutor(const std::string &name, int num_threads)
+ParallelExecutor::ParallelExecutor(const std::string &name,
+                                   int num_threads,
+                                   int max_queued_tasks)
     : name_(name),
       num_threads_(num_threads),
+      max_queued_tasks_(max_queued_tasks),
       status_(ExecutorStatus::uninitialized),
       running_threads_(0) {
   if (num_threads <= 0) {
@@ -41,14 +44,18 @@ ParallelExecutor::~ParallelExecutor() {
   }
 }
 
-void ParallelExecutor::enqueue(const TaskType &func) {
+void ParallelExecutor::enqueue(const TaskType &func, int priority) {
   if (num_threads_ <= 0) {
     func();
     return;
   }
   {
-    std::lock_guard<std::mutex> _(mut_);
-    task_queue_.push_back(func);
+    std::unique_lock<std::mutex> lock(mut_);
+    while (max_queued_tasks_ > 0 &&
+           (int)task_queue_.size() >= max_queued_tasks_) {
+      space_cv_.wait(lock);
+    }
+    task_queue_.push(QueuedTask{priority, next_sequence_++, func});
   }
   worker_cv_.notify_all();
 }
@@ -94,10 +101,13 @@ void ParallelExecutor::worker_loop() {
       }
       // So long as |task_queue| is not empty, we keep running.
       if (!task_queue_.empty()) {
-        auto task = task_queue_.front();
+        auto task = task_queue_.top().func;
         running_threads_++;
-        task_queue_.pop_front();
+        task_queue_.pop();
         lock.unlock();
+        if (max_queued_tasks_ > 0) {
+          space_cv_.notify_one();
+        }
 
         // Run the task
         task();
@@ -112,7 +122,8 @@ void ParallelExecutor::worker_loop() {
     }
     if (notify_flush_cv) {
       // It is fine to notify |flush_cv_| while nobody is waiting on it.
-      flush_cv_.notify_one();
+      // Several threads may be waiting in flush(), so wake them all.
+      flush_cv_.notify_all();
     }
   }
 }
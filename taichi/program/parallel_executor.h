@@ -6,6 +6,7 @@
 #include <functional>
 #include <future>
 #include <mutex>
+#include <queue>
 #include <thread>
 #include <unordered_map>
 #include "taichi/common/core.h"
@@ -15,10 +16,17 @@ class ParallelExecutor {
  public:
   using TaskType = std::function<void()>;
 
-  explicit ParallelExecutor(const std::string &name, int num_threads);
+  // If |max_queued_tasks| is positive, enqueue() blocks while that many tasks
+  // are waiting to be picked up by a worker.
+  explicit ParallelExecutor(const std::string &name,
+                            int num_threads,
+                            int max_queued_tasks = 0);
   ~ParallelExecutor();
 
-  void enqueue(const TaskType &func);
+  // Tasks with a higher |priority| run first; tasks of the same priority run in
+  // FIFO order. Must not be called from a worker of a bounded executor, as it
+  // may block waiting for queue space.
+  void enqueue(const TaskType &func, int priority = 0);
 
   void flush();
 
@@ -33,6 +41,20 @@ class ParallelExecutor {
     finalized,
   };
 
+  struct QueuedTask {
+    int priority;
+    uint64 sequence;
+    TaskType func;
+
+    bool operator<(const QueuedTask &other) const {
+      // std::priority_queue pops the largest element first.
+      if (priority != other.priority) {
+        return priority < other.priority;
+      }
+      return sequence > other.sequence;
+    }
+  };
+
   void worker_loop();
 
   // Must be called while holding |mut|.
@@ -40,13 +62,15 @@ class ParallelExecutor {
 
   std::string name_;
   int num_threads_;
+  int max_queued_tasks_;
   std::atomic<int> thread_counter_{0};
   std::mutex mut_;
 
   // All guarded by |mut|
   ExecutorStatus status_;
   std::vector<std::thread> threads_;
-  std::deque<TaskType> task_queue_;
+  std::priority_queue<QueuedTask> task_queue_;
+  uint64 next_sequence_{0};
   int running_threads_;
 
   // Used to signal the workers that they can start polling from |task_queue|.
@@ -55,6 +79,9 @@ class ParallelExecutor {
   // * task being enqueued
   // * shutting down
   std::condition_variable worker_cv_;
+  // Used by a worker thread to unblock a caller waiting for queue space in
+  // enqueue().
+  std::condition_variable space_cv_;
   // Used by a worker thread to unblock the caller from waiting for a flush.
   //
   // TODO: Instead of having this as a member variable, we can enqueue a
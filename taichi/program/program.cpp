@@ -9,6 +9,7 @@
 #include "taichi/runtime/program_impls/opengl/opengl_program.h"
 #include "taichi/runtime/program_impls/metal/metal_program.h"
 #include "taichi/platform/cuda/detect_cuda.h"
+#include "taichi/system/compile_profiler.h"
 #include "taichi/system/timeline.h"
 #include "taichi/ir/snode.h"
 #include "taichi/ir/frontend_ir.h"
@@ -155,6 +156,7 @@ Program::Program(Arch desired_arch) : snode_rw_accessors_bank_(this) {
   }
 
   Timelines::get_instance().set_enabled(config.timeline);
+  CompileProfiler::get_instance().set_enabled(config.compile_profiler);
 
   TI_TRACE("Program ({}) arch={} initialized.", fmt::ptr(this),
            arch_name(config.arch));
@@ -187,6 +189,22 @@ const CompiledKernelData &Program::compile_kernel(
   return ckd;
 }
 
+void Program::compile_kernels(const CompileConfig &compile_config,
+                              const DeviceCapabilityConfig &caps,
+                              const std::vector<Kernel *> &kernels) {
+  auto start_t = Time::get_time();
+  TI_AUTO_PROF;
+  std::vector<KernelCompilationManager::CompileRequest> requests;
+  requests.reserve(kernels.size());
+  for (int i = 0; i < (int)kernels.size(); i++) {
+    requests.push_back({kernels[i], (int)kernels.size() - i});
+  }
+  auto &mgr = program_impl_->get_kernel_compilation_manager();
+  auto num_compiled = mgr.compile_kernels(compile_config, caps, requests);
+  TI_TRACE("Compiled {} of {} kernels in batch", num_compiled, kernels.size());
+  total_compilation_time_ += Time::get_time() - start_t;
+}
+
 void Program::launch_kernel(const CompiledKernelData &compiled_kernel_data,
                             LaunchContextBuilder &ctx) {
   program_impl_->get_kernel_launcher().launch_kernel(compiled_kernel_data, ctx);
@@ -197,6 +215,14 @@ void Program::launch_kernel(const CompiledKernelData &compiled_kernel_data,
 
 void Program::materialize_runtime() {
   program_impl_->materialize_runtime(profiler.get(), &result_buffer);
+
+  // Load recently used kernels while the Python program keeps initializing.
+  const auto &config = compile_config();
+  if (config.offline_cache && config.offline_cache_warm_up_kernels > 0) {
+    program_impl_->get_kernel_compilation_manager().warm_up(
+        config.arch, config.offline_cache_warm_up_kernels,
+        config.num_compile_threads);
+  }
 }
 
 static void remove_rw_accessor_cache(
@@ -130,6 +130,13 @@ class TI_DLL_EXPORT Program {
                                            const DeviceCapabilityConfig &caps,
                                            const Kernel &kernel_def);
 
+  // Compiles a batch of kernels (e.g. a recorded warm-up list) concurrently.
+  // Earlier kernels are compiled first. Kernels that are already cached are
+  // skipped; the rest are cached in memory for subsequent compile_kernel().
+  void compile_kernels(const CompileConfig &compile_config,
+                       const DeviceCapabilityConfig &caps,
+                       const std::vector<Kernel *> &kernels);
+
   void launch_kernel(const CompiledKernelData &compiled_kernel_data,
                      LaunchContextBuilder &ctx);
 
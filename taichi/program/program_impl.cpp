@@ -25,6 +25,8 @@ KernelCompilationManager &ProgramImpl::get_kernel_compilation_manager() {
   }
   KernelCompilationManager::Config cfg;
   cfg.offline_cache_path = config->offline_cache_file_path;
+  cfg.single_file = config->offline_cache_single_file;
+  cfg.multi_process = config->offline_cache_multi_process;
   cfg.kernel_compiler = make_kernel_compiler();
   kernel_com_mgr_ = std::make_unique<KernelCompilationManager>(std::move(cfg));
   return *kernel_com_mgr_;
@@ -23,6 +23,7 @@
 #include "taichi/program/matrix.h"
 #include "taichi/python/export.h"
 #include "taichi/math/svd.h"
+#include "taichi/system/compile_profiler.h"
 #include "taichi/system/timeline.h"
 #include "taichi/python/snode_registry.h"
 #include "taichi/program/sparse_matrix.h"
@@ -194,14 +195,20 @@ void export_lang(py::module &m) {
       .def_readwrite("saturating_grid_dim", &CompileConfig::saturating_grid_dim)
       .def_readwrite("max_block_dim", &CompileConfig::max_block_dim)
       .def_readwrite("cpu_max_num_threads", &CompileConfig::cpu_max_num_threads)
+      .def_readwrite("cpu_async_launch", &CompileConfig::cpu_async_launch)
       .def_readwrite("random_seed", &CompileConfig::random_seed)
       .def_readwrite("verbose_kernel_launches",
                      &CompileConfig::verbose_kernel_launches)
       .def_readwrite("verbose", &CompileConfig::verbose)
       .def_readwrite("demote_dense_struct_fors",
                      &CompileConfig::demote_dense_struct_fors)
+      .def_readwrite("listgen_reuse", &CompileConfig::listgen_reuse)
+      .def_readwrite("offload_fusion", &CompileConfig::offload_fusion)
+      .def_readwrite("graph_fusion", &CompileConfig::graph_fusion)
       .def_readwrite("kernel_profiler", &CompileConfig::kernel_profiler)
       .def_readwrite("timeline", &CompileConfig::timeline)
+      .def_readwrite("compile_profiler", &CompileConfig::compile_profiler)
+      .def_readwrite("llvm_task_cache", &CompileConfig::llvm_task_cache)
       .def_readwrite("default_fp", &CompileConfig::default_fp)
       .def_readwrite("default_ip", &CompileConfig::default_ip)
       .def_readwrite("default_up", &CompileConfig::default_up)
@@ -212,6 +219,9 @@ void export_lang(py::module &m) {
       .def_readwrite("advanced_optimization",
                      &CompileConfig::advanced_optimization)
       .def_readwrite("ad_stack_size", &CompileConfig::ad_stack_size)
+      .def_readwrite("ad_checkpointing", &CompileConfig::ad_checkpointing)
+      .def_readwrite("ad_block_local_adjoints",
+                     &CompileConfig::ad_block_local_adjoints)
       .def_readwrite("flatten_if", &CompileConfig::flatten_if)
       .def_readwrite("make_thread_local", &CompileConfig::make_thread_local)
       .def_readwrite("make_block_local", &CompileConfig::make_block_local)
@@ -221,8 +231,11 @@ void export_lang(py::module &m) {
       .def_readwrite("force_scalarize_matrix",
                      &CompileConfig::force_scalarize_matrix)
       .def_readwrite("half2_vectorization", &CompileConfig::half2_vectorization)
+      .def_readwrite("slp_vectorization", &CompileConfig::slp_vectorization)
       .def_readwrite("make_cpu_multithreading_loop",
                      &CompileConfig::make_cpu_multithreading_loop)
+      .def_readwrite("cpu_loop_tiling", &CompileConfig::cpu_loop_tiling)
+      .def_readwrite("cpu_loop_tile_size", &CompileConfig::cpu_loop_tile_size)
       .def_readwrite("quant_opt_store_fusion",
                      &CompileConfig::quant_opt_store_fusion)
       .def_readwrite("quant_opt_atomic_demotion",
@@ -254,6 +267,12 @@ void export_lang(py::module &m) {
                      &CompileConfig::offline_cache_max_size_of_files)
       .def_readwrite("offline_cache_cleaning_factor",
                      &CompileConfig::offline_cache_cleaning_factor)
+      .def_readwrite("offline_cache_single_file",
+                     &CompileConfig::offline_cache_single_file)
+      .def_readwrite("offline_cache_multi_process",
+                     &CompileConfig::offline_cache_multi_process)
+      .def_readwrite("offline_cache_warm_up_kernels",
+                     &CompileConfig::offline_cache_warm_up_kernels)
       .def_readwrite("num_compile_threads", &CompileConfig::num_compile_threads)
       .def_readwrite("vk_api_version", &CompileConfig::vk_api_version)
       .def_readwrite("cuda_stack_limit", &CompileConfig::cuda_stack_limit);
@@ -393,6 +412,12 @@ void export_lang(py::module &m) {
            [](Program *, const std::string &fn) {
              Timelines::get_instance().save(fn);
            })
+      .def("compile_profiler_clear",
+           [](Program *) { CompileProfiler::get_instance().clear(); })
+      .def("compile_profiler_save",
+           [](Program *, const std::string &fn) {
+             CompileProfiler::get_instance().save(fn);
+           })
       .def("print_memory_profiler_info", &Program::print_memory_profiler_info)
       .def("finalize", &Program::finalize)
       .def("get_total_compilation_time", &Program::get_total_compilation_time)
@@ -484,12 +509,14 @@ void export_lang(py::module &m) {
            [](Program *program) { return program->get_graphics_device(); })
       .def("compile_kernel", &Program::compile_kernel,
            py::return_value_policy::reference)
+      .def("compile_kernels", &Program::compile_kernels)
       .def("launch_kernel", &Program::launch_kernel)
       .def("get_device_caps", &Program::get_device_caps);
 
   py::class_<AotModuleBuilder>(m, "AotModuleBuilder")
       .def("add_field", &AotModuleBuilder::add_field)
       .def("add", &AotModuleBuilder::add)
+      .def("add_kernels", &AotModuleBuilder::add_kernels)
       .def("add_kernel_template", &AotModuleBuilder::add_kernel_template)
       .def("add_graph", &AotModuleBuilder::add_graph)
       .def("dump", &AotModuleBuilder::dump);
@@ -507,16 +534,14 @@ void export_lang(py::module &m) {
                                const std::vector<int> &,
                                const DebugInfo &))(&SNode::dense),
            py::return_value_policy::reference)
+      .def("morton_dense", &SNode::morton_dense,
+           py::return_value_policy::reference)
       .def("pointer",
            (SNode & (SNode::*)(const std::vector<Axis> &,
                                const std::vector<int> &,
                                const DebugInfo &))(&SNode::pointer),
            py::return_value_policy::reference)
-      .def("hash",
-           (SNode & (SNode::*)(const std::vector<Axis> &,
-                               const std::vector<int> &,
-                               const DebugInfo &))(&SNode::hash),
-           py::return_value_policy::reference)
+      .def("hash", &SNode::hash, py::return_value_policy::reference)
       .def("dynamic", &SNode::dynamic, py::return_value_policy::reference)
       .def("bitmasked",
            (SNode & (SNode::*)(const std::vector<Axis> &,
@@ -662,6 +687,9 @@ void export_lang(py::module &m) {
       .def("seq", &GraphBuilder::seq, py::return_value_policy::reference);
 
   py::class_<aot::CompiledGraph>(m, "CompiledGraph")
+      .def_property_readonly(
+          "num_dispatches",
+          [](aot::CompiledGraph *self) { return self->dispatches.size(); })
       .def("jit_run", [](aot::CompiledGraph *self,
                          const CompileConfig &compile_config,
                          const py::dict &pyargs) {
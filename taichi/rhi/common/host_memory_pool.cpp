@@ -1,6 +1,9 @@
 #include "taichi/rhi/common/host_memory_pool.h"
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
+#include <unordered_map>
 
 #if defined(TI_PLATFORM_UNIX)
 #include <sys/mman.h>
@@ -10,8 +13,97 @@
 
 namespace taichi::lang {
 
+namespace {
+
+// Blocks moved between a thread cache and the allocator at a time
+constexpr std::size_t kThreadCacheBatchBytes = 64 << 10;
+constexpr std::size_t kThreadCacheMaxBatchBlocks = 32;
+
+std::size_t thread_cache_batch_size(int size_class) {
+  return std::clamp<std::size_t>(
+      kThreadCacheBatchBytes / UnifiedAllocator::get_class_size(size_class),
+      1, kThreadCacheMaxBatchBlocks);
+}
+
+// Live pool generations. A thread cache may outlive the generation it was
+// filled from (reset(), or the pool being destroyed); its blocks are only
+// handed back if the generation is still registered.
+struct PoolRegistry {
+  std::mutex mut;
+  std::unordered_map<uint64, HostMemoryPool *> pools;
+};
+
+PoolRegistry &get_pool_registry() {
+  // Leaked so that thread caches can be flushed during static destruction
+  static PoolRegistry *registry = new PoolRegistry();
+  return *registry;
+}
+
+std::atomic<uint64> next_pool_generation{1};
+
+void update_max(std::atomic<std::size_t> &max, std::size_t value) {
+  std::size_t old = max.load(std::memory_order_relaxed);
+  while (old < value && !max.compare_exchange_weak(old, value,
+                                                   std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+struct HostMemoryPool::ThreadCache {
+  HostMemoryPool *pool{nullptr};
+  uint64 generation{0};
+  std::vector<std::vector<void *>> blocks;
+
+  ~ThreadCache() {
+    flush();
+  }
+
+  // Hands all cached blocks back to their pool, if it is still alive.
+  void flush() {
+    if (pool) {
+      auto &registry = get_pool_registry();
+      std::lock_guard<std::mutex> _(registry.mut);
+      auto iter = registry.pools.find(generation);
+      if (iter != registry.pools.end() && iter->second == pool) {
+        std::lock_guard<std::mutex> __(pool->mut_allocation_);
+        for (int i = 0; i < (int)blocks.size(); i++) {
+          pool->allocator_->release_blocks(i, blocks[i].data(),
+                                           blocks[i].size());
+        }
+      }
+    }
+    for (auto &list : blocks) {
+      list.clear();
+    }
+    pool = nullptr;
+  }
+
+  std::vector<std::vector<void *>> &bind(HostMemoryPool *new_pool,
+                                         uint64 new_generation) {
+    if (pool != new_pool || generation != new_generation) {
+      flush();
+      pool = new_pool;
+      generation = new_generation;
+      blocks.resize(UnifiedAllocator::get_num_size_classes());
+    }
+    return blocks;
+  }
+};
+
+HostMemoryPool::ThreadCache &HostMemoryPool::get_thread_cache() {
+  thread_local ThreadCache cache;
+  return cache;
+}
+
 HostMemoryPool::HostMemoryPool() {
-  allocator_ = std::unique_ptr<UnifiedAllocator>(new UnifiedAllocator());
+  allocator_ = std::unique_ptr<UnifiedAllocator>(new UnifiedAllocator(this));
+  generation_ = next_pool_generation++;
+  {
+    auto &registry = get_pool_registry();
+    std::lock_guard<std::mutex> _(registry.mut);
+    registry.pools[generation_] = this;
+  }
 
   TI_TRACE("Memory pool created. Default buffer size per allocator = {} MB",
            UnifiedAllocator::default_allocator_size / 1024 / 1024);
@@ -20,22 +112,70 @@ HostMemoryPool::HostMemoryPool() {
 void *HostMemoryPool::allocate(std::size_t size,
                                std::size_t alignment,
                                bool exclusive) {
+  // Size classes serve "exclusive" allocations as well: a released block is
+  // reused instead of being unmapped.
+  const int size_class = UnifiedAllocator::get_size_class(size, alignment);
+  if (size_class >= 0) {
+    auto &blocks = get_thread_cache().bind(this, generation_)[size_class];
+    if (blocks.empty()) {
+      std::lock_guard<std::mutex> _(mut_allocation_);
+      if (!allocator_) {
+        TI_ERROR("Memory pool is already destroyed");
+      }
+      const auto num_carved = allocator_->allocate_blocks(
+          size_class, thread_cache_batch_size(size_class), blocks);
+      bytes_cached_ += num_carved * UnifiedAllocator::get_class_size(size_class);
+    }
+    void *ret = blocks.back();
+    blocks.pop_back();
+    bytes_cached_ -= UnifiedAllocator::get_class_size(size_class);
+    record_allocation(size, size_class);
+    return ret;
+  }
+
   std::lock_guard<std::mutex> _(mut_allocation_);
 
   if (!allocator_) {
     TI_ERROR("Memory pool is already destroyed");
   }
   void *ret = allocator_->allocate(size, alignment, exclusive);
+  record_allocation(size, -1);
   return ret;
 }
 
-void HostMemoryPool::release(std::size_t size, void *ptr) {
+void HostMemoryPool::release(std::size_t size,
+                             void *ptr,
+                             std::size_t alignment) {
+  const int size_class = UnifiedAllocator::get_size_class(size, alignment);
+  if (size_class >= 0) {
+    // Callers such as the LLVM runtime rely on fresh memory being zeroed, like
+    // the pages mapped for new chunks. Only the first |size| bytes of the
+    // block can have been written.
+    std::memset(ptr, 0, size);
+    record_release(size, size_class);
+    bytes_cached_ += UnifiedAllocator::get_class_size(size_class);
+    auto &blocks = get_thread_cache().bind(this, generation_)[size_class];
+    blocks.push_back(ptr);
+    const auto batch_size = thread_cache_batch_size(size_class);
+    if (blocks.size() > 2 * batch_size) {
+      // Return the least recently released blocks to the shared free list
+      std::lock_guard<std::mutex> _(mut_allocation_);
+      if (!allocator_) {
+        TI_ERROR("Memory pool is already destroyed");
+      }
+      allocator_->release_blocks(size_class, blocks.data(), batch_size);
+      blocks.erase(blocks.begin(), blocks.begin() + batch_size);
+    }
+    return;
+  }
+
   std::lock_guard<std::mutex> _(mut_allocation_);
 
   if (!allocator_) {
     TI_ERROR("Memory pool is already destroyed");
   }
 
+  record_release(size, -1);
   if (allocator_->release(size, ptr)) {
     if (dynamic_cast<UnifiedAllocator *>(allocator_.get())) {
       deallocate_raw_memory(ptr);  // release raw memory as well
@@ -43,6 +183,42 @@ void HostMemoryPool::release(std::size_t size, void *ptr) {
   }
 }
 
+void HostMemoryPool::record_allocation(std::size_t size, int size_class) {
+  update_max(high_water_mark_, bytes_in_use_ += size);
+  if (size_class >= 0) {
+    small_bytes_in_use_ += size;
+    small_bytes_rounded_ += UnifiedAllocator::get_class_size(size_class);
+  }
+}
+
+void HostMemoryPool::record_release(std::size_t size, int size_class) {
+  bytes_in_use_ -= size;
+  if (size_class >= 0) {
+    small_bytes_in_use_ -= size;
+    small_bytes_rounded_ -= UnifiedAllocator::get_class_size(size_class);
+  }
+}
+
+HostMemoryPool::Stats HostMemoryPool::get_stats() {
+  Stats stats;
+  stats.bytes_in_use = bytes_in_use_;
+  stats.bytes_cached = bytes_cached_;
+  stats.high_water_mark = high_water_mark_;
+  {
+    std::lock_guard<std::mutex> _(mut_allocation_);
+    if (allocator_) {
+      for (const auto &chunk : allocator_->chunks_) {
+        stats.bytes_reserved += (std::size_t)chunk.tail - (std::size_t)chunk.data;
+      }
+    }
+  }
+  const std::size_t held = small_bytes_rounded_ + stats.bytes_cached;
+  if (held > 0) {
+    stats.fragmentation = 1.0 - (double)small_bytes_in_use_ / held;
+  }
+  return stats;
+}
+
 void *HostMemoryPool::allocate_raw_memory(std::size_t size) {
   /*
     Be aware that this methods is not protected by the mutex.
@@ -112,17 +288,33 @@ void HostMemoryPool::deallocate_raw_memory(void *ptr) {
 }
 
 void HostMemoryPool::reset() {
+  auto &registry = get_pool_registry();
+  // Thread caches of the old generation are dropped without being touched
+  std::lock_guard<std::mutex> registry_lock(registry.mut);
+  registry.pools.erase(generation_);
+
   std::lock_guard<std::mutex> _(mut_allocation_);
-  allocator_ = std::unique_ptr<UnifiedAllocator>(new UnifiedAllocator());
+  allocator_ = std::unique_ptr<UnifiedAllocator>(new UnifiedAllocator(this));
+  generation_ = next_pool_generation++;
+  registry.pools[generation_] = this;
 
   const auto ptr_map_copied = raw_memory_chunks_;
   for (auto &ptr : ptr_map_copied) {
     deallocate_raw_memory(ptr.first);
   }
+
+  bytes_in_use_ = 0;
+  small_bytes_in_use_ = 0;
+  small_bytes_rounded_ = 0;
+  bytes_cached_ = 0;
+  high_water_mark_ = 0;
 }
 
 HostMemoryPool::~HostMemoryPool() {
   reset();
+  auto &registry = get_pool_registry();
+  std::lock_guard<std::mutex> _(registry.mut);
+  registry.pools.erase(generation_);
 }
 
 const size_t HostMemoryPool::page_size{1 << 12};  // 4 KB page size by default
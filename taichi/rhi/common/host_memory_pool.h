@@ -2,6 +2,7 @@
 #include "taichi/common/core.h"
 #include "taichi/rhi/common/unified_allocator.h"
 #include "taichi/rhi/device.h"
+#include <atomic>
 #include <mutex>
 #include <vector>
 #include <memory>
@@ -10,22 +11,50 @@
 namespace taichi::lang {
 
 // A memory pool that runs on the host
+//
+// Small allocations are recycled through size classes (see UnifiedAllocator).
+// Each thread keeps a short free list per class so that the common
+// allocate/release pair does not take the pool mutex. |size| and |alignment|
+// passed to release() should match those passed to allocate(); a smaller
+// alignment is safe but the block is then recycled into a smaller class.
+// Released blocks are zeroed, so allocate() always returns zeroed memory.
 
 class TI_DLL_EXPORT HostMemoryPool {
  public:
   static const size_t page_size;
 
+  struct Stats {
+    // Bytes requested by live allocations
+    std::size_t bytes_in_use{0};
+    // Bytes in released blocks kept for reuse (including thread caches)
+    std::size_t bytes_cached{0};
+    // Virtual address space obtained from the OS
+    std::size_t bytes_reserved{0};
+    // Peak of |bytes_in_use| since the last reset()
+    std::size_t high_water_mark{0};
+    // Share of the memory held by size classes that does not back live
+    // data, i.e. rounding slack plus cached blocks
+    double fragmentation{0.0};
+  };
+
   static HostMemoryPool &get_instance();
 
   void *allocate(std::size_t size,
                  std::size_t alignment,
                  bool exclusive = false);
-  void release(std::size_t size, void *ptr);
+  void release(std::size_t size, void *ptr, std::size_t alignment = 1);
   void reset();
+  Stats get_stats();
   HostMemoryPool();
   ~HostMemoryPool();
 
  protected:
+  struct ThreadCache;
+
+  static ThreadCache &get_thread_cache();
+
+  void record_allocation(std::size_t size, int size_class);
+  void record_release(std::size_t size, int size_class);
   void *allocate_raw_memory(std::size_t size);
   void deallocate_raw_memory(void *ptr);
 
@@ -36,6 +65,16 @@ class TI_DLL_EXPORT HostMemoryPool {
   std::unique_ptr<UnifiedAllocator> allocator_;
   std::mutex mut_allocation_;
 
+  // Identifies the current allocator_; thread caches filled from another
+  // generation are stale
+  std::atomic<uint64> generation_{0};
+
+  std::atomic<std::size_t> bytes_in_use_{0};
+  std::atomic<std::size_t> small_bytes_in_use_{0};
+  std::atomic<std::size_t> small_bytes_rounded_{0};
+  std::atomic<std::size_t> bytes_cached_{0};
+  std::atomic<std::size_t> high_water_mark_{0};
+
   friend class UnifiedAllocator;
 };
 
@@ -2,6 +2,7 @@
 
 #include "taichi/rhi/common/unified_allocator.h"
 #include "taichi/rhi/common/host_memory_pool.h"
+#include <algorithm>
 #include <string>
 
 namespace taichi::lang {
@@ -9,6 +10,54 @@ namespace taichi::lang {
 std::size_t UnifiedAllocator::default_allocator_size =
     1 << 30;  // 1 GB per allocator
 
+namespace {
+
+// Four classes per power of two (2^k * {1, 1.25, 1.5, 1.75}) keep the
+// internal fragmentation of a block below 25%.
+const std::vector<std::size_t> &size_classes() {
+  static const std::vector<std::size_t> classes = [] {
+    std::vector<std::size_t> ret;
+    for (std::size_t base = UnifiedAllocator::kMinSmallSize;
+         base < UnifiedAllocator::kMaxSmallSize; base *= 2) {
+      for (std::size_t i = 0; i < 4; i++) {
+        ret.push_back(base + base / 4 * i);
+      }
+    }
+    ret.push_back(UnifiedAllocator::kMaxSmallSize);
+    return ret;
+  }();
+  return classes;
+}
+
+// Blocks of a class are carved back to back, so each of them is aligned to
+// the largest power of two dividing the class size (capped at a page).
+std::size_t block_alignment(std::size_t class_size) {
+  return std::min(class_size & (~class_size + 1), HostMemoryPool::page_size);
+}
+
+}  // namespace
+
+int UnifiedAllocator::get_size_class(std::size_t size, std::size_t alignment) {
+  if (size > kMaxSmallSize || alignment > HostMemoryPool::page_size) {
+    return -1;
+  }
+  const auto &classes = size_classes();
+  auto it = std::lower_bound(classes.begin(), classes.end(),
+                             std::max(size, kMinSmallSize));
+  while (it != classes.end() && block_alignment(*it) < alignment) {
+    ++it;
+  }
+  return it == classes.end() ? -1 : int(it - classes.begin());
+}
+
+std::size_t UnifiedAllocator::get_class_size(int size_class) {
+  return size_classes()[size_class];
+}
+
+int UnifiedAllocator::get_num_size_classes() {
+  return int(size_classes().size());
+}
+
 template <typename T>
 static void swap_erase_vector(std::vector<T> &vec, size_t idx) {
   bool is_last = idx == vec.size() - 1;
@@ -24,18 +73,63 @@ static void swap_erase_vector(std::vector<T> &vec, size_t idx) {
   // search for reusable memory
 }
 
-UnifiedAllocator::UnifiedAllocator() {
+UnifiedAllocator::UnifiedAllocator(HostMemoryPool *pool)
+    : pool_(pool), free_blocks_(get_num_size_classes()) {
+}
+
+std::size_t UnifiedAllocator::allocate_blocks(int size_class,
+                                              std::size_t count,
+                                              std::vector<void *> &blocks) {
+  auto &free_list = free_blocks_[size_class];
+  const std::size_t num_reused = std::min(count, free_list.size());
+  blocks.insert(blocks.end(), free_list.end() - num_reused, free_list.end());
+  free_list.resize(free_list.size() - num_reused);
+  if (num_reused == count) {
+    return 0;
+  }
+
+  // Carve the rest as one contiguous run. They are appended from the highest
+  // address down so that callers popping from the back hand them out in
+  // address order.
+  const std::size_t num_carved = count - num_reused;
+  const std::size_t class_size = get_class_size(size_class);
+  auto base = (std::size_t)allocate_from_chunks(class_size * num_carved,
+                                                block_alignment(class_size));
+  for (std::size_t i = num_carved; i-- > 0;) {
+    blocks.push_back((void *)(base + i * class_size));
+  }
+  return num_carved;
+}
+
+void UnifiedAllocator::release_blocks(int size_class,
+                                      void *const *blocks,
+                                      std::size_t count) {
+  auto &free_list = free_blocks_[size_class];
+  free_list.insert(free_list.end(), blocks, blocks + count);
 }
 
 void *UnifiedAllocator::allocate(std::size_t size,
                                  std::size_t alignment,
                                  bool exclusive) {
-  // UnifiedAllocator never reuses the previously allocated memory
-  // just move the head forward util depleting all the free memory
+  // Small allocations are served by allocate_blocks(). What reaches here is
+  // either too large for a size class, which gets a dedicated chunk so that
+  // release() can return it to the OS, or over-aligned, which is bumped from
+  // the shared chunks and never reused.
 
   // Note: put mutex on MemoryPool instead of Allocator, since Allocators are
   // transparent to user code
-  if (!chunks_.empty() && !exclusive) {
+  if (size > kMaxSmallSize && alignment <= HostMemoryPool::page_size) {
+    exclusive = true;
+  }
+  if (!exclusive) {
+    return allocate_from_chunks(size, alignment);
+  }
+  return allocate_chunk(size, exclusive);
+}
+
+void *UnifiedAllocator::allocate_from_chunks(std::size_t size,
+                                             std::size_t alignment) {
+  if (!chunks_.empty()) {
     // Search for a non-exclusive chunk that has enough space
     for (size_t chunk_id = 0; chunk_id < chunks_.size(); chunk_id++) {
       auto &chunk = chunks_[chunk_id];
@@ -58,7 +152,10 @@ void *UnifiedAllocator::allocate(std::size_t size,
     }
   }
 
-  // Allocate a new chunk
+  return allocate_chunk(size, /*exclusive=*/false);
+}
+
+void *UnifiedAllocator::allocate_chunk(std::size_t size, bool exclusive) {
   MemoryChunk chunk;
 
   std::size_t allocation_size = size;
@@ -71,11 +168,10 @@ void *UnifiedAllocator::allocate(std::size_t size,
   TI_TRACE("Allocating virtual address space of size {} MB",
            allocation_size / 1024 / 1024);
 
-  void *ptr =
-      HostMemoryPool::get_instance().allocate_raw_memory(allocation_size);
+  void *ptr = pool_->allocate_raw_memory(allocation_size);
   chunk.data = ptr;
   chunk.head = (void *)((std::size_t)chunk.data + size);
-  chunk.tail = (void *)((std::size_t)chunk.head + allocation_size);
+  chunk.tail = (void *)((std::size_t)chunk.data + allocation_size);
   chunk.is_exclusive = exclusive;
 
   TI_ASSERT(chunk.data != nullptr);
@@ -86,15 +182,13 @@ void *UnifiedAllocator::allocate(std::size_t size,
 }
 
 bool UnifiedAllocator::release(size_t sz, void *ptr) {
-  // UnifiedAllocator is special in that it never reuses the previously
-  // allocated memory We have to release the entire memory chunk to avoid memory
-  // leak
+  // Only dedicated chunks are released here; small blocks go back to their
+  // free lists through release_blocks()
   int remove_idx = -1;
   for (size_t chunk_idx = 0; chunk_idx < chunks_.size(); chunk_idx++) {
     auto &chunk = chunks_[chunk_idx];
 
-    if (chunk.data == ptr) {
-      TI_ASSERT(chunk.is_exclusive);
+    if (chunk.data == ptr && chunk.is_exclusive) {
       remove_idx = chunk_idx;
     }
   }
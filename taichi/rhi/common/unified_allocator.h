@@ -12,6 +12,12 @@ namespace taichi::lang {
 class HostMemoryPool;
 
 // This class can only be accessed by MemoryPool
+//
+// Allocations up to kMaxSmallSize are served from size classes: blocks of a
+// class are carved contiguously from the shared (non-exclusive) chunks and
+// recycled through per-class free lists, so releasing them makes them
+// available to later allocations of the same class. Larger allocations get a
+// dedicated chunk that is returned to the OS on release.
 class UnifiedAllocator {
  public:
   struct MemoryChunk {
@@ -21,10 +27,21 @@ class UnifiedAllocator {
     void *tail;
   };
 
+  static constexpr std::size_t kMinSmallSize = 16;
+  static constexpr std::size_t kMaxSmallSize = 1 << 20;  // 1 MB
+
+  // Returns the size class that can hold |size| bytes aligned to |alignment|,
+  // or -1 if the allocation should get a dedicated chunk. A smaller alignment
+  // never yields a larger class, so a block released with a smaller alignment
+  // than it was allocated with is still valid for its (smaller) class.
+  static int get_size_class(std::size_t size, std::size_t alignment);
+  static std::size_t get_class_size(int size_class);
+  static int get_num_size_classes();
+
  private:
   static std::size_t default_allocator_size;
 
-  UnifiedAllocator();
+  explicit UnifiedAllocator(HostMemoryPool *pool);
 
   void *allocate(std::size_t size,
                  std::size_t alignment,
@@ -32,7 +49,19 @@ class UnifiedAllocator {
 
   bool release(size_t sz, void *ptr);
 
+  // Appends up to |count| blocks of |size_class| to |blocks|, preferring
+  // previously released ones. Returns the number of newly carved blocks.
+  std::size_t allocate_blocks(int size_class,
+                              std::size_t count,
+                              std::vector<void *> &blocks);
+  void release_blocks(int size_class, void *const *blocks, std::size_t count);
+
+  void *allocate_from_chunks(std::size_t size, std::size_t alignment);
+  void *allocate_chunk(std::size_t size, bool exclusive);
+
+  HostMemoryPool *pool_;
   std::vector<MemoryChunk> chunks_;
+  std::vector<std::vector<void *>> free_blocks_;
 
   friend class HostMemoryPool;
   friend class HostMemoryPoolTestHelper;
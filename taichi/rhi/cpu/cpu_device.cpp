@@ -68,7 +68,8 @@ void CpuDevice::dealloc_memory(DeviceAllocation handle) {
     TI_ERROR("the DeviceAllocation is already deallocated");
   }
   if (!info.use_cached) {
-    HostMemoryPool::get_instance().release(info.size, info.ptr);
+    HostMemoryPool::get_instance().release(info.size, info.ptr,
+                                           HostMemoryPool::page_size);
     info.ptr = nullptr;
   }
 }
@@ -1,5 +1,6 @@
 #include "taichi/rhi/llvm/allocator.h"
 #include "taichi/runtime/llvm/snode_tree_buffer_manager.h"
+#include "taichi/util/bit.h"
 
 namespace taichi::lang {
 
@@ -7,64 +8,120 @@ CachingAllocator::CachingAllocator(bool merge_upon_release)
     : merge_upon_release_(merge_upon_release) {
 }
 
+int CachingAllocator::get_bin(std::size_t size) {
+  const std::size_t num_pages = size / taichi_page_size;
+  if (num_pages <= 1) {
+    return 0;
+  }
+  return std::min((int)bit::log2int(num_pages), kNumBins - 1);
+}
+
+void CachingAllocator::insert_block(uint8_t *ptr, std::size_t size) {
+  const int bin = get_bin(size);
+  bins_[bin].insert(std::make_pair(size, ptr));
+  non_empty_bins_ |= uint64_t(1) << bin;
+  ptr_map_[ptr] = size;
+  bytes_cached_ += size;
+}
+
+void CachingAllocator::erase_block(uint8_t *ptr, std::size_t size) {
+  const int bin = get_bin(size);
+  bins_[bin].erase(std::make_pair(size, ptr));
+  if (bins_[bin].empty()) {
+    non_empty_bins_ &= ~(uint64_t(1) << bin);
+  }
+  ptr_map_.erase(ptr);
+  bytes_cached_ -= size;
+}
+
 void CachingAllocator::merge_and_insert(uint8_t *ptr, std::size_t size) {
   // merge with right block
-  if (ptr_map_[ptr + size]) {
-    std::size_t tmp = ptr_map_[ptr + size];
-    mem_blocks_.erase(std::make_pair(tmp, ptr + size));
-    ptr_map_.erase(ptr + size);
+  auto map_it = ptr_map_.find(ptr + size);
+  if (map_it != ptr_map_.end()) {
+    std::size_t tmp = map_it->second;
+    erase_block(ptr + size, tmp);
     size += tmp;
   }
   // merge with left block
-  auto map_it = ptr_map_.lower_bound(ptr);
+  map_it = ptr_map_.lower_bound(ptr);
   if (map_it != ptr_map_.begin()) {
     auto x = *--map_it;
     if (x.first + x.second == ptr) {
-      mem_blocks_.erase(std::make_pair(x.second, x.first));
-      ptr_map_.erase(x.first);
+      erase_block(x.first, x.second);
       ptr = x.first;
       size += x.second;
     }
   }
-  mem_blocks_.insert(std::make_pair(size, ptr));
-  ptr_map_[ptr] = size;
+  insert_block(ptr, size);
+}
+
+uint64_t *CachingAllocator::allocate_from_cache(std::size_t size) {
+  const int bin = get_bin(size);
+  auto &candidates = bins_[bin];
+  auto it_blk = candidates.lower_bound(std::make_pair(size, nullptr));
+  if (it_blk == candidates.end()) {
+    // Every block in a higher bin fits; the first one of the lowest non-empty
+    // bin is the best fit.
+    const uint64_t higher_bins =
+        bin + 1 < kNumBins ? non_empty_bins_ >> (bin + 1) << (bin + 1) : 0;
+    if (!higher_bins) {
+      return nullptr;
+    }
+    it_blk = bins_[bit::log2int(higher_bins & (~higher_bins + 1))].begin();
+  }
+
+  auto [block_size, block_ptr] = *it_blk;
+  erase_block(block_ptr, block_size);
+  const std::size_t remaining_sz = block_size - size;
+  if (remaining_sz > 0) {
+    insert_block(block_ptr + size, remaining_sz);
+  }
+  return reinterpret_cast<uint64_t *>(block_ptr);
 }
 
 uint64_t *CachingAllocator::allocate(
     LlvmDevice *device,
     const LlvmDevice::LlvmRuntimeAllocParams &params) {
-  uint64_t *ret{nullptr};
   auto size_aligned = taichi::iroundup(params.size, taichi_page_size);
-  auto it_blk = mem_blocks_.lower_bound(std::make_pair(size_aligned, nullptr));
-
-  if (it_blk != mem_blocks_.end()) {
-    size_t remaining_sz = it_blk->first - size_aligned;
-    if (remaining_sz > 0) {
-      TI_ASSERT(remaining_sz % taichi_page_size == 0);
-      auto remaining_head =
-          reinterpret_cast<uint8_t *>(it_blk->second) + size_aligned;
-      mem_blocks_.insert(std::make_pair(remaining_sz, remaining_head));
-      ptr_map_.insert(std::make_pair(remaining_head, remaining_sz));
-    }
-    ret = reinterpret_cast<uint64_t *>(it_blk->second);
-    mem_blocks_.erase(it_blk);
-    ptr_map_.erase(it_blk->second);
-
+  uint64_t *ret = allocate_from_cache(size_aligned);
+  if (ret) {
+    num_cache_hits_++;
   } else {
+    num_cache_misses_++;
     ret = reinterpret_cast<uint64_t *>(
         device->allocate_llvm_runtime_memory_jit(params));
   }
+  bytes_in_use_ += size_aligned;
+  high_water_mark_ =
+      std::max(high_water_mark_, bytes_in_use_ + bytes_cached_);
   return ret;
 }
 
 void CachingAllocator::release(size_t sz, uint64_t *ptr) {
+  bytes_in_use_ -= std::min(bytes_in_use_, sz);
   if (merge_upon_release_) {
     merge_and_insert(reinterpret_cast<uint8_t *>(ptr), sz);
-  } else {
-    if (sz >= taichi_page_size) {
-      mem_blocks_.insert(std::make_pair(sz, reinterpret_cast<uint8_t *>(ptr)));
-    }
+  } else if (sz >= taichi_page_size) {
+    insert_block(reinterpret_cast<uint8_t *>(ptr), sz);
+  }
+}
+
+CachingAllocator::Stats CachingAllocator::get_stats() const {
+  Stats stats;
+  stats.bytes_in_use = bytes_in_use_;
+  stats.bytes_cached = bytes_cached_;
+  stats.high_water_mark = high_water_mark_;
+  stats.num_free_blocks = ptr_map_.size();
+  stats.num_cache_hits = num_cache_hits_;
+  stats.num_cache_misses = num_cache_misses_;
+  if (non_empty_bins_) {
+    // The largest block is the last one of the highest non-empty bin
+    const int bin = bit::log2int(non_empty_bins_);
+    stats.largest_free_block = bins_[bin].rbegin()->first;
+    stats.fragmentation =
+        1.0 - (double)stats.largest_free_block / stats.bytes_cached;
   }
+  return stats;
 }
 
 }  // namespace taichi::lang
@@ -5,25 +5,70 @@
 #include "taichi/rhi/llvm/llvm_device.h"
 #include "taichi/inc/constants.h"
 #include <stdint.h>
+#include <array>
 #include <map>
 #include <set>
 
 namespace taichi::lang {
 
+// Caches released runtime memory for reuse.
+//
+// Free blocks are binned by the power of two of their size in pages. A
+// request is served by the smallest block that fits (best fit): a lower_bound
+// in its own bin, otherwise the smallest block of the next non-empty bin.
+// The remainder of the block stays cached. When |merge_upon_release| is set,
+// released blocks are coalesced with adjacent free blocks.
 class CachingAllocator {
  public:
+  struct Stats {
+    // Bytes handed out by allocate() and not released yet
+    std::size_t bytes_in_use{0};
+    // Bytes in free blocks available for reuse
+    std::size_t bytes_cached{0};
+    // Peak of |bytes_in_use| + |bytes_cached|
+    std::size_t high_water_mark{0};
+    std::size_t num_free_blocks{0};
+    std::size_t largest_free_block{0};
+    // Allocations served from cached blocks and from the device
+    std::size_t num_cache_hits{0};
+    std::size_t num_cache_misses{0};
+    // 1 - largest_free_block / bytes_cached, i.e. how much of the cached
+    // memory cannot serve a request as large as the cache itself
+    double fragmentation{0.0};
+  };
+
   explicit CachingAllocator(bool merge_upon_release = true);
 
   uint64_t *allocate(LlvmDevice *device,
                      const LlvmDevice::LlvmRuntimeAllocParams &params);
+  // Returns nullptr if no cached block can hold |size| bytes.
+  uint64_t *allocate_from_cache(std::size_t size);
   void release(size_t sz, uint64_t *ptr);
 
+  Stats get_stats() const;
+
  private:
+  static constexpr int kNumBins = 48;
+
+  static int get_bin(std::size_t size);
+
+  void insert_block(uint8_t *ptr, std::size_t size);
+  void erase_block(uint8_t *ptr, std::size_t size);
   void merge_and_insert(uint8_t *ptr, std::size_t size);
 
-  std::set<std::pair<std::size_t, uint8_t *>> mem_blocks_;
+  // Free blocks ordered by (size, address) within each bin
+  std::array<std::set<std::pair<std::size_t, uint8_t *>>, kNumBins> bins_;
+  // Bit i is set iff bins_[i] is not empty
+  uint64_t non_empty_bins_{0};
+  // Free blocks ordered by address, for coalescing
   std::map<uint8_t *, std::size_t> ptr_map_;
 
+  std::size_t bytes_in_use_{0};
+  std::size_t bytes_cached_{0};
+  std::size_t high_water_mark_{0};
+  std::size_t num_cache_hits_{0};
+  std::size_t num_cache_misses_{0};
+
   // Allocator options
   bool merge_upon_release_ = true;
 };
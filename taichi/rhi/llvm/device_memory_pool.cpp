@@ -50,6 +50,12 @@ void DeviceMemoryPool::release(std::size_t size, void *ptr, bool release_raw) {
   }
 }
 
+CachingAllocator::Stats DeviceMemoryPool::get_stats() {
+  std::lock_guard<std::mutex> _(mut_allocation_);
+
+  return allocator_->get_stats();
+}
+
 void *DeviceMemoryPool::allocate_raw_memory(std::size_t size, bool managed) {
   /*
     Be aware that this methods is not protected by the mutex.
@@ -24,6 +24,8 @@ class TI_DLL_EXPORT DeviceMemoryPool {
   void *allocate(std::size_t size, std::size_t alignment, bool managed = false);
   void release(std::size_t size, void *ptr, bool release_raw = false);
   void reset();
+  // Statistics of the blocks served by allocate_with_cache()
+  CachingAllocator::Stats get_stats();
   explicit DeviceMemoryPool(bool merge_upon_release);
   ~DeviceMemoryPool();
 
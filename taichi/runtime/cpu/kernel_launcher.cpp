@@ -1,6 +1,8 @@
 #include "taichi/runtime/cpu/kernel_launcher.h"
 #include "taichi/rhi/arch.h"
 
+#include <cstring>
+
 namespace taichi::lang {
 namespace cpu {
 
@@ -9,6 +11,11 @@ void KernelLauncher::launch_llvm_kernel(Handle handle,
   TI_ASSERT(handle.get_launch_id() < contexts_.size());
   auto launcher_ctx = contexts_[handle.get_launch_id()];
   auto *executor = get_runtime_executor();
+  auto *stream = executor->get_cpu_launch_stream();
+  // Launches with a return value or external (numpy) arrays are observed by
+  // the caller right after they return, so they are executed synchronously.
+  bool launch_async = stream && ctx.result_buffer_size == 0;
+  std::vector<DeviceAllocationId> used_allocs;
 
   ctx.get_context().runtime = executor->get_llvm_runtime();
   // For taichi ndarrays, context.array_ptrs saves pointer to its
@@ -25,6 +32,7 @@ void KernelLauncher::launch_llvm_kernel(Handle handle,
 
     if (parameter.is_array && ctx.device_allocation_type[key] ==
                                   LaunchContextBuilder::DevAllocType::kNone) {
+      launch_async = false;
       ctx.set_ndarray_ptrs(key, (uint64)ctx.array_ptrs[data_ptr_idx],
                            (uint64)ctx.array_ptrs[grad_ptr_idx]);
     }
@@ -37,8 +45,13 @@ void KernelLauncher::launch_llvm_kernel(Handle handle,
       uint64 host_ptr = (uint64)executor->get_device_alloc_info_ptr(*ptr);
       ctx.set_array_device_allocation_type(
           key, LaunchContextBuilder::DevAllocType::kNone);
+      used_allocs.push_back(ptr->alloc_id);
 
       auto grad_ptr = ctx.array_ptrs[grad_ptr_idx];
+      if (grad_ptr != nullptr) {
+        used_allocs.push_back(
+            static_cast<DeviceAllocation *>(grad_ptr)->alloc_id);
+      }
       uint64 host_ptr_grad =
           grad_ptr == nullptr ? 0
                               : (uint64)executor->get_device_alloc_info_ptr(
@@ -50,6 +63,7 @@ void KernelLauncher::launch_llvm_kernel(Handle handle,
       data_ptr_idx.push_back(TypeFactory::DATA_PTR_POS_IN_ARGPACK);
       auto *argpack = ctx.argpack_ptrs[key];
       auto argpack_ptr = argpack->get_device_allocation();
+      used_allocs.push_back(argpack_ptr.alloc_id);
       uint64 host_ptr =
           (uint64)executor->get_device_alloc_info_ptr(argpack_ptr);
       if (key.size() == 1) {
@@ -62,6 +76,21 @@ void KernelLauncher::launch_llvm_kernel(Handle handle,
       }
     }
   }
+  if (launch_async) {
+    CpuLaunchStream::Launch launch;
+    launch.task_funcs = launcher_ctx.task_funcs;
+    launch.context = ctx.get_context();
+    launch.context.result_buffer = nullptr;
+    launch.arg_buffer = std::make_unique<char[]>(ctx.arg_buffer_size);
+    std::memcpy(launch.arg_buffer.get(), ctx.get_context().arg_buffer,
+                ctx.arg_buffer_size);
+    launch.allocs = std::move(used_allocs);
+    stream->enqueue(std::move(launch));
+    return;
+  }
+  if (stream) {
+    stream->synchronize();
+  }
   for (auto task : launcher_ctx.task_funcs) {
     task(&ctx.get_context());
   }
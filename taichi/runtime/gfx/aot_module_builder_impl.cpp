@@ -81,6 +81,16 @@ void AotModuleBuilderImpl::add_per_backend(const std::string &identifier,
   ti_aot_data_.spirv_codes.push_back(compiled.src.spirv_src);
 }
 
+void AotModuleBuilderImpl::precompile_per_backend(
+    const std::vector<Kernel *> &kernels) {
+  std::vector<KernelCompilationManager::CompileRequest> requests;
+  requests.reserve(kernels.size());
+  for (auto *kernel : kernels) {
+    requests.push_back({kernel});
+  }
+  compilation_manager_.compile_kernels(config_, caps_, requests);
+}
+
 void AotModuleBuilderImpl::add_field_per_backend(const std::string &identifier,
                                                  const SNode *rep_snode,
                                                  bool is_scalar,
@@ -26,6 +26,8 @@ class AotModuleBuilderImpl : public AotModuleBuilder {
  private:
   void add_per_backend(const std::string &identifier, Kernel *kernel) override;
 
+  void precompile_per_backend(const std::vector<Kernel *> &kernels) override;
+
   void add_field_per_backend(const std::string &identifier,
                              const SNode *rep_snode,
                              bool is_scalar,
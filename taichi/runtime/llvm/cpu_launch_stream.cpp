@@ -0,0 +1,100 @@
+#include "taichi/runtime/llvm/cpu_launch_stream.h"
+
+namespace taichi::lang {
+
+CpuLaunchStream::CpuLaunchStream(std::size_t max_pending_launches)
+    : max_pending_launches_(max_pending_launches) {
+  TI_ASSERT(max_pending_launches_ > 0);
+  worker_ = std::thread([this] { this->target(); });
+}
+
+CpuLaunchStream::~CpuLaunchStream() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exiting_ = true;
+  }
+  launch_cv_.notify_all();
+  worker_.join();
+}
+
+void CpuLaunchStream::enqueue(Launch &&launch) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  finish_cv_.wait(lock, [this] {
+    return launches_.size() < max_pending_launches_;
+  });
+  const uint64 seq = ++num_submitted_;
+  for (auto alloc_id : launch.allocs) {
+    last_use_[alloc_id] = seq;
+  }
+  launches_.push_back(std::move(launch));
+  lock.unlock();
+  launch_cv_.notify_one();
+}
+
+void CpuLaunchStream::synchronize() {
+  uint64 seq;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    seq = num_submitted_;
+  }
+  wait_until(seq);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (num_finished_ == num_submitted_) {
+    last_use_.clear();
+  }
+}
+
+void CpuLaunchStream::wait_for_allocation(DeviceAllocationId alloc_id) {
+  uint64 seq;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = last_use_.find(alloc_id);
+    if (it == last_use_.end()) {
+      return;
+    }
+    seq = it->second;
+  }
+  wait_until(seq);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = last_use_.find(alloc_id);
+  if (it != last_use_.end() && it->second <= num_finished_) {
+    last_use_.erase(it);
+  }
+}
+
+void CpuLaunchStream::wait_until(uint64 seq) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  finish_cv_.wait(lock, [this, seq] { return num_finished_ >= seq; });
+}
+
+void CpuLaunchStream::target() {
+  while (true) {
+    Launch launch;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      launch_cv_.wait(lock,
+                      [this] { return exiting_ || !launches_.empty(); });
+      if (launches_.empty()) {
+        // Exiting, and everything submitted has been executed.
+        break;
+      }
+      launch = std::move(launches_.front());
+    }
+
+    launch.context.arg_buffer = launch.arg_buffer.get();
+    for (auto task : launch.task_funcs) {
+      task(&launch.context);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // Only pop after execution so that the queue depth bounds the number
+      // of in-flight launches, including the running one.
+      launches_.pop_front();
+      num_finished_++;
+    }
+    finish_cv_.notify_all();
+  }
+}
+
+}  // namespace taichi::lang
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "taichi/common/core.h"
+#include "taichi/rhi/public_device.h"
+
+#define TI_RUNTIME_HOST
+#include "taichi/program/context.h"
+#undef TI_RUNTIME_HOST
+
+namespace taichi::lang {
+
+// An in-order launch queue for the CPU backend. Kernel launches are executed
+// on a dedicated host thread, so that the caller (usually Python) can prepare
+// the next launch while the current one is running. Since launches run in
+// submission order, dependencies between kernels are preserved implicitly;
+// the stream only needs to track which device allocations each pending launch
+// touches so that host-side accesses can wait for exactly those launches.
+class CpuLaunchStream {
+ public:
+  using TaskFunc = int32 (*)(void *);
+
+  struct Launch {
+    std::vector<TaskFunc> task_funcs;
+    // A snapshot of the caller's RuntimeContext, with |arg_buffer| pointing to
+    // |arg_buffer| below.
+    RuntimeContext context;
+    std::unique_ptr<char[]> arg_buffer;
+    // Ndarrays and argpacks read or written by the launch.
+    std::vector<DeviceAllocationId> allocs;
+  };
+
+  explicit CpuLaunchStream(std::size_t max_pending_launches = 64);
+  ~CpuLaunchStream();
+
+  // Blocks only if |max_pending_launches| launches are already pending.
+  void enqueue(Launch &&launch);
+
+  // Waits for all launches submitted so far.
+  void synchronize();
+
+  // Waits for the launches that use |alloc_id|.
+  void wait_for_allocation(DeviceAllocationId alloc_id);
+
+ private:
+  void wait_until(uint64 seq);
+  void target();
+
+  std::size_t max_pending_launches_;
+  std::mutex mutex_;
+  std::condition_variable launch_cv_;
+  std::condition_variable finish_cv_;
+  std::deque<Launch> launches_;
+  // The sequence number of the last launch using each allocation.
+  std::unordered_map<DeviceAllocationId, uint64> last_use_;
+  uint64 num_submitted_{0};
+  uint64 num_finished_{0};
+  bool exiting_{false};
+  std::thread worker_;
+};
+
+}  // namespace taichi::lang
@@ -35,6 +35,16 @@ void LlvmAotModuleBuilder::add_per_backend(const std::string &identifier,
   cache_.kernels[identifier] = std::move(kcache);
 }
 
+void LlvmAotModuleBuilder::precompile_per_backend(
+    const std::vector<Kernel *> &kernels) {
+  std::vector<KernelCompilationManager::CompileRequest> requests;
+  requests.reserve(kernels.size());
+  for (auto *kernel : kernels) {
+    requests.push_back({kernel});
+  }
+  compilation_manager_.compile_kernels(compile_config_, {}, requests);
+}
+
 void LlvmAotModuleBuilder::add_field_per_backend(const std::string &identifier,
                                                  const SNode *rep_snode,
                                                  bool is_scalar,
@@ -22,6 +22,8 @@ class LlvmAotModuleBuilder : public AotModuleBuilder {
  protected:
   void add_per_backend(const std::string &identifier, Kernel *kernel) override;
 
+  void precompile_per_backend(const std::vector<Kernel *> &kernels) override;
+
   void add_field_per_backend(const std::string &identifier,
                              const SNode *rep_snode,
                              bool is_scalar,
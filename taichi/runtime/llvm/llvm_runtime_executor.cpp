@@ -2,6 +2,7 @@
 
 #include "taichi/rhi/common/host_memory_pool.h"
 #include "taichi/runtime/llvm/llvm_offline_cache.h"
+#include "taichi/ir/snode.h"
 #include "taichi/rhi/cpu/cpu_device.h"
 #include "taichi/rhi/cuda/cuda_device.h"
 #include "taichi/platform/cuda/detect_cuda.h"
@@ -85,7 +86,9 @@ LlvmRuntimeExecutor::LlvmRuntimeExecutor(CompileConfig &config,
   if (arch_is_cpu(config.arch)) {
     config.max_block_dim = 1024;
     device_ = std::make_shared<cpu::CpuDevice>();
-
+    if (config.cpu_async_launch) {
+      cpu_launch_stream_ = std::make_unique<CpuLaunchStream>();
+    }
   }
 #if defined(TI_WITH_CUDA)
   else if (config.arch == Arch::cuda) {
@@ -209,7 +212,9 @@ void LlvmRuntimeExecutor::print_list_manager_info(void *list_manager,
 }
 
 void LlvmRuntimeExecutor::synchronize() {
-  if (config_.arch == Arch::cuda) {
+  if (cpu_launch_stream_) {
+    cpu_launch_stream_->synchronize();
+  } else if (config_.arch == Arch::cuda) {
 #if defined(TI_WITH_CUDA)
     CUDADriver::get_instance().stream_synchronize(nullptr);
 #else
@@ -229,6 +234,12 @@ void LlvmRuntimeExecutor::synchronize() {
   fflush(stdout);
 }
 
+void LlvmRuntimeExecutor::wait_for_allocation(DeviceAllocationId alloc_id) {
+  if (cpu_launch_stream_) {
+    cpu_launch_stream_->wait_for_allocation(alloc_id);
+  }
+}
+
 uint64 LlvmRuntimeExecutor::fetch_result_uint64(int i, uint64 *result_buffer) {
   // TODO: We are likely doing more synchronization than necessary. Simplify the
   // sync logic when we fetch the result.
@@ -391,6 +402,10 @@ DevicePtr LlvmRuntimeExecutor::get_snode_tree_device_ptr(int tree_id) {
 void LlvmRuntimeExecutor::initialize_llvm_runtime_snodes(
     const LlvmOfflineCache::FieldCacheData &field_cache_data,
     uint64 *result_buffer) {
+  // Registering a new tree mutates the LLVMRuntime seen by pending launches.
+  if (cpu_launch_stream_) {
+    cpu_launch_stream_->synchronize();
+  }
   auto *const runtime_jit = get_runtime_jit_module();
   // By the time this creator is called, "this" is already destroyed.
   // Therefore it is necessary to capture members by values.
@@ -448,12 +463,14 @@ void LlvmRuntimeExecutor::initialize_llvm_runtime_snodes(
       const auto snode_id = snode_metas[i].id;
       std::size_t node_size;
       auto element_size = snode_metas[i].cell_size_bytes;
-      if (snode_metas[i].type == SNodeType::pointer) {
-        // pointer. Allocators are for single elements
+      if (snode_metas[i].type == SNodeType::pointer ||
+          snode_metas[i].type == SNodeType::hash) {
+        // pointer and hash. Allocators are for single elements
         node_size = element_size;
       } else {
-        // dynamic. Allocators are for the chunks
-        node_size = sizeof(void *) + element_size * snode_metas[i].chunk_size;
+        // dynamic. Allocators are for the chunks and directory pages
+        node_size =
+            SNode::dynamic_chunk_bytes(element_size, snode_metas[i].chunk_size);
       }
       TI_TRACE("Initializing allocator for snode {} (node size {})", snode_id,
                node_size);
@@ -491,6 +508,7 @@ DeviceAllocation LlvmRuntimeExecutor::allocate_memory_on_device(
 }
 
 void LlvmRuntimeExecutor::deallocate_memory_on_device(DeviceAllocation handle) {
+  wait_for_allocation(handle.alloc_id);
   TI_ASSERT(allocated_runtime_memory_allocs_.find(handle.alloc_id) !=
             allocated_runtime_memory_allocs_.end());
   llvm_device()->dealloc_memory(handle);
@@ -500,6 +518,7 @@ void LlvmRuntimeExecutor::deallocate_memory_on_device(DeviceAllocation handle) {
 void LlvmRuntimeExecutor::fill_ndarray(const DeviceAllocation &alloc,
                                        std::size_t size,
                                        uint32_t data) {
+  wait_for_allocation(alloc.alloc_id);
   auto ptr = get_device_alloc_info_ptr(alloc);
   if (config_.arch == Arch::cuda) {
 #if defined(TI_WITH_CUDA)
@@ -548,6 +567,8 @@ uint64_t *LlvmRuntimeExecutor::get_device_alloc_info_ptr(
 
 void LlvmRuntimeExecutor::finalize() {
   profiler_ = nullptr;
+  // Drain and join the launch stream before any runtime state goes away.
+  cpu_launch_stream_.reset();
   if (config_.arch == Arch::cuda || config_.arch == Arch::amdgpu) {
     preallocated_runtime_objects_allocs_.reset();
     preallocated_runtime_memory_allocs_.reset();
@@ -756,6 +777,9 @@ void LlvmRuntimeExecutor::materialize_runtime(KernelProfilerBase *profiler,
 }
 
 void LlvmRuntimeExecutor::destroy_snode_tree(SNodeTree *snode_tree) {
+  if (cpu_launch_stream_) {
+    cpu_launch_stream_->synchronize();
+  }
   get_llvm_context()->delete_snode_tree(snode_tree->id());
   snode_tree_buffer_manager_->destroy(snode_tree);
 }
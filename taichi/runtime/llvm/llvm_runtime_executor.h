@@ -9,6 +9,7 @@
 #include "taichi/runtime/llvm/llvm_offline_cache.h"
 #include "taichi/runtime/llvm/snode_tree_buffer_manager.h"
 #include "taichi/runtime/llvm/llvm_context.h"
+#include "taichi/runtime/llvm/cpu_launch_stream.h"
 #include "taichi/struct/snode_tree.h"
 #include "taichi/program/compile_config.h"
 
@@ -75,6 +76,15 @@ class LlvmRuntimeExecutor {
 
   void synchronize();
 
+  // Waits for the pending launches that use |alloc_id|. Only the
+  // asynchronous CPU launch stream can have such launches.
+  void wait_for_allocation(DeviceAllocationId alloc_id);
+
+  // nullptr unless |cpu_async_launch| is enabled on a CPU backend.
+  CpuLaunchStream *get_cpu_launch_stream() {
+    return cpu_launch_stream_.get();
+  }
+
   bool use_device_memory_pool() {
     return use_device_memory_pool_;
   }
@@ -118,6 +128,10 @@ class LlvmRuntimeExecutor {
                   Args &&...args) {
     TI_ASSERT(arch_uses_llvm(config_.arch));
 
+    // Runtime queries read state that pending launches may modify.
+    if (cpu_launch_stream_) {
+      cpu_launch_stream_->synchronize();
+    }
     auto runtime = get_runtime_jit_module();
     runtime->call<void *>("runtime_" + key, llvm_runtime_,
                           std::forward<Args>(args)...);
@@ -146,6 +160,7 @@ class LlvmRuntimeExecutor {
   void *llvm_runtime_{nullptr};
 
   std::unique_ptr<ThreadPool> thread_pool_{nullptr};
+  std::unique_ptr<CpuLaunchStream> cpu_launch_stream_{nullptr};
   std::shared_ptr<Device> device_{nullptr};
 
   std::unique_ptr<SNodeTreeBufferManager> snode_tree_buffer_manager_{nullptr};
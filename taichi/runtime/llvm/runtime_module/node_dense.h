@@ -2,10 +2,10 @@
 
 // Specialized Attributes and functions
 struct DenseMeta : public StructMeta {
-  int morton_dim;
+  int morton_bits;
 };
 
-STRUCT_FIELD(DenseMeta, morton_dim)
+STRUCT_FIELD(DenseMeta, morton_bits)
 
 i32 Dense_get_num_elements(Ptr meta, Ptr node) {
   return ((StructMeta *)meta)->max_num_elements;
@@ -1,43 +1,116 @@
 #pragma once
 
+// A dynamic node keeps a directory of its chunks, so that element i lives in
+// chunk i / chunk_size and can be reached in constant time. The directory is
+// a radix tree: each container holds at most taichi_dynamic_max_root_entries
+// entries, and longer directories are split into pages of 2^page_bits entries
+// under them. Pages are allocated on first touch from the chunk allocator.
+//
+// Chunks and pages are always allocated in ascending order, i.e. a non-null
+// entry implies that all the entries before it on the same level are non-null
+// as well.
 struct DynamicNode {
   i32 lock;
   i32 n;
-  Ptr ptr;
+  // The root of the chunk directory. It actually has
+  // SNode::dynamic_num_root_entries() entries.
+  Ptr chunks[1];
 };
 
 // Specialized Attributes and functions
 struct DynamicMeta : public StructMeta {
   int chunk_size;
+  int page_bits;
+  int directory_depth;
 };
 
 STRUCT_FIELD(DynamicMeta, chunk_size);
+STRUCT_FIELD(DynamicMeta, page_bits);
+STRUCT_FIELD(DynamicMeta, directory_depth);
+
+i32 dynamic_num_chunks(DynamicMeta *meta) {
+  return (meta->max_num_elements + meta->chunk_size - 1) / meta->chunk_size;
+}
+
+// Returns the directory entry of the index-th node on the given level, where
+// level 0 holds the chunks and level directory_depth is the root. Returns
+// nullptr if a page on the way is not allocated.
+volatile Ptr *dynamic_directory_entry(DynamicMeta *meta,
+                                      DynamicNode *node,
+                                      int level,
+                                      int index) {
+  auto bits = meta->page_bits;
+  auto depth = meta->directory_depth;
+  auto entry =
+      (volatile Ptr *)&node->chunks[index >> ((depth - level) * bits)];
+  for (int l = depth - 1; l >= level; l--) {
+    Ptr page = *entry;
+    if (page == nullptr) {
+      return nullptr;
+    }
+    auto offset = (index >> ((l - level) * bits)) & ((1 << bits) - 1);
+    entry = (volatile Ptr *)page + offset;
+  }
+  return entry;
+}
+
+Ptr dynamic_chunk(DynamicMeta *meta, DynamicNode *node, int c) {
+  auto entry = dynamic_directory_entry(meta, node, 0, c);
+  return entry == nullptr ? nullptr : *entry;
+}
+
+// Makes sure chunk c (and therefore all the chunks before it) is allocated.
+void dynamic_touch_chunk(DynamicMeta *meta, DynamicNode *node, int c) {
+  if (dynamic_chunk(meta, node, c) != nullptr) {
+    return;
+  }
+  locked_task(
+      Ptr(&node->lock),
+      [&] {
+        auto rt = meta->context->runtime;
+        auto alloc = rt->node_allocators[meta->snode_id];
+        // Allocate in ascending order so that lock-free readers never observe
+        // a hole in the directory. Pages are published before the entries
+        // in them.
+        int first = c;
+        while (first > 0 && dynamic_chunk(meta, node, first - 1) == nullptr) {
+          first--;
+        }
+        for (int k = first; k <= c; k++) {
+          for (int l = meta->directory_depth; l >= 0; l--) {
+            auto entry = dynamic_directory_entry(meta, node, l,
+                                                 k >> (l * meta->page_bits));
+            if (*entry == nullptr) {
+              atomic_exchange_u64((u64 *)entry, (u64)alloc->allocate());
+            }
+          }
+        }
+      },
+      [&]() { return dynamic_chunk(meta, node, c) == nullptr; });
+}
+
+Ptr dynamic_element_ptr(DynamicMeta *meta, DynamicNode *node, int i) {
+  auto chunk_size = meta->chunk_size;
+  Ptr chunk = dynamic_chunk(meta, node, i / chunk_size);
+  if (chunk == nullptr) {
+    return nullptr;
+  }
+  return chunk + (i % chunk_size) * meta->element_size;
+}
 
 void Dynamic_activate(Ptr meta_, Ptr node_, int i) {
   auto meta = (DynamicMeta *)(meta_);
   auto node = (DynamicNode *)(node_);
+  if (i >= meta->max_num_elements) {
+    // The directory has no entry for element i.
+    return;
+  }
   // We need to not only update node->n, but also make sure the chunk containing
   // element i is allocated.
-  atomic_max_i32(&node->n, i + 1);
-  int chunk_start = 0;
-  auto p_chunk_ptr = &node->ptr;
-  auto chunk_size = meta->chunk_size;
-  while (true) {
-    if (*p_chunk_ptr == nullptr) {
-      locked_task(Ptr(&node->lock), [&] {
-        if (*p_chunk_ptr == nullptr) {
-          auto rt = meta->context->runtime;
-          auto alloc = rt->node_allocators[meta->snode_id];
-          *p_chunk_ptr = alloc->allocate();
-        }
-      });
-    }
-    if (i < chunk_start + chunk_size) {
-      return;
-    }
-    p_chunk_ptr = (Ptr *)*p_chunk_ptr;
-    chunk_start += chunk_size;
+  if (atomic_max_i32(&node->n, i + 1) < i + 1) {
+    mark_activation_changed(meta->context->runtime, meta->snode_id);
   }
+  dynamic_touch_chunk(meta, node, i / meta->chunk_size);
 }
 
 void Dynamic_deactivate(Ptr meta_, Ptr node_) {
@@ -46,74 +119,67 @@ void Dynamic_deactivate(Ptr meta_, Ptr node_) {
   if (node->n > 0) {
     locked_task(Ptr(&node->lock), [&] {
       node->n = 0;
-      auto p_chunk_ptr = &node->ptr;
       auto rt = meta->context->runtime;
       auto alloc = rt->node_allocators[meta->snode_id];
-      while (*p_chunk_ptr) {
-        alloc->recycle(*p_chunk_ptr);
-        p_chunk_ptr = (Ptr *)*p_chunk_ptr;
+      // Bottom-up, so that the pages are still there to find the entries
+      // below them.
+      auto num_entries = dynamic_num_chunks(meta);
+      for (int l = 0; l <= meta->directory_depth; l++) {
+        for (int k = 0; k < num_entries; k++) {
+          auto entry = dynamic_directory_entry(meta, node, l, k);
+          if (entry == nullptr || *entry == nullptr) {
+            break;
+          }
+          alloc->recycle(*entry);
+          *entry = nullptr;
+        }
+        num_entries = ((num_entries - 1) >> meta->page_bits) + 1;
       }
-      node->ptr = nullptr;
+      mark_activation_changed(rt, meta->snode_id);
     });
   }
 }
 
+// Appends an element without taking the lock, unless a new chunk is needed.
+// Appending to a full list returns the ambient element and leaves the list
+// unchanged; in debug mode the caller asserts on the returned length.
 Ptr Dynamic_allocate(Ptr meta_, Ptr node_, i32 *len) {
   auto meta = (DynamicMeta *)(meta_);
   auto node = (DynamicNode *)(node_);
-  auto chunk_size = meta->chunk_size;
   auto i = atomic_add_i32(&node->n, 1);
   *len = i;
-  int chunk_start = 0;
-  auto p_chunk_ptr = &node->ptr;
-  while (true) {
-    if (*p_chunk_ptr == nullptr) {
-      locked_task(Ptr(&node->lock), [&] {
-        if (*p_chunk_ptr == nullptr) {
-          auto rt = meta->context->runtime;
-          auto alloc = rt->node_allocators[meta->snode_id];
-          *p_chunk_ptr = alloc->allocate();
-        }
-      });
-    }
-    if (i < chunk_start + chunk_size) {
-      return *p_chunk_ptr + sizeof(Ptr) +
-             (i - chunk_start) * meta->element_size;
-    }
-    p_chunk_ptr = (Ptr *)(*p_chunk_ptr);
-    chunk_start += chunk_size;
+  if (i >= meta->max_num_elements) {
+    atomic_min_i32(&node->n, (i32)meta->max_num_elements);
+    return (meta->context->runtime)->ambient_elements[meta->snode_id];
   }
-  // Unreachable
-  return nullptr;
+  mark_activation_changed(meta->context->runtime, meta->snode_id);
+  dynamic_touch_chunk(meta, node, i / meta->chunk_size);
+  return dynamic_element_ptr(meta, node, i);
 }
 
 u1 Dynamic_is_active(Ptr meta_, Ptr node_, int i) {
+  auto meta = (DynamicMeta *)(meta_);
   auto node = (DynamicNode *)(node_);
-  return i < node->n;
+  // node->n may exceed the capacity while a full list is appended to.
+  return i < node->n && i < meta->max_num_elements;
 }
 
 Ptr Dynamic_lookup_element(Ptr meta_, Ptr node_, int i) {
   auto meta = (DynamicMeta *)(meta_);
   auto node = (DynamicNode *)(node_);
+  Ptr addr = nullptr;
   if (Dynamic_is_active(meta_, node_, i)) {
-    int chunk_start = 0;
-    auto chunk_ptr = node->ptr;
-    auto chunk_size = meta->chunk_size;
-    while (true) {
-      if (i < chunk_start + chunk_size) {
-        auto addr =
-            chunk_ptr + sizeof(Ptr) + (i - chunk_start) * meta->element_size;
-        return addr;
-      }
-      chunk_ptr = *(Ptr *)chunk_ptr;
-      chunk_start += chunk_size;
-    }
-  } else {
-    return (meta->context->runtime)->ambient_elements[meta->snode_id];
+    // The chunk may still be in allocation by another thread.
+    addr = dynamic_element_ptr(meta, node, i);
   }
+  if (addr == nullptr) {
+    addr = (meta->context->runtime)->ambient_elements[meta->snode_id];
+  }
+  return addr;
 }
 
 i32 Dynamic_get_num_elements(Ptr meta_, Ptr node_) {
+  auto meta = (DynamicMeta *)(meta_);
   auto node = (DynamicNode *)(node_);
-  return node->n;
+  return min_i32(node->n, (i32)meta->max_num_elements);
 }
@@ -0,0 +1,216 @@
+#pragma once
+
+// A hash node is an open-addressing table (linear probing) of |capacity|
+// slots, a power of two, instead of one slot per cell as in pointer nodes.
+// Slot s keeps
+//   - the key, i.e. the index of its cell plus one, at node + 8 * s,
+//   - a mutex at node + 8 * s + 4,
+//   - the pointer to the cell at node + 8 * (capacity + s).
+// Zero-filled memory is an empty table. Deactivated cells leave a tombstone,
+// which can be reused by any cell. GC removes the tombstones.
+
+// Specialized Attributes and functions
+struct HashMeta : public StructMeta {
+  int capacity;
+};
+
+STRUCT_FIELD(HashMeta, capacity);
+
+constexpr i32 hash_slot_empty = 0;
+constexpr i32 hash_slot_deleted = -1;
+
+i32 Hash_get_num_elements(Ptr meta, Ptr node) {
+  return ((StructMeta *)meta)->max_num_elements;
+}
+
+volatile i32 *hash_slot_key(Ptr node, int s) {
+  return (volatile i32 *)(node + 8 * s);
+}
+
+Ptr hash_slot_lock(Ptr node, int s) {
+  return node + 8 * s + 4;
+}
+
+volatile Ptr *hash_slot_data(Ptr meta, Ptr node, int s) {
+  return (volatile Ptr *)(node + 8 * (((HashMeta *)meta)->capacity + s));
+}
+
+u32 hash_cell_index(int i) {
+  // The finalizer of MurmurHash3, so that neighbouring cells spread over the
+  // table.
+  u32 h = (u32)i;
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h;
+}
+
+// Returns the slot holding cell i, or -1. Also returns the first slot that
+// cell i can be inserted to in |free_slot|.
+i32 hash_find_slot(Ptr meta, Ptr node, int i, i32 &free_slot) {
+  const i32 capacity = ((HashMeta *)meta)->capacity;
+  const i32 mask = capacity - 1;
+  i32 s = hash_cell_index(i) & mask;
+  free_slot = -1;
+  for (int probe = 0; probe < capacity; probe++) {
+    const i32 key = *hash_slot_key(node, s);
+    if (key == i + 1) {
+      return s;
+    }
+    if (key == hash_slot_empty || key == hash_slot_deleted) {
+      if (free_slot == -1) {
+        free_slot = s;
+      }
+      // The cell would have been inserted here.
+      if (key == hash_slot_empty) {
+        break;
+      }
+    }
+    s = (s + 1) & mask;
+  }
+  return -1;
+}
+
+i32 hash_lookup_slot(Ptr meta, Ptr node, int i) {
+  i32 free_slot;
+  return hash_find_slot(meta, node, i, free_slot);
+}
+
+void Hash_activate(Ptr meta_, Ptr node, int i) {
+  auto meta = (StructMeta *)meta_;
+  i32 slot = hash_lookup_slot(meta_, node, i);
+  if (slot == -1) {
+    // Inserts of cell i are serialized by the lock of its home slot, and probe
+    // again under it, so that a cell never gets two slots. A free slot found
+    // by a stale probe could otherwise come before the slot that a concurrent
+    // insert of the same cell has taken. Inserts of other cells can still take
+    // the same free slot, which the CAS arbitrates.
+    const i32 home = hash_cell_index(i) & (((HashMeta *)meta_)->capacity - 1);
+    locked_task(hash_slot_lock(node, home), [&] {
+      while (slot == -1) {
+        i32 free_slot;
+        slot = hash_find_slot(meta_, node, i, free_slot);
+        if (slot != -1) {
+          break;
+        }
+        if (free_slot == -1) {
+          taichi_assert_runtime(meta->context->runtime, false,
+                                "Hash SNode is full.");
+          return;
+        }
+        i32 expected = *hash_slot_key(node, free_slot);
+        if ((expected == hash_slot_empty || expected == hash_slot_deleted) &&
+            __atomic_compare_exchange_n(hash_slot_key(node, free_slot),
+                                        &expected, i + 1, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+          slot = free_slot;
+        }
+      }
+    });
+    if (slot == -1) {
+      return;
+    }
+  }
+
+  volatile Ptr *data_ptr = hash_slot_data(meta_, node, slot);
+  if (*data_ptr == nullptr) {
+    locked_task(
+        hash_slot_lock(node, slot),
+        [&] {
+          auto rt = meta->context->runtime;
+          auto alloc = rt->node_allocators[meta->snode_id];
+          atomic_exchange_u64((u64 *)data_ptr, (u64)alloc->allocate());
+          mark_activation_changed(rt, meta->snode_id);
+        },
+        [&]() { return *data_ptr == nullptr; });
+  }
+}
+
+void Hash_deactivate(Ptr meta, Ptr node, int i) {
+  const i32 slot = hash_lookup_slot(meta, node, i);
+  if (slot == -1) {
+    return;
+  }
+  volatile Ptr *data_ptr = hash_slot_data(meta, node, slot);
+  locked_task(hash_slot_lock(node, slot), [&] {
+    if (*data_ptr != nullptr) {
+      auto smeta = (StructMeta *)meta;
+      auto rt = smeta->context->runtime;
+      auto alloc = rt->node_allocators[smeta->snode_id];
+      alloc->recycle(*data_ptr);
+      *data_ptr = nullptr;
+      mark_activation_changed(rt, smeta->snode_id);
+    }
+    if (*hash_slot_key(node, slot) == i + 1) {
+      *hash_slot_key(node, slot) = hash_slot_deleted;
+    }
+  });
+}
+
+// Rebuilds the table in place without tombstones, so that probes for absent
+// cells stop early again. Must not run concurrently with other accesses.
+//
+// Cells are first marked pending (key -(i + 1) - 1, below the tombstone).
+// Each pending cell then goes to the first slot of its probe sequence that is
+// not placed yet, swapping with the pending cell found there if any. Placed
+// cells never move again, so the probe sequence of every cell stays occupied
+// up to its slot.
+void hash_remove_tombstones(Ptr meta, Ptr node) {
+  const i32 capacity = ((HashMeta *)meta)->capacity;
+  const i32 mask = capacity - 1;
+  bool has_tombstones = false;
+  for (int s = 0; s < capacity; s++) {
+    has_tombstones |= *hash_slot_key(node, s) == hash_slot_deleted;
+  }
+  if (!has_tombstones) {
+    return;
+  }
+  for (int s = 0; s < capacity; s++) {
+    const i32 key = *hash_slot_key(node, s);
+    *hash_slot_key(node, s) =
+        key == hash_slot_deleted ? hash_slot_empty
+                                 : (key > 0 ? -key - 1 : key);
+  }
+  for (int s = 0; s < capacity; s++) {
+    while (*hash_slot_key(node, s) < hash_slot_deleted) {
+      const i32 key = -*hash_slot_key(node, s) - 1;
+      i32 t = hash_cell_index(key - 1) & mask;
+      while (*hash_slot_key(node, t) > 0) {
+        t = (t + 1) & mask;
+      }
+      if (t == s) {
+        *hash_slot_key(node, s) = key;
+        break;
+      }
+      Ptr data = *hash_slot_data(meta, node, s);
+      if (*hash_slot_key(node, t) == hash_slot_empty) {
+        *hash_slot_key(node, s) = hash_slot_empty;
+        *hash_slot_data(meta, node, s) = nullptr;
+      } else {
+        // Continue with the pending cell of slot t.
+        *hash_slot_key(node, s) = *hash_slot_key(node, t);
+        *hash_slot_data(meta, node, s) = *hash_slot_data(meta, node, t);
+      }
+      *hash_slot_key(node, t) = key;
+      *hash_slot_data(meta, node, t) = data;
+    }
+  }
+}
+
+u1 Hash_is_active(Ptr meta, Ptr node, int i) {
+  const i32 slot = hash_lookup_slot(meta, node, i);
+  return slot != -1 && *hash_slot_data(meta, node, slot) != nullptr;
+}
+
+Ptr Hash_lookup_element(Ptr meta, Ptr node, int i) {
+  const i32 slot = hash_lookup_slot(meta, node, i);
+  Ptr data_ptr = slot == -1 ? nullptr : *hash_slot_data(meta, node, slot);
+  if (data_ptr == nullptr) {
+    auto smeta = (StructMeta *)meta;
+    auto context = smeta->context;
+    data_ptr = (context->runtime)->ambient_elements[smeta->snode_id];
+  }
+  return data_ptr;
+}
@@ -432,6 +432,11 @@ struct ListManager {
   i32 lock;
   i32 num_elements;
   LLVMRuntime *runtime;
+  // The activation stamp this list was generated from, or -1 if unknown. See
+  // clear_list.
+  i64 source_stamp;
+  // Set by clear_list when the list is kept, so that listgen can be skipped.
+  i32 reused;
 
   ListManager(LLVMRuntime *runtime,
               std::size_t element_size,
@@ -444,6 +449,8 @@ struct ListManager {
     lock = 0;
     num_elements = 0;
     log2chunk_num_elements = taichi::log2int(num_elements_per_chunk);
+    source_stamp = -1;
+    reused = 0;
   }
 
   void append(void *data_ptr);
@@ -455,6 +462,18 @@ struct ListManager {
     return i;
   }
 
+  // Reserves n consecutive elements at once and returns the first one.
+  i32 reserve_new_elements(i32 n) {
+    auto i = atomic_add_i32(&num_elements, n);
+    if (n > 0) {
+      for (int c = i >> log2chunk_num_elements;
+           c <= (i + n - 1) >> log2chunk_num_elements; c++) {
+        touch_chunk(c);
+      }
+    }
+    return i;
+  }
+
   template <typename T>
   void push_back(const T &t) {
     this->append((void *)&t);
@@ -567,6 +586,10 @@ struct LLVMRuntime {
   ListManager *element_lists[taichi_max_num_snodes];
   NodeManager *node_allocators[taichi_max_num_snodes];
   Ptr ambient_elements[taichi_max_num_snodes];
+  // Set when the activation of an SNode changes, and counted into
+  // |activation_epochs| by listgen, see sync_activation_epoch.
+  i32 activation_changed[taichi_max_num_snodes];
+  i64 activation_epochs[taichi_max_num_snodes];
   Ptr temporaries;
   RandState *rand_states;
 
@@ -686,6 +709,10 @@ struct NodeManager {
   }
 
   void gc_serial() {
+    // Nothing has been deactivated since the last GC.
+    if (recycled_list->size() == 0) {
+      return;
+    }
     // compact free list
     for (int i = free_list_used; i < free_list->size(); i++) {
       free_list->get<list_data_type>(i - free_list_used) =
@@ -706,6 +733,46 @@ struct NodeManager {
   }
 };
 
+// Calls |emit| with the child elements of the active cells j_start,
+// j_start + j_step, ... of the parent |element|.
+template <typename F>
+void listgen_parent_element(StructMeta *parent,
+                            StructMeta *child,
+                            const Element &element,
+                            int j_start,
+                            int j_step,
+                            const F &emit) {
+  // Cache the func pointers here for better compiler optimization
+  auto parent_refine_coordinates = parent->refine_coordinates;
+  auto parent_is_active = parent->is_active;
+  auto parent_lookup_element = parent->lookup_element;
+  auto child_get_num_elements = child->get_num_elements;
+  auto child_from_parent_element = child->from_parent_element;
+  int j_lower = element.loop_bounds[0] + j_start;
+  int j_higher = element.loop_bounds[1];
+  for (int j = j_lower; j < j_higher; j += j_step) {
+    PhysicalCoordinates refined_coord;
+    parent_refine_coordinates(&element.pcoord, &refined_coord, j);
+    if (parent_is_active((Ptr)parent, element.element, j)) {
+      auto ch_element = parent_lookup_element((Ptr)parent, element.element, j);
+      ch_element = child_from_parent_element((Ptr)ch_element);
+      auto ch_num_elements = child_get_num_elements((Ptr)child, ch_element);
+      auto ch_element_size =
+          std::min(ch_num_elements, taichi_listgen_max_element_size);
+      for (int ch_lower = 0; ch_lower < ch_num_elements;
+           ch_lower += ch_element_size) {
+        Element elem;
+        elem.element = ch_element;
+        elem.loop_bounds[0] = ch_lower;
+        elem.loop_bounds[1] =
+            std::min(ch_lower + ch_element_size, ch_num_elements);
+        elem.pcoord = refined_coord;
+        emit(elem);
+      }
+    }
+  }
+}
+
 extern "C" {
 
 void RuntimeContext_store_result(RuntimeContext *ctx, u64 ret, u32 idx) {
@@ -995,6 +1062,10 @@ void runtime_initialize_snodes(LLVMRuntime *runtime,
   // and the size of the root buffer memory are aligned to page size.
   runtime->root_mem_sizes[snode_tree_id] = rounded_size;
   runtime->roots[snode_tree_id] = ptr;
+  for (int i = root_id; i < root_id + num_snodes; i++) {
+    runtime->activation_changed[i] = 0;
+    runtime->activation_epochs[i] = 0;
+  }
   // runtime->request_allocate_aligned ready to use
   // initialize the root node element list
   if (all_dense) {
@@ -1014,6 +1085,8 @@ void runtime_initialize_snodes(LLVMRuntime *runtime,
   }
 
   runtime->element_lists[root_id]->append(&elem);
+  // The root list never changes.
+  runtime->element_lists[root_id]->source_stamp = 0;
 }
 
 void LLVMRuntime_initialize_thread_pool(LLVMRuntime *runtime,
@@ -1267,9 +1340,49 @@ DEFINE_REDUCTION(xor, i32);
 
 // "Element", "component" are different concepts
 
-void clear_list(LLVMRuntime *runtime, StructMeta *parent, StructMeta *child) {
+// Activation tracking, which lets struct-fors reuse the element lists
+// generated by an earlier one when no cell has been activated or deactivated
+// since.
+
+void mark_activation_changed(LLVMRuntime *runtime, int snode_id) {
+  // Test first, so that hot activation loops do not keep writing to the flag.
+  if (!runtime->activation_changed[snode_id]) {
+    runtime->activation_changed[snode_id] = 1;
+  }
+}
+
+// Not thread-safe: must be called by a serial task.
+i64 sync_activation_epoch(LLVMRuntime *runtime, int snode_id) {
+  if (runtime->activation_changed[snode_id]) {
+    runtime->activation_changed[snode_id] = 0;
+    runtime->activation_epochs[snode_id]++;
+  }
+  return runtime->activation_epochs[snode_id];
+}
+
+// Runs as a serial task before each listgen, and keeps the element list of
+// |child| if it is still valid. The list only depends on the list of
+// |parent|, on which parent cells are active and, for dynamic SNodes, on the
+// lengths of the child containers. Activation epochs never decrease, so their
+// sum along the path from the root identifies the activation state a list is
+// generated from.
+void clear_list(LLVMRuntime *runtime,
+                StructMeta *parent,
+                StructMeta *child,
+                bool reuse) {
+  auto parent_list = runtime->element_lists[parent->snode_id];
   auto child_list = runtime->element_lists[child->snode_id];
-  child_list->clear();
+  i64 stamp = -1;
+  if (reuse && parent_list->source_stamp >= 0) {
+    stamp = parent_list->source_stamp +
+            sync_activation_epoch(runtime, parent->snode_id) +
+            sync_activation_epoch(runtime, child->snode_id);
+  }
+  child_list->reused = stamp >= 0 && child_list->source_stamp == stamp;
+  child_list->source_stamp = stamp;
+  if (!child_list->reused) {
+    child_list->clear();
+  }
 }
 
 /*
@@ -1286,6 +1399,9 @@ void element_listgen_root(LLVMRuntime *runtime,
   // (instead of threads) to split the parent container
   auto parent_list = runtime->element_lists[parent->snode_id];
   auto child_list = runtime->element_lists[child->snode_id];
+  if (child_list->reused) {
+    return;
+  }
   // Cache the func pointers here for better compiler optimization
   auto parent_lookup_element = parent->lookup_element;
   auto child_get_num_elements = child->get_num_elements;
@@ -1328,58 +1444,108 @@ void element_listgen_root(LLVMRuntime *runtime,
   }
 }
 
+// Parallel listgen on CPU: each task first counts the child elements of a
+// range of parent elements, then writes them to the range of the child list
+// given by the prefix sum of the counts. The list keeps the serial order.
+constexpr int kCpuListgenMinParentElementsPerTask = 16;
+constexpr int kCpuListgenMaxNumTasks = 1024;
+
+struct listgen_context {
+  StructMeta *parent;
+  StructMeta *child;
+  ListManager *parent_list;
+  ListManager *child_list;
+  i32 num_parent_elements;
+  i32 parent_elements_per_task;
+  i32 child_list_start;
+  // The number of child elements of each task, then the offset of its first
+  // child element.
+  i32 *task_offsets;
+};
+
+void listgen_count_cpu_task(void *context, int thread_id, int task_id) {
+  auto &ctx = *(listgen_context *)context;
+  const int begin = task_id * ctx.parent_elements_per_task;
+  const int end =
+      min_i32(begin + ctx.parent_elements_per_task, ctx.num_parent_elements);
+  i32 count = 0;
+  for (int i = begin; i < end; i++) {
+    listgen_parent_element(ctx.parent, ctx.child,
+                           ctx.parent_list->get<Element>(i), 0, 1,
+                           [&](const Element &elem) { count++; });
+  }
+  ctx.task_offsets[task_id] = count;
+}
+
+void listgen_write_cpu_task(void *context, int thread_id, int task_id) {
+  auto &ctx = *(listgen_context *)context;
+  const int begin = task_id * ctx.parent_elements_per_task;
+  const int end =
+      min_i32(begin + ctx.parent_elements_per_task, ctx.num_parent_elements);
+  i32 k = ctx.child_list_start + ctx.task_offsets[task_id];
+  for (int i = begin; i < end; i++) {
+    listgen_parent_element(ctx.parent, ctx.child,
+                           ctx.parent_list->get<Element>(i), 0, 1,
+                           [&](const Element &elem) {
+                             ctx.child_list->get<Element>(k++) = elem;
+                           });
+  }
+}
+
 void element_listgen_nonroot(LLVMRuntime *runtime,
                              StructMeta *parent,
-                             StructMeta *child) {
+                             StructMeta *child,
+                             int num_threads) {
   auto parent_list = runtime->element_lists[parent->snode_id];
   int num_parent_elements = parent_list->size();
   auto child_list = runtime->element_lists[child->snode_id];
-  // Cache the func pointers here for better compiler optimization
-  auto parent_refine_coordinates = parent->refine_coordinates;
-  auto parent_is_active = parent->is_active;
-  auto parent_lookup_element = parent->lookup_element;
-  auto child_get_num_elements = child->get_num_elements;
-  auto child_from_parent_element = child->from_parent_element;
+  if (child_list->reused) {
+    return;
+  }
+  auto append = [&](const Element &elem) { child_list->append((void *)&elem); };
 #if ARCH_cuda || ARCH_amdgpu
-  // Each block processes a slice of a parent container
-  int i_start = block_idx();
-  int i_step = grid_dim();
-  // Each thread processes an element of the parent container
-  int j_start = thread_idx();
-  int j_step = block_dim();
+  // Each block processes a slice of a parent container, and each thread
+  // processes an element of the parent container
+  for (int i = block_idx(); i < num_parent_elements; i += grid_dim()) {
+    listgen_parent_element(parent, child, parent_list->get<Element>(i),
+                           thread_idx(), block_dim(), append);
+  }
 #else
-  int i_start = 0;
-  int i_step = 1;
-  int j_start = 0;
-  int j_step = 1;
-#endif
-  for (int i = i_start; i < num_parent_elements; i += i_step) {
-    auto element = parent_list->get<Element>(i);
-    int j_lower = element.loop_bounds[0] + j_start;
-    int j_higher = element.loop_bounds[1];
-    for (int j = j_lower; j < j_higher; j += j_step) {
-      PhysicalCoordinates refined_coord;
-      parent_refine_coordinates(&element.pcoord, &refined_coord, j);
-      if (parent_is_active((Ptr)parent, element.element, j)) {
-        auto ch_element =
-            parent_lookup_element((Ptr)parent, element.element, j);
-        ch_element = child_from_parent_element((Ptr)ch_element);
-        auto ch_num_elements = child_get_num_elements((Ptr)child, ch_element);
-        auto ch_element_size =
-            std::min(ch_num_elements, taichi_listgen_max_element_size);
-        for (int ch_lower = 0; ch_lower < ch_num_elements;
-             ch_lower += ch_element_size) {
-          Element elem;
-          elem.element = ch_element;
-          elem.loop_bounds[0] = ch_lower;
-          elem.loop_bounds[1] =
-              std::min(ch_lower + ch_element_size, ch_num_elements);
-          elem.pcoord = refined_coord;
-          child_list->append(&elem);
-        }
-      }
+  int num_tasks = min_i32(
+      (num_parent_elements + kCpuListgenMinParentElementsPerTask - 1) /
+          kCpuListgenMinParentElementsPerTask,
+      kCpuListgenMaxNumTasks);
+  if (num_threads <= 1 || num_tasks <= 1) {
+    for (int i = 0; i < num_parent_elements; i++) {
+      listgen_parent_element(parent, child, parent_list->get<Element>(i), 0, 1,
+                             append);
     }
+  } else {
+    i32 task_offsets[kCpuListgenMaxNumTasks];
+    listgen_context ctx;
+    ctx.parent = parent;
+    ctx.child = child;
+    ctx.parent_list = parent_list;
+    ctx.child_list = child_list;
+    ctx.num_parent_elements = num_parent_elements;
+    ctx.parent_elements_per_task =
+        (num_parent_elements + num_tasks - 1) / num_tasks;
+    num_tasks = (num_parent_elements + ctx.parent_elements_per_task - 1) /
+                ctx.parent_elements_per_task;
+    ctx.task_offsets = task_offsets;
+    runtime->parallel_for(runtime->thread_pool, num_tasks, num_threads, &ctx,
+                          listgen_count_cpu_task);
+    i32 total = 0;
+    for (int t = 0; t < num_tasks; t++) {
+      const i32 count = task_offsets[t];
+      task_offsets[t] = total;
+      total += count;
+    }
+    ctx.child_list_start = child_list->reserve_new_elements(total);
+    runtime->parallel_for(runtime->thread_pool, num_tasks, num_threads, &ctx,
+                          listgen_write_cpu_task);
   }
+#endif
 }
 
 using BlockTask = void(RuntimeContext *, char *, Element *, int, int);
@@ -1660,6 +1826,7 @@ i32 linear_thread_idx(RuntimeContext *context) {
 #include "node_pointer.h"
 #include "node_root.h"
 #include "node_bitmasked.h"
+#include "node_hash.h"
 
 void ListManager::touch_chunk(int chunk_id) {
   taichi_assert_runtime(runtime, chunk_id < max_num_chunks,
@@ -1688,15 +1855,203 @@ Ptr ListManager::allocate() {
   return get_element_ptr(i);
 }
 
+// Number of slots of a hash node scanned by one listgen task on CPU.
+constexpr int kCpuHashListgenBlockSize = 4096;
+
+struct hash_listgen_context {
+  StructMeta *child;
+  Ptr node;
+  PhysicalCoordinates pcoord;
+  ListManager *child_list;
+  i32 capacity;
+};
+
+void hash_listgen_slots(const hash_listgen_context &ctx,
+                        int begin,
+                        int end,
+                        int step) {
+  for (int s = begin; s < end; s += step) {
+    const i32 key = *hash_slot_key(ctx.node, s);
+    if (key > 0 && *hash_slot_data((Ptr)ctx.child, ctx.node, s) != nullptr) {
+      // One list element per active cell.
+      Element elem;
+      elem.element = ctx.node;
+      elem.loop_bounds[0] = key - 1;
+      elem.loop_bounds[1] = key;
+      elem.pcoord = ctx.pcoord;
+      ctx.child_list->append(&elem);
+    }
+  }
+}
+
+void hash_listgen_cpu_task(void *context, int thread_id, int task_id) {
+  auto &ctx = *(hash_listgen_context *)context;
+  const int begin = task_id * kCpuHashListgenBlockSize;
+  hash_listgen_slots(
+      ctx, begin, min_i32(begin + kCpuHashListgenBlockSize, ctx.capacity), 1);
+}
+
+// Lists the active cells of a hash node by scanning its slots instead of all
+// of its cells, which element_listgen_root would do. Hash nodes are always
+// children of the root.
+void element_listgen_hash(LLVMRuntime *runtime,
+                          StructMeta *parent,
+                          StructMeta *child,
+                          int num_threads) {
+  auto parent_list = runtime->element_lists[parent->snode_id];
+  if (runtime->element_lists[child->snode_id]->reused) {
+    return;
+  }
+  auto element = parent_list->get<Element>(0);
+  auto ch_element = parent->lookup_element((Ptr)parent, element.element, 0);
+
+  hash_listgen_context ctx;
+  ctx.child = child;
+  ctx.node = child->from_parent_element((Ptr)ch_element);
+  ctx.pcoord = element.pcoord;
+  ctx.child_list = runtime->element_lists[child->snode_id];
+  ctx.capacity = ((HashMeta *)child)->capacity;
+#if ARCH_cuda || ARCH_amdgpu
+  hash_listgen_slots(ctx, block_dim() * block_idx() + thread_idx(),
+                     ctx.capacity, grid_dim() * block_dim());
+#else
+  const int num_tasks =
+      (ctx.capacity + kCpuHashListgenBlockSize - 1) / kCpuHashListgenBlockSize;
+  if (num_threads <= 1 || num_tasks == 1) {
+    hash_listgen_slots(ctx, 0, ctx.capacity, 1);
+  } else {
+    runtime->parallel_for(runtime->thread_pool, num_tasks, num_threads, &ctx,
+                          hash_listgen_cpu_task);
+  }
+#endif
+}
+
+// Called before the GC of the cells of a hash node. Hash nodes are always
+// children of the root.
+void node_gc_hash(LLVMRuntime *runtime, StructMeta *parent, StructMeta *child) {
+  // Tombstones are only left by deactivations since the last GC.
+  if (runtime->node_allocators[child->snode_id]->recycled_list->size() == 0) {
+    return;
+  }
+  auto element = runtime->element_lists[parent->snode_id]->get<Element>(0);
+  auto ch_element = parent->lookup_element((Ptr)parent, element.element, 0);
+  hash_remove_tombstones((Ptr)child, child->from_parent_element(ch_element));
+}
+
 void node_gc(LLVMRuntime *runtime, int snode_id) {
   runtime->node_allocators[snode_id]->gc_serial();
 }
 
+// Below this many list items, GC on a single thread beats the thread pool.
+constexpr int kMinCpuParallelGcItems = 4096;
+constexpr int kCpuParallelGcBlockSize = 1024;
+
+struct gc_cpu_parallel_context {
+  NodeManager *allocator;
+  i32 src;
+  i32 dst;
+  i32 n;
+};
+
+void gc_cpu_parallel_compact_task(void *context, int thread_id, int task_id) {
+  auto ctx = *(gc_cpu_parallel_context *)context;
+  auto free_list = ctx.allocator->free_list;
+  using T = NodeManager::list_data_type;
+  const int begin = task_id * kCpuParallelGcBlockSize;
+  const int end = std::min(begin + kCpuParallelGcBlockSize, ctx.n);
+  for (int i = begin; i < end; i++) {
+    free_list->get<T>(ctx.dst + i) = free_list->get<T>(ctx.src + i);
+  }
+}
+
+void gc_cpu_parallel_recycle_task(void *context, int thread_id, int task_id) {
+  auto ctx = *(gc_cpu_parallel_context *)context;
+  auto allocator = ctx.allocator;
+  auto free_list = allocator->free_list;
+  auto recycled_list = allocator->recycled_list;
+  auto data_list = allocator->data_list;
+  using T = NodeManager::list_data_type;
+  // Each task zero-fills a contiguous run of the recycled list and writes the
+  // indices to the matching run at the end of the free list.
+  const int begin = task_id * kCpuParallelGcBlockSize;
+  const int end = std::min(begin + kCpuParallelGcBlockSize, ctx.n);
+  for (int i = begin; i < end; i++) {
+    auto idx = recycled_list->get<T>(i);
+    std::memset(data_list->get_element_ptr(idx), 0, allocator->element_size);
+    free_list->get<T>(ctx.dst + i) = idx;
+  }
+}
+
+// Same result as NodeManager::gc_serial(), with the free list compaction and
+// the recycling partitioned across the CPU thread pool.
+void node_gc_cpu_parallel(LLVMRuntime *runtime, int snode_id, int num_threads) {
+  auto allocator = runtime->node_allocators[snode_id];
+  auto free_list = allocator->free_list;
+  const i32 free_list_size = free_list->size();
+  const i32 free_list_used = min_i32(allocator->free_list_used, free_list_size);
+  const i32 num_unused = free_list_size - free_list_used;
+  const i32 num_recycled = allocator->recycled_list->size();
+  if (num_recycled == 0) {
+    return;
+  }
+  if (num_threads <= 1 ||
+      min_i32(free_list_used, num_unused) + num_recycled <
+          kMinCpuParallelGcItems) {
+    allocator->gc_serial();
+    return;
+  }
+
+  // Move unused elements to the beginning of the free_list. As in
+  // gc_parallel_impl_0, only non-overlapping ranges are copied so that the
+  // copy can be split arbitrarily.
+  gc_cpu_parallel_context ctx;
+  ctx.allocator = allocator;
+  if (free_list_used * 2 > free_list_size) {
+    ctx.src = free_list_used;
+    ctx.n = num_unused;
+  } else {
+    ctx.src = free_list_size - free_list_used;
+    ctx.n = free_list_used;
+  }
+  ctx.dst = 0;
+  if (ctx.n > 0) {
+    runtime->parallel_for(
+        runtime->thread_pool,
+        (ctx.n + kCpuParallelGcBlockSize - 1) / kCpuParallelGcBlockSize,
+        num_threads, &ctx, gc_cpu_parallel_compact_task);
+  }
+  allocator->free_list_used = 0;
+
+  // Make room for the recycled elements up front so that the tasks only
+  // write to chunks that already exist.
+  const i32 new_size = num_unused + num_recycled;
+  if (new_size > 0) {
+    for (int c = num_unused >> free_list->log2chunk_num_elements;
+         c <= (new_size - 1) >> free_list->log2chunk_num_elements; c++) {
+      free_list->touch_chunk(c);
+    }
+  }
+  free_list->resize(new_size);
+  ctx.dst = num_unused;
+  ctx.n = num_recycled;
+  if (ctx.n > 0) {
+    runtime->parallel_for(
+        runtime->thread_pool,
+        (ctx.n + kCpuParallelGcBlockSize - 1) / kCpuParallelGcBlockSize,
+        num_threads, &ctx, gc_cpu_parallel_recycle_task);
+  }
+  allocator->recycled_list->clear();
+}
+
 void gc_parallel_impl_0(RuntimeContext *context, NodeManager *allocator) {
   auto free_list = allocator->free_list;
   auto free_list_size = free_list->size();
   auto free_list_used = allocator->free_list_used;
   using T = NodeManager::list_data_type;
+  // Nothing has been deactivated since the last GC, see gc_parallel_impl_1.
+  if (allocator->recycled_list->size() == 0) {
+    return;
+  }
 
   // Move unused elements to the beginning of the free_list
   int i = linear_thread_idx(context);
@@ -1725,6 +2080,11 @@ void gc_parallel_0(RuntimeContext *context, int snode_id) {
 
 void gc_parallel_impl_1(NodeManager *allocator) {
   auto free_list = allocator->free_list;
+  if (allocator->recycled_list->size() == 0) {
+    // gc_parallel_impl_0 did not compact the free list, so keep it as is.
+    allocator->recycle_list_size_backup = 0;
+    return;
+  }
 
   const i32 num_unused =
       max_i32(free_list->size() - allocator->free_list_used, 0);
@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <memory>
 
+#include "taichi/codegen/llvm/llvm_task_cache.h"
 #include "taichi/runtime/llvm/llvm_offline_cache.h"
 #include "taichi/program/compile_config.h"
 #include "taichi/runtime/llvm/llvm_runtime_executor.h"
@@ -98,6 +99,7 @@ class LlvmProgramImpl : public ProgramImpl {
     // Invalid corresponding snode tree cache
     if (cache_data_->fields.find(snode_tree->id()) != cache_data_->fields.end())
       cache_data_->fields.erase(snode_tree->id());
+    task_cache.clear();
 
     return runtime_exec_->destroy_snode_tree(snode_tree);
   }
@@ -112,9 +114,18 @@ class LlvmProgramImpl : public ProgramImpl {
   }
 
   uint64_t *get_device_alloc_info_ptr(const DeviceAllocation &alloc) override {
+    // The pointer is handed out for host access.
+    runtime_exec_->wait_for_allocation(alloc.alloc_id);
     return runtime_exec_->get_device_alloc_info_ptr(alloc);
   }
 
+  bool used_in_kernel(DeviceAllocationId id) override {
+    // Rather than deferring the deallocation, wait for the pending launches
+    // that still need the allocation.
+    runtime_exec_->wait_for_allocation(id);
+    return false;
+  }
+
   void fill_ndarray(const DeviceAllocation &alloc,
                     std::size_t size,
                     uint32_t data) override {
@@ -269,6 +280,7 @@ class LlvmProgramImpl : public ProgramImpl {
     runtime_exec_.reset();
   }
   ParallelExecutor compilation_workers;  // parallel compilation
+  LLVMTaskCache task_cache;  // offloaded tasks shared between kernels
 
  protected:
   std::unique_ptr<KernelCompiler> make_kernel_compiler() override;
@@ -0,0 +1,99 @@
+#include "taichi/system/compile_profiler.h"
+
+#include <fstream>
+
+#include "taichi/system/timeline.h"
+#include "taichi/system/timer.h"
+
+namespace taichi {
+
+std::string CompilePassRecord::to_json() const {
+  std::string json{"{"};
+  json += fmt::format("\"kernel\":\"{}\",", kernel);
+  json += fmt::format("\"task\":\"{}\",", task);
+  json += fmt::format("\"pass\":\"{}\",", pass);
+  json += fmt::format("\"begin_us\":{},", uint64(begin * 1000000));
+  json += fmt::format("\"time_us\":{},", uint64((end - begin) * 1000000));
+  json += fmt::format("\"stmts_before\":{},", stmts_before);
+  json += fmt::format("\"stmts_after\":{}", stmts_after);
+  json += "}";
+  return json;
+}
+
+CompileProfiler &CompileProfiler::get_instance() {
+  static auto instance = new CompileProfiler();
+  return *instance;
+}
+
+void CompileProfiler::insert_record(const CompilePassRecord &record) {
+  if (!enabled_)
+    return;
+  {
+    std::lock_guard<std::mutex> _(mut_);
+    records_.push_back(record);
+  }
+  // Passes of different tasks may be compiled on different threads, so the
+  // events go to the timeline of the calling thread.
+  auto &timeline = Timeline::get_this_thread_instance();
+  TimelineEvent event{fmt::format("{}:{}", record.kernel, record.pass), true,
+                      record.begin, timeline.get_name()};
+  event.duration = record.end - record.begin;
+  event.args = fmt::format("\"task\":\"{}\"", record.task);
+  if (record.stmts_before >= 0) {
+    event.args += fmt::format(",\"stmts_before\":{},\"stmts_after\":{}",
+                              record.stmts_before, record.stmts_after);
+  }
+  timeline.insert_event(event);
+}
+
+std::vector<CompilePassRecord> CompileProfiler::get_records() {
+  std::lock_guard<std::mutex> _(mut_);
+  return records_;
+}
+
+void CompileProfiler::clear() {
+  std::lock_guard<std::mutex> _(mut_);
+  records_.clear();
+}
+
+std::string CompileProfiler::to_json() {
+  std::lock_guard<std::mutex> _(mut_);
+  std::string json{"{\"passes\":["};
+  for (std::size_t i = 0; i < records_.size(); i++) {
+    if (i > 0) {
+      json += ",\n";
+    }
+    json += records_[i].to_json();
+  }
+  json += "]}";
+  return json;
+}
+
+void CompileProfiler::save(const std::string &filename) {
+  if (!ends_with(filename, ".json")) {
+    TI_WARN("Compile profile filename {} should end with '.json'.", filename);
+  }
+  std::ofstream fout(filename);
+  fout << to_json() << std::endl;
+}
+
+CompileProfiler::Scope::Scope(const std::string &kernel,
+                              const std::string &task,
+                              const std::string &pass)
+    : enabled_(CompileProfiler::get_instance().get_enabled()) {
+  if (!enabled_)
+    return;
+  record_.kernel = kernel;
+  record_.task = task;
+  record_.pass = pass;
+  record_.begin = Time::get_time();
+}
+
+CompileProfiler::Scope::~Scope() {
+  if (!enabled_)
+    return;
+  record_.end = Time::get_time();
+  CompileProfiler::get_instance().insert_record(record_);
+}
+
+}  // namespace taichi
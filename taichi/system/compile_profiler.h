@@ -0,0 +1,73 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "taichi/common/core.h"
+
+namespace taichi {
+
+// One compilation step of a kernel: an IR pass, LLVM codegen of an offloaded
+// task, or the LLVM optimization pipeline.
+struct CompilePassRecord {
+  std::string kernel;
+  // The offloaded task the pass ran on; empty if it ran on the whole kernel.
+  std::string task;
+  std::string pass;
+  float64 begin{0};
+  float64 end{0};
+  // Statement counts of the IR; -1 for steps that do not operate on the IR.
+  int stmts_before{-1};
+  int stmts_after{-1};
+
+  std::string to_json() const;
+};
+
+// Collects per-pass compile time when CompileConfig::compile_profiler is on.
+// Records are also forwarded to Timelines as Chrome-trace events, so that
+// they show up next to the kernel launches in ti.timeline_save().
+class CompileProfiler {
+ public:
+  static CompileProfiler &get_instance();
+
+  bool get_enabled() const {
+    return enabled_;
+  }
+
+  void set_enabled(bool enabled) {
+    enabled_ = enabled;
+  }
+
+  void insert_record(const CompilePassRecord &record);
+
+  std::vector<CompilePassRecord> get_records();
+
+  void clear();
+
+  // {"passes": [...]}, one object per record in insertion order.
+  std::string to_json();
+
+  void save(const std::string &filename);
+
+  // Records the time spent in its scope as a step without IR statistics.
+  class Scope {
+   public:
+    Scope(const std::string &kernel,
+          const std::string &task,
+          const std::string &pass);
+
+    ~Scope();
+
+   private:
+    bool enabled_;
+    CompilePassRecord record_;
+  };
+
+ private:
+  std::mutex mut_;
+  std::vector<CompilePassRecord> records_;
+  bool enabled_{false};
+};
+
+}  // namespace taichi
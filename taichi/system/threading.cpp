@@ -10,8 +10,59 @@
 #include <thread>
 #include <vector>
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
 namespace taichi {
 
+namespace {
+
+// Number of polls an idle thread performs before parking itself. Kernels
+// launched back-to-back from Python are typically a few microseconds apart,
+// which this comfortably covers.
+constexpr int kSpinIterations = 1 << 12;
+
+inline void cpu_relax(int iteration) {
+  // Give the core away every now and then in case the machine is
+  // oversubscribed and the thread we are waiting for cannot run.
+  if ((iteration & 63) == 63) {
+    std::this_thread::yield();
+    return;
+  }
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#else
+  std::this_thread::yield();
+#endif
+}
+
+inline uint64 pack_range(uint32 begin, uint32 end) {
+  return ((uint64)begin << 32) | end;
+}
+
+inline uint32 range_begin(uint64 range) {
+  return (uint32)(range >> 32);
+}
+
+inline uint32 range_end(uint64 range) {
+  return (uint32)range;
+}
+
+inline uint32 job_epoch(uint64 state) {
+  return (uint32)(state >> 32);
+}
+
+inline uint32 job_remaining(uint64 state) {
+  return (uint32)state;
+}
+
+}  // namespace
+
 bool test_threading() {
   auto tp = ThreadPool(20);
   for (int j = 0; j < 100; j++) {
@@ -27,17 +78,14 @@ bool test_threading() {
 }
 
 ThreadPool::ThreadPool(int max_num_threads) : max_num_threads(max_num_threads) {
-  exiting = false;
-  started = false;
-  running_threads = 0;
-  timestamp = 1;
-  last_finished = 0;
-  task_head = 0;
-  task_tail = 0;
-  thread_counter = 0;
+  TI_ASSERT(max_num_threads > 0);
+  desired_num_threads = 0;
+  func = nullptr;
+  range_for_task_context = nullptr;
+  queues = std::make_unique<WorkerQueue[]>((std::size_t)max_num_threads);
   threads.resize((std::size_t)max_num_threads);
   for (int i = 0; i < max_num_threads; i++) {
-    threads[i] = std::thread([this] { this->target(); });
+    threads[i] = std::thread([this, i] { this->target(i); });
   }
 }
 
@@ -45,84 +93,146 @@ void ThreadPool::run(int splits,
                      int desired_num_threads,
                      void *range_for_task_context,
                      RangeForTaskFunc *func) {
-  {
-    std::lock_guard _(mutex);
-    this->range_for_task_context = range_for_task_context;
-    this->func = func;
-    this->desired_num_threads = std::min(desired_num_threads, max_num_threads);
-    TI_ASSERT(this->desired_num_threads > 0);
-    // TI_P(this->desired_num_threads);
-    started = false;
-    task_head = 0;
-    task_tail = splits;
-    timestamp++;
-    TI_ASSERT(timestamp < (1LL << 62));  // avoid overflowing here
+  if (splits <= 0)
+    return;
+  // Launches from different host threads are serialized; the per-launch state
+  // below is only written while no worker is active.
+  std::lock_guard _(launch_mutex);
+  this->range_for_task_context = range_for_task_context;
+  this->func = func;
+  this->desired_num_threads = std::min(desired_num_threads, max_num_threads);
+  TI_ASSERT(this->desired_num_threads > 0);
+
+  // Hand out contiguous chunks so that workers start on disjoint, cache
+  // friendly ranges. Workers not taking part get an empty range.
+  const int num_workers = this->desired_num_threads;
+  const int chunk = splits / num_workers;
+  const int remainder = splits % num_workers;
+  int begin = 0;
+  for (int i = 0; i < max_num_threads; i++) {
+    int end = begin;
+    if (i < num_workers)
+      end += chunk + (i < remainder ? 1 : 0);
+    queues[i].range.store(pack_range(begin, end), std::memory_order_relaxed);
+    begin = end;
   }
 
-  // wake up all slaves
-  slave_cv.notify_all();
-  {
-    std::unique_lock<std::mutex> lock(mutex);
-    // TODO: the workers may have finished before master waiting on master_cv
-    master_cv.wait(lock, [this] { return started && running_threads == 0; });
+  epoch++;
+  job_state.store(((uint64)epoch << 32) | (uint32)splits);
+
+  // Only pay for the mutex when some worker has actually parked.
+  if (sleeping_workers.load() > 0) {
+    { std::lock_guard<std::mutex> lock(mutex); }
+    slave_cv.notify_all();
   }
-  TI_ASSERT(task_head >= task_tail);
+
+  wait_for_completion();
 }
 
-void ThreadPool::target() {
-  uint64 last_timestamp = 0;
-  int thread_id;
-  {
-    std::lock_guard<std::mutex> lock(mutex);
-    thread_id = thread_counter++;
+void ThreadPool::wait_for_completion() {
+  auto finished = [this] {
+    return job_remaining(job_state.load()) == 0 && active_workers.load() == 0;
+  };
+  for (int i = 0; i < kSpinIterations; i++) {
+    if (finished())
+      return;
+    cpu_relax(i);
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  master_waiting.store(true);
+  master_cv.wait(lock, finished);
+  master_waiting.store(false);
+}
+
+uint64 ThreadPool::wait_for_job(uint32 last_epoch) {
+  auto has_job = [this, last_epoch] {
+    return job_epoch(job_state.load()) != last_epoch || exiting.load();
+  };
+  for (int i = 0; i < kSpinIterations; i++) {
+    if (has_job())
+      return job_state.load();
+    cpu_relax(i);
   }
+  std::unique_lock<std::mutex> lock(mutex);
+  sleeping_workers.fetch_add(1);
+  slave_cv.wait(lock, has_job);
+  sleeping_workers.fetch_sub(1);
+  return job_state.load();
+}
+
+bool ThreadPool::pop_task(int thread_id, int &task_id) {
+  auto &range = queues[thread_id].range;
+  uint64 current = range.load(std::memory_order_acquire);
   while (true) {
-    {
-      std::unique_lock<std::mutex> lock(mutex);
-      slave_cv.wait(lock, [this, last_timestamp, thread_id] {
-        return (timestamp > last_timestamp &&
-                thread_id < desired_num_threads) ||
-               this->exiting;
-      });
-      last_timestamp = timestamp;
-      if (exiting) {
-        break;
-      } else {
-        if (last_finished >= last_timestamp) {
-          continue;
-          // This could happen when part of the desired threads wake up and
-          // finish all the task, and then this thread wake up finding nothing
-          // to do. Should skip this task directly.
-        } else {
-          started = true;
-          running_threads++;
-        }
-      }
+    uint32 begin = range_begin(current), end = range_end(current);
+    if (begin >= end)
+      return false;
+    if (range.compare_exchange_weak(current, pack_range(begin + 1, end),
+                                    std::memory_order_acq_rel)) {
+      task_id = (int)begin;
+      return true;
     }
+  }
+}
 
+bool ThreadPool::steal_tasks(int thread_id) {
+  for (int k = 1; k < desired_num_threads; k++) {
+    int victim = (thread_id + k) % desired_num_threads;
+    auto &range = queues[victim].range;
+    uint64 current = range.load(std::memory_order_acquire);
     while (true) {
-      // For a single parallel task
-      int task_id;
-      {
-        task_id = task_head.fetch_add(1, std::memory_order_relaxed);
-        if (task_id >= task_tail)
-          break;
+      uint32 begin = range_begin(current), end = range_end(current);
+      if (begin >= end)
+        break;
+      // Take the upper half; the victim keeps consuming from the front.
+      uint32 mid = begin + (end - begin) / 2;
+      if (range.compare_exchange_weak(current, pack_range(begin, mid),
+                                      std::memory_order_acq_rel)) {
+        queues[thread_id].range.store(pack_range(mid, end),
+                                      std::memory_order_release);
+        return true;
       }
+    }
+  }
+  return false;
+}
 
-      func(this->range_for_task_context, thread_id, task_id);
+void ThreadPool::process_tasks(int thread_id) {
+  int task_id;
+  while (true) {
+    if (!pop_task(thread_id, task_id)) {
+      // Tasks are never re-enqueued, so once every queue is empty the only
+      // work left is what other workers are already executing.
+      if (!steal_tasks(thread_id))
+        break;
+      continue;
     }
+    func(range_for_task_context, thread_id, task_id);
+    job_state.fetch_sub(1);
+  }
+}
 
-    bool all_finished = false;
-    {
-      std::lock_guard<std::mutex> lock(mutex);
-      running_threads--;
-      if (running_threads == 0) {
-        all_finished = true;
-        last_finished = last_timestamp;
-      }
+void ThreadPool::target(int thread_id) {
+  uint32 last_epoch = 0;
+  while (true) {
+    uint64 state = wait_for_job(last_epoch);
+    if (exiting.load())
+      break;
+    last_epoch = job_epoch(state);
+
+    // Register before looking at the launch parameters: the master does not
+    // overwrite them while any worker is active. A worker waking up late may
+    // find the launch already finished (or superseded) and must skip it.
+    active_workers.fetch_add(1);
+    state = job_state.load();
+    if (job_epoch(state) == last_epoch && job_remaining(state) > 0 &&
+        thread_id < desired_num_threads) {
+      process_tasks(thread_id);
     }
-    if (all_finished)
+    if (active_workers.fetch_sub(1) == 1 && master_waiting.load()) {
+      { std::lock_guard<std::mutex> lock(mutex); }
       master_cv.notify_one();
+    }
   }
 }
 
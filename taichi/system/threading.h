@@ -10,6 +10,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <thread>
 
 namespace taichi {
@@ -17,27 +18,41 @@ namespace taichi {
 using RangeForTaskFunc = void(void *, int thread_id, int i);
 using ParallelFor = void(int n, int num_threads, void *, RangeForTaskFunc func);
 
+// A work-stealing thread pool for CPU range/struct/mesh fors.
+//
+// Each launch splits [0, splits) into one contiguous range per participating
+// worker. A worker pops task ids from the front of its own range and, once
+// that is drained, steals the upper half of another worker's range. Idle
+// workers spin for a short while before parking on a condition variable, so
+// back-to-back launches of short kernels do not pay for a futex wake-up.
 class ThreadPool {
  public:
+  // A worker's pending task ids [begin, end), packed as (begin << 32) | end so
+  // that the owner and the thieves can update it with a single CAS.
+  struct alignas(64) WorkerQueue {
+    std::atomic<uint64> range{0};
+  };
+
   std::vector<std::thread> threads;
+  std::unique_ptr<WorkerQueue[]> queues;
   std::condition_variable slave_cv;
   std::condition_variable master_cv;
   std::mutex mutex;
-  std::atomic<int> task_head;
-  int task_tail;
-  int running_threads;
+  std::mutex launch_mutex;
+  // (epoch << 32) | number of unfinished tasks of the current launch.
+  std::atomic<uint64> job_state{0};
+  std::atomic<int> active_workers{0};
+  std::atomic<int> sleeping_workers{0};
+  std::atomic<bool> master_waiting{false};
+  std::atomic<bool> exiting{false};
+  uint32 epoch{0};
   int max_num_threads;
   int desired_num_threads;
-  uint64 timestamp;
-  uint64 last_finished;
-  bool started;
-  bool exiting;
   RangeForTaskFunc *func;
   void *range_for_task_context;  // Note: this is a pointer to a
                                  // range_task_helper_context defined in the
                                  // LLVM runtime, which is different from
                                  // taichi::lang::Context.
-  int thread_counter;
 
   explicit ThreadPool(int max_num_threads);
 
@@ -54,9 +69,16 @@ class ThreadPool {
     return pool->run(splits, desired_num_threads, range_for_task_context, func);
   }
 
-  void target();
+  void target(int thread_id);
 
   ~ThreadPool();
+
+ private:
+  uint64 wait_for_job(uint32 last_epoch);
+  void wait_for_completion();
+  void process_tasks(int thread_id);
+  bool pop_task(int thread_id, int &task_id);
+  bool steal_tasks(int thread_id);
 };
 
 }  // namespace taichi
@@ -7,8 +7,16 @@ std::string TimelineEvent::to_json() {
   json += fmt::format("\"cat\":\"taichi\",");
   json += fmt::format("\"pid\":0,");
   json += fmt::format("\"tid\":\"{}\",", tid);
-  json += fmt::format("\"ph\":\"{}\",", begin ? "B" : "E");
+  if (duration >= 0) {
+    json += fmt::format("\"ph\":\"X\",");
+    json += fmt::format("\"dur\":{},", uint64(duration * 1000000));
+  } else {
+    json += fmt::format("\"ph\":\"{}\",", begin ? "B" : "E");
+  }
   json += fmt::format("\"name\":\"{}\",", name);
+  if (!args.empty()) {
+    json += fmt::format("\"args\":{{{}}},", args);
+  }
   json += fmt::format("\"ts\":\"{}\"", uint64(time * 1000000));
   json += "}";
   return json;
@@ -13,6 +13,11 @@ struct TimelineEvent {
   bool begin;
   float64 time;
   std::string tid;
+  // If non-negative, a complete event of this length starting at |time|;
+  // |begin| is ignored.
+  float64 duration{-1};
+  // Extra "args" members, e.g. "\"stmts\":3". Empty if none.
+  std::string args;
 
   std::string to_json();
 };
@@ -7,6 +7,8 @@
 
 #include <typeinfo>
 #include <algorithm>
+#include <cmath>
+#include <optional>
 
 namespace taichi::lang {
 
@@ -948,6 +950,295 @@ class ReverseOuterLoops : public BasicStmtVisitor {
   }
 };
 
+// A loop split into segments by CheckpointLoops.
+struct CheckpointedLoop {
+  // The original loop, which now iterates over one segment.
+  RangeForStmt *segment_loop{nullptr};
+  // The original bounds. They have no operands and can be cloned anywhere.
+  Stmt *begin{nullptr};
+  Stmt *end{nullptr};
+  int segment_length{0};
+  // The AD-stacks pushed to in the loop.
+  std::vector<Stmt *> stacks;
+};
+
+using CheckpointedLoops = std::unordered_map<RangeForStmt *, CheckpointedLoop>;
+
+/* Checkpointing (rematerialization) for loops in an IB. Normally every
+ * iteration of a loop pushes its values to the AD-stacks, so the stacks must
+ * hold all the iterations. Here the loop
+ *
+ *   for t in range(begin, end):
+ *     body
+ *
+ * is split into segments of |segment_length| iterations:
+ *
+ *   for s in range(num_segments):
+ *     for t in range(begin + s * segment_length, ...):
+ *       body
+ *
+ * The forward pass only keeps the values at the start of each segment: the
+ * outer loop pushes a copy of the top of every stack the body pushes to (the
+ * checkpoint), and the pushes in the body overwrite the top instead of
+ * growing the stack (see stop_recording). The adjoint of segment s, generated
+ * by MakeAdjoint, pops its checkpoint, runs the body of the segment again from
+ * the previous checkpoint with the usual pushes, and then runs the adjoint of
+ * the body. The stacks therefore only need num_segments + segment_length *
+ * (pushes per iteration) entries, at the price of running the body twice.
+ *
+ * The segment length is chosen so that this fits the capacity of the stacks,
+ * CompileConfig::ad_stack_size or default_ad_stack_size when it is adaptive.
+ * Loops that already fit are left alone.
+ */
+class CheckpointLoops : public BasicStmtVisitor {
+ public:
+  using BasicStmtVisitor::visit;
+
+  // Only the outermost loops of an IB are checkpointed; the inner ones are
+  // recomputed with their segment.
+  void visit(RangeForStmt *loop) override {
+    loops_.push_back(loop);
+  }
+
+  static CheckpointedLoops run(Block *ib, const CompileConfig &config) {
+    CheckpointLoops pass;
+    ib->accept(&pass);
+    const int64 capacity = config.ad_stack_size > 0
+                               ? config.ad_stack_size
+                               : config.default_ad_stack_size;
+    CheckpointedLoops result;
+    for (auto *loop : pass.loops_) {
+      if (!is_checkpointable(loop)) {
+        continue;
+      }
+      auto pushes = max_pushes_per_iteration(loop->body.get());
+      if (!pushes || *pushes == 0) {
+        continue;
+      }
+      const int segment_length =
+          choose_segment_length(trip_count(loop), *pushes, capacity);
+      if (segment_length == 0) {
+        continue;
+      }
+      CheckpointedLoop checkpointed{loop, loop->begin, loop->end,
+                                    segment_length,
+                                    pushed_stacks(loop->body.get())};
+      result[split(checkpointed)] = std::move(checkpointed);
+    }
+    return result;
+  }
+
+  // Emits the number of segments of |loop| to |stmts|.
+  static Stmt *num_segments(VecStatement &stmts, const CheckpointedLoop &loop) {
+    auto begin = stmts.push_back(loop.begin->clone());
+    auto end = stmts.push_back(loop.end->clone());
+    auto n = stmts.push_back<BinaryOpStmt>(BinaryOpType::sub, end, begin);
+    auto k_minus_one =
+        stmts.push_back<ConstStmt>(TypedConstant(loop.segment_length - 1));
+    auto k = stmts.push_back<ConstStmt>(TypedConstant(loop.segment_length));
+    auto rounded_up =
+        stmts.push_back<BinaryOpStmt>(BinaryOpType::add, n, k_minus_one);
+    return stmts.push_back<BinaryOpStmt>(BinaryOpType::floordiv, rounded_up,
+                                         k);
+  }
+
+  // Emits the bounds of the segment indexed by the loop |segments| to the
+  // body of |segments|.
+  static std::pair<Stmt *, Stmt *> segment_bounds(const CheckpointedLoop &loop,
+                                                  RangeForStmt *segments) {
+    VecStatement stmts;
+    auto segment = stmts.push_back<LoopIndexStmt>(segments, 0);
+    auto begin = stmts.push_back(loop.begin->clone());
+    auto end = stmts.push_back(loop.end->clone());
+    auto k = stmts.push_back<ConstStmt>(TypedConstant(loop.segment_length));
+    auto offset = stmts.push_back<BinaryOpStmt>(BinaryOpType::mul, segment, k);
+    auto segment_begin =
+        stmts.push_back<BinaryOpStmt>(BinaryOpType::add, begin, offset);
+    auto segment_end_unclamped =
+        stmts.push_back<BinaryOpStmt>(BinaryOpType::add, segment_begin, k);
+    auto segment_end = stmts.push_back<BinaryOpStmt>(
+        BinaryOpType::min, segment_end_unclamped, end);
+    segments->body->insert(std::move(stmts), 0);
+    return {segment_begin, segment_end};
+  }
+
+  // Makes the pushes in the forward pass of the segments overwrite the top of
+  // the stacks. Must run after MakeAdjoint, which copies the original body.
+  static void stop_recording(const CheckpointedLoops &loops) {
+    for (auto &[_, loop] : loops) {
+      auto pushes = irpass::analysis::gather_statements(
+          loop.segment_loop->body.get(),
+          [](Stmt *stmt) { return stmt->is<AdStackPushStmt>(); });
+      for (auto *push : pushes) {
+        push->insert_before_me(
+            Stmt::make<AdStackPopStmt>(push->as<AdStackPushStmt>()->stack));
+      }
+    }
+  }
+
+  // Returns a copy of the segment loop without its global side effects, for
+  // recomputing a segment in the adjoint pass.
+  static std::unique_ptr<Stmt> clone_for_recomputation(
+      const CheckpointedLoop &loop) {
+    auto recompute = irpass::analysis::clone(loop.segment_loop);
+    auto side_effects = irpass::analysis::gather_statements(
+        recompute.get(), [](Stmt *stmt) {
+          return stmt->is<GlobalStoreStmt>() || stmt->is<AtomicOpStmt>() ||
+                 stmt->is<PrintStmt>();
+        });
+    for (auto *stmt : side_effects) {
+      stmt->parent->erase(stmt);
+    }
+    return recompute;
+  }
+
+ private:
+  static bool is_checkpointable(RangeForStmt *loop) {
+    if (loop->reversed || loop->begin->num_operands() != 0 ||
+        loop->end->num_operands() != 0) {
+      return false;
+    }
+    // The body runs twice, so it must not have side effects that are not
+    // idempotent, or results that may differ between the two runs.
+    std::unordered_set<Stmt *> operands;
+    bool unsupported = false;
+    auto atomics = irpass::analysis::gather_statements(
+        loop->body.get(), [&](Stmt *stmt) {
+          for (auto *op : stmt->get_operands()) {
+            operands.insert(op);
+          }
+          if (stmt->is<SNodeOpStmt>() || stmt->is<FuncCallStmt>() ||
+              stmt->is<ExternalFuncCallStmt>() || stmt->is<TextureOpStmt>() ||
+              stmt->is<InternalFuncStmt>() || stmt->is<RandStmt>()) {
+            unsupported = true;
+          }
+          return stmt->is<AtomicOpStmt>();
+        });
+    if (unsupported) {
+      return false;
+    }
+    return std::none_of(atomics.begin(), atomics.end(),
+                        [&](Stmt *atomic) { return operands.count(atomic); });
+  }
+
+  static std::optional<int64> trip_count(RangeForStmt *loop) {
+    auto begin = loop->begin->cast<ConstStmt>();
+    auto end = loop->end->cast<ConstStmt>();
+    if (!begin || !end) {
+      return std::nullopt;
+    }
+    return std::max<int64>(end->val.val_int() - begin->val.val_int(), 0);
+  }
+
+  static bool count_pushes(Block *block,
+                           int64 times,
+                           std::unordered_map<Stmt *, int64> &pushes) {
+    for (auto &stmt : block->statements) {
+      if (auto push = stmt->cast<AdStackPushStmt>()) {
+        pushes[push->stack] += times;
+      } else if (auto if_stmt = stmt->cast<IfStmt>()) {
+        // Both branches, as an upper bound.
+        if ((if_stmt->true_statements &&
+             !count_pushes(if_stmt->true_statements.get(), times, pushes)) ||
+            (if_stmt->false_statements &&
+             !count_pushes(if_stmt->false_statements.get(), times, pushes))) {
+          return false;
+        }
+      } else if (auto loop = stmt->cast<RangeForStmt>()) {
+        auto n = trip_count(loop);
+        if (!n || !count_pushes(loop->body.get(), times * *n, pushes)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // The maximum number of entries any stack gets in one iteration of a loop
+  // with |body|, or nullopt if unknown at compile time.
+  static std::optional<int64> max_pushes_per_iteration(Block *body) {
+    std::unordered_map<Stmt *, int64> pushes;
+    if (!count_pushes(body, 1, pushes)) {
+      return std::nullopt;
+    }
+    int64 result = 0;
+    for (auto &[_, n] : pushes) {
+      result = std::max(result, n);
+    }
+    return result;
+  }
+
+  static std::vector<Stmt *> pushed_stacks(Block *body) {
+    std::vector<Stmt *> stacks;
+    irpass::analysis::gather_statements(body, [&](Stmt *stmt) {
+      if (auto push = stmt->cast<AdStackPushStmt>()) {
+        if (std::find(stacks.begin(), stacks.end(), push->stack) ==
+            stacks.end()) {
+          stacks.push_back(push->stack);
+        }
+      }
+      return false;
+    });
+    return stacks;
+  }
+
+  // Returns 0 if the loop needs no checkpointing.
+  static int choose_segment_length(std::optional<int64> trip_count,
+                                   int64 pushes,
+                                   int64 capacity) {
+    // Keep an entry for the initial value and one for the values pushed
+    // before the loop.
+    const int64 budget = std::max<int64>(capacity - 2, 1);
+    if (!trip_count) {
+      // Split the budget evenly between the checkpoints and a segment, which
+      // covers up to budget^2 / (4 * pushes) iterations.
+      return (int)std::max<int64>(budget / (2 * pushes), 1);
+    }
+    const int64 n = *trip_count;
+    if (n * pushes <= budget) {
+      return 0;
+    }
+    // The longest segments that fit, i.e. the fewest checkpoints.
+    for (int64 k = std::min(n, budget / pushes); k >= 1; k--) {
+      if ((n + k - 1) / k + k * pushes <= budget) {
+        return (int)k;
+      }
+    }
+    // Nothing fits. Minimize the size of the stacks instead.
+    return (int)std::max<int64>(
+        std::llround(std::sqrt(double(n) / double(pushes))), 1);
+  }
+
+  // Wraps the loop in a loop over its segments, and returns the latter.
+  static RangeForStmt *split(const CheckpointedLoop &loop) {
+    auto *segment_loop = loop.segment_loop;
+    Block *parent = segment_loop->parent;
+    const int location = parent->locate(segment_loop);
+
+    VecStatement header;
+    auto zero = header.push_back<ConstStmt>(TypedConstant(0));
+    auto end = num_segments(header, loop);
+    auto segments = Stmt::make_typed<RangeForStmt>(
+        zero, end, std::make_unique<Block>(), segment_loop->is_bit_vectorized,
+        segment_loop->num_cpu_threads, segment_loop->block_dim,
+        segment_loop->strictly_serialized);
+    auto segments_ptr = segments.get();
+    for (auto *stack : loop.stacks) {
+      auto top = segments->body->push_back<AdStackLoadTopStmt>(stack);
+      segments->body->push_back<AdStackPushStmt>(stack, top);
+    }
+    std::tie(segment_loop->begin, segment_loop->end) =
+        segment_bounds(loop, segments_ptr);
+    segments->body->insert(parent->extract(location));
+
+    parent->insert(std::move(segments), location);
+    parent->insert(std::move(header), location);
+    return segments_ptr;
+  }
+
+  std::vector<RangeForStmt *> loops_;
+};
+
 // Base class for both reverse (make adjoint) and forward (make dual) mode
 class ADTransform : public IRVisitor {
  protected:
@@ -1172,14 +1463,17 @@ class MakeAdjoint : public ADTransform {
   Block *forward_backup;
   std::map<Stmt *, Stmt *> adjoint_stmt;
 
-  explicit MakeAdjoint(Block *block) {
+  explicit MakeAdjoint(Block *block,
+                       const CheckpointedLoops &checkpointed_loops)
+      : checkpointed_loops_(checkpointed_loops) {
     current_block = nullptr;
     alloca_block = block;
     forward_backup = block;
   }
 
-  static void run(Block *block) {
-    auto p = MakeAdjoint(block);
+  static void run(Block *block,
+                  const CheckpointedLoops &checkpointed_loops = {}) {
+    auto p = MakeAdjoint(block, checkpointed_loops);
     block->accept(&p);
   }
 
@@ -1444,6 +1738,59 @@ class MakeAdjoint : public ADTransform {
   }
 
   void visit(RangeForStmt *for_stmt) override {
+    auto checkpointed = checkpointed_loops_.find(for_stmt);
+    if (checkpointed != checkpointed_loops_.end()) {
+      make_checkpointed_adjoint(checkpointed->second);
+    } else {
+      make_loop_adjoint(for_stmt);
+    }
+  }
+
+  // See CheckpointLoops.
+  void make_checkpointed_adjoint(const CheckpointedLoop &loop) {
+    VecStatement header;
+    auto zero = header.push_back<ConstStmt>(TypedConstant(0));
+    auto num_segments = CheckpointLoops::num_segments(header, loop);
+    current_block->insert(std::move(header));
+    auto segments = Stmt::make_typed<RangeForStmt>(
+        zero, num_segments, std::make_unique<Block>(),
+        loop.segment_loop->is_bit_vectorized,
+        loop.segment_loop->num_cpu_threads, loop.segment_loop->block_dim,
+        loop.segment_loop->strictly_serialized);
+    segments->reversed = true;
+    auto segments_ptr = segments.get();
+    insert_grad_stmt(std::move(segments));
+    auto [segment_begin, segment_end] =
+        CheckpointLoops::segment_bounds(loop, segments_ptr);
+
+    auto old_current_block = current_block;
+    auto old_alloca_block = alloca_block;
+    current_block = segments_ptr->body.get();
+    alloca_block = segments_ptr->body.get();
+    // Take the checkpoint of this segment off the stacks, keeping the
+    // adjoints accumulated to it by the later segments.
+    std::vector<Stmt *> adjoints;
+    for (auto *stack : loop.stacks) {
+      adjoints.push_back(insert<AdStackLoadTopAdjStmt>(stack));
+      insert<AdStackPopStmt>(stack);
+    }
+    // Push the values of the segment again, starting from the checkpoint of
+    // the previous segment.
+    auto recompute = insert_grad_stmt(
+        CheckpointLoops::clone_for_recomputation(loop))->as<RangeForStmt>();
+    recompute->begin = segment_begin;
+    recompute->end = segment_end;
+    for (int i = 0; i < (int)loop.stacks.size(); i++) {
+      insert<AdStackAccAdjointStmt>(loop.stacks[i], adjoints[i]);
+    }
+    auto adjoint_loop = make_loop_adjoint(loop.segment_loop);
+    adjoint_loop->begin = segment_begin;
+    adjoint_loop->end = segment_end;
+    current_block = old_current_block;
+    alloca_block = old_alloca_block;
+  }
+
+  RangeForStmt *make_loop_adjoint(RangeForStmt *for_stmt) {
     auto new_for = for_stmt->clone();
     auto new_for_ptr = new_for->as<RangeForStmt>();
     new_for_ptr->reversed = !new_for_ptr->reversed;
@@ -1475,6 +1822,7 @@ class MakeAdjoint : public ADTransform {
     }
     forward_backup = old_forward_backup;
     alloca_block = old_alloca_block;
+    return new_for_ptr;
   }
 
   void visit(StructForStmt *for_stmt) override {
@@ -1863,6 +2211,9 @@ class MakeAdjoint : public ADTransform {
       accumulate(stmt->values[i], load(matrix_ptr_stmt_i));
     }
   }
+
+ private:
+  const CheckpointedLoops &checkpointed_loops_;
 };
 
 // Forward mode autodiff
@@ -2324,6 +2675,60 @@ class BackupSSA : public BasicStmtVisitor {
   }
 };
 
+/* The gathers of a field in the primal kernel become scatters (atomic adds)
+ * to its adjoint in the backward kernel, which contend on the same cells. For
+ * struct-fors that cache a field with ti.block_local, this pass marks the
+ * adjoint block-local as well, so that make_block_local accumulates the
+ * adjoint in a block-local buffer and adds the buffer to the global field once
+ * per block. Adjoints that are also read in the loop are left alone.
+ */
+class MakeAdjointsBlockLocal : public BasicStmtVisitor {
+ public:
+  using BasicStmtVisitor::visit;
+
+  void visit(StructForStmt *for_stmt) override {
+    auto &mem_access_opt = for_stmt->mem_access_opt;
+    for (auto *snode :
+         mem_access_opt.get_snodes_with_flag(SNodeAccessFlag::block_local)) {
+      if (snode->has_adjoint() &&
+          is_only_accumulated(for_stmt->body.get(), snode->get_adjoint())) {
+        mem_access_opt.add_flag(snode->get_adjoint(),
+                                SNodeAccessFlag::block_local);
+      }
+    }
+    for_stmt->body->accept(this);
+  }
+
+  static void run(IRNode *root) {
+    MakeAdjointsBlockLocal pass;
+    root->accept(&pass);
+  }
+
+ private:
+  static bool is_only_accumulated(Block *body, SNode *snode) {
+    bool accumulated = false;
+    bool other_accesses = false;
+    irpass::analysis::gather_statements(body, [&](Stmt *stmt) {
+      for (auto *op : stmt->get_operands()) {
+        auto ptr = op ? op->cast<GlobalPtrStmt>() : nullptr;
+        if (!ptr || ptr->snode != snode) {
+          continue;
+        }
+        auto atomic = stmt->cast<AtomicOpStmt>();
+        if (atomic && atomic->dest == ptr &&
+            (atomic->op_type == AtomicOpType::add ||
+             atomic->op_type == AtomicOpType::sub)) {
+          accumulated = true;
+        } else {
+          other_accesses = true;
+        }
+      }
+      return false;
+    });
+    return accumulated && !other_accesses;
+  }
+};
+
 namespace irpass {
 
 // clang-format off
@@ -2404,9 +2809,14 @@ void auto_diff(IRNode *root,
         PromoteSSA2LocalVar::run(ib);
         ReplaceLocalVarWithStacks replace(config.ad_stack_size);
         ib->accept(&replace);
+        CheckpointedLoops checkpointed_loops;
+        if (config.ad_checkpointing) {
+          checkpointed_loops = CheckpointLoops::run(ib, config);
+        }
         type_check(root, config);
 
-        MakeAdjoint::run(ib);
+        MakeAdjoint::run(ib, checkpointed_loops);
+        CheckpointLoops::stop_recording(checkpointed_loops);
         type_check(root, config);
         BackupSSA::run(ib);
         irpass::analysis::verify(root);
@@ -2422,6 +2832,9 @@ void auto_diff(IRNode *root,
         irpass::analysis::verify(root);
       }
     }
+    if (config.ad_block_local_adjoints) {
+      MakeAdjointsBlockLocal::run(root);
+    }
   } else if (autodiff_mode == AutodiffMode::kForward) {
     // Forward mode autodiff
     Block *block = root->as<Block>();
@@ -30,6 +30,24 @@ class CheckOutOfBound : public BasicStmtVisitor {
   }
 
   void visit(SNodeOpStmt *stmt) override {
+    if (stmt->op_type == SNodeOpType::allocate && !is_done(stmt)) {
+      // The runtime ignores appends to a full list. |val| holds the index
+      // the element would have been appended at.
+      auto new_stmts = VecStatement();
+      auto index = new_stmts.push_back<LocalLoadStmt>(stmt->val);
+      auto capacity = new_stmts.push_back<ConstStmt>(
+          TypedConstant((int32)stmt->snode->max_num_elements()));
+      auto check = new_stmts.push_back<BinaryOpStmt>(BinaryOpType::cmp_lt,
+                                                     index, capacity);
+      std::string msg = fmt::format(
+          "(kernel={}) Appending to a full dynamic field ({}) of size {} at "
+          "index %d\n{}",
+          kernel_name, stmt->snode->get_node_type_name_hinted(),
+          stmt->snode->max_num_elements(), stmt->get_tb());
+      new_stmts.push_back<AssertStmt>(check, msg, std::vector<Stmt *>{index});
+      modifier.insert_after(stmt, std::move(new_stmts));
+      set_done(stmt);
+    }
     if (stmt->ptr != nullptr) {
       TI_ASSERT(stmt->ptr->is<GlobalPtrStmt>());
       // We have already done the check on its ptr argument. No need to do
@@ -9,6 +9,8 @@
 #include "taichi/program/kernel.h"
 #include "taichi/util/lang_util.h"
 
+#include <mutex>
+
 namespace taichi::lang {
 
 namespace irpass {
@@ -19,9 +21,16 @@ void compile_to_offloads(IRNode *ir,
                          bool verbose,
                          AutodiffMode autodiff_mode,
                          bool ad_use_stack,
-                         bool start_from_ast) {
+                         bool start_from_ast,
+                         AnalysisManager *amgr) {
   TI_AUTO_PROF;
 
+  std::unique_ptr<AnalysisManager> owned_amgr;
+  if (!amgr) {
+    owned_amgr = std::make_unique<AnalysisManager>();
+    amgr = owned_amgr.get();
+  }
+
   auto print = make_pass_printer(verbose, config.print_ir_dbg_info,
                                  kernel->get_name(), ir);
   print("Initial IR");
@@ -45,11 +54,18 @@ void compile_to_offloads(IRNode *ir,
     print("Lowered");
   }
 
-  irpass::compile_taichi_functions(ir, config,
-                                   Function::IRStage::BeforeLowerAccess);
-  irpass::analysis::gather_func_store_dests(ir);
-  irpass::compile_taichi_functions(ir, config, Function::IRStage::OptimizedIR);
-  irpass::analysis::gather_func_store_dests(ir);
+  {
+    // Real functions are shared between kernels, which may be compiled
+    // concurrently. Once they reach OptimizedIR they are no longer modified.
+    static std::mutex functions_mut;
+    std::lock_guard<std::mutex> _(functions_mut);
+    irpass::compile_taichi_functions(ir, config,
+                                     Function::IRStage::BeforeLowerAccess);
+    irpass::analysis::gather_func_store_dests(ir);
+    irpass::compile_taichi_functions(ir, config,
+                                     Function::IRStage::OptimizedIR);
+    irpass::analysis::gather_func_store_dests(ir);
+  }
 
   irpass::eliminate_immutable_local_vars(ir);
   print("Immutable local vars eliminated");
@@ -82,7 +98,7 @@ void compile_to_offloads(IRNode *ir,
   irpass::full_simplify(
       ir, config,
       {false, /*autodiff_enabled*/ autodiff_mode != AutodiffMode::kNone,
-       kernel->get_name(), verbose});
+       kernel->get_name(), verbose, amgr});
   print("Simplified I");
   irpass::analysis::verify(ir);
 
@@ -110,12 +126,12 @@ void compile_to_offloads(IRNode *ir,
 
     irpass::full_simplify(
         ir, config,
-        {false, /*autodiff_enabled*/ true, kernel->get_name(), verbose});
+        {false, /*autodiff_enabled*/ true, kernel->get_name(), verbose, amgr});
     irpass::auto_diff(ir, config, autodiff_mode, ad_use_stack);
     // TODO: Be carefull with the full_simplify when do high-order autodiff
     irpass::full_simplify(
         ir, config,
-        {false, /*autodiff_enabled*/ false, kernel->get_name(), verbose});
+        {false, /*autodiff_enabled*/ false, kernel->get_name(), verbose, amgr});
     print("Gradient");
     irpass::analysis::verify(ir);
   }
@@ -132,7 +148,7 @@ void compile_to_offloads(IRNode *ir,
 
   irpass::full_simplify(
       ir, config,
-      {false, /*autodiff_enabled*/ false, kernel->get_name(), verbose});
+      {false, /*autodiff_enabled*/ false, kernel->get_name(), verbose, amgr});
   print("Simplified II");
   irpass::analysis::verify(ir);
 
@@ -144,9 +160,16 @@ void compile_to_offloads(IRNode *ir,
   irpass::flag_access(ir);
   print("Access flagged II");
 
+  if (config.offload_fusion) {
+    if (irpass::fuse_offloads(ir, config)) {
+      print("Offloaded tasks fused");
+      irpass::analysis::verify(ir);
+    }
+  }
+
   irpass::full_simplify(
       ir, config,
-      {false, /*autodiff_enabled*/ false, kernel->get_name(), verbose});
+      {false, /*autodiff_enabled*/ false, kernel->get_name(), verbose, amgr});
   print("Simplified III");
   irpass::analysis::verify(ir);
 }
@@ -158,7 +181,8 @@ void offload_to_executable(IRNode *ir,
                            bool determine_ad_stack_size,
                            bool lower_global_access,
                            bool make_thread_local,
-                           bool make_block_local) {
+                           bool make_block_local,
+                           AnalysisManager *amgr) {
   TI_AUTO_PROF;
 
   auto print = make_pass_printer(verbose, config.print_ir_dbg_info,
@@ -169,7 +193,11 @@ void offload_to_executable(IRNode *ir,
   // For now, putting this after TLS will disable TLS, because it can only
   // handle range-fors at this point.
 
-  auto amgr = std::make_unique<AnalysisManager>();
+  std::unique_ptr<AnalysisManager> owned_amgr;
+  if (!amgr) {
+    owned_amgr = std::make_unique<AnalysisManager>();
+    amgr = owned_amgr.get();
+  }
 
   print("Start offload_to_executable");
   irpass::analysis::verify(ir);
@@ -188,6 +216,15 @@ void offload_to_executable(IRNode *ir,
     print("Cache loop-invariant global vars");
   }
 
+  if (config.demote_dense_struct_fors && config.cpu_loop_tiling &&
+      arch_is_cpu(config.arch)) {
+    if (irpass::tile_dense_struct_fors(ir, config)) {
+      irpass::type_check(ir, config);
+      print("Dense struct-for tiled");
+      irpass::analysis::verify(ir);
+    }
+  }
+
   if (config.demote_dense_struct_fors) {
     irpass::demote_dense_struct_fors(ir);
     irpass::type_check(ir, config);
@@ -223,13 +260,17 @@ void offload_to_executable(IRNode *ir,
       print("Make mesh block local");
       irpass::full_simplify(
           ir, config,
-          {false, /*autodiff_enabled*/ false, kernel->get_name(), verbose});
+          {false, /*autodiff_enabled*/ false, kernel->get_name(), verbose,
+           amgr});
       print("Simplified X");
     }
   }
 
   if (make_block_local) {
-    irpass::make_block_local(ir, config, {kernel->get_name(), verbose});
+    irpass::make_block_local(
+        ir, config,
+        {kernel->get_name(), verbose,
+         /*accumulation_only=*/arch_is_cpu(config.arch)});
     print("Make block local");
   }
 
@@ -244,7 +285,7 @@ void offload_to_executable(IRNode *ir,
 
   if (is_extension_supported(config.arch, Extension::quant) &&
       config.quant_opt_atomic_demotion) {
-    irpass::analysis::gather_uniquely_accessed_bit_structs(ir, amgr.get());
+    irpass::analysis::gather_uniquely_accessed_bit_structs(ir, amgr);
   }
 
   irpass::remove_range_assumption(ir);
@@ -257,7 +298,7 @@ void offload_to_executable(IRNode *ir,
   if (lower_global_access) {
     irpass::full_simplify(
         ir, config,
-        {false, /*autodiff_enabled*/ false, kernel->get_name(), verbose});
+        {false, /*autodiff_enabled*/ false, kernel->get_name(), verbose, amgr});
     print("Simplified before lower access");
     irpass::lower_access(ir, config, {kernel->no_activate, true});
     print("Access lowered");
@@ -277,7 +318,7 @@ void offload_to_executable(IRNode *ir,
 
   irpass::full_simplify(ir, config,
                         {lower_global_access, /*autodiff_enabled*/ false,
-                         kernel->get_name(), verbose});
+                         kernel->get_name(), verbose, amgr});
   print("Simplified IV");
 
   if (determine_ad_stack_size) {
@@ -286,7 +327,7 @@ void offload_to_executable(IRNode *ir,
   }
 
   if (is_extension_supported(config.arch, Extension::quant)) {
-    irpass::optimize_bit_struct_stores(ir, config, amgr.get());
+    irpass::optimize_bit_struct_stores(ir, config, amgr);
     print("Bit struct stores optimized");
   }
 
@@ -301,11 +342,19 @@ void offload_to_executable(IRNode *ir,
       // Remove redundant MatrixInitStmt inserted during scalarization
       irpass::full_simplify(
           ir, config,
-          {false, /*autodiff_enabled*/ false, kernel->get_name(), verbose});
+          {false, /*autodiff_enabled*/ false, kernel->get_name(), verbose,
+           amgr});
       print("Scalarized");
     }
   }
 
+  if (config.slp_vectorization && arch_is_cpu(config.arch) &&
+      config.real_matrix_scalarize) {
+    if (irpass::slp_vectorize(ir, config)) {
+      print("SLP vectorized");
+    }
+  }
+
   // Final field registration correctness & type checking
   irpass::type_check(ir, config);
   irpass::analysis::verify(ir);
@@ -323,14 +372,16 @@ void compile_to_executable(IRNode *ir,
                            bool start_from_ast) {
   TI_AUTO_PROF;
 
+  // Shared so that simplification results carry over between the two halves
+  AnalysisManager amgr;
   compile_to_offloads(ir, config, kernel, verbose, autodiff_mode, ad_use_stack,
-                      start_from_ast);
+                      start_from_ast, &amgr);
 
   offload_to_executable(
       ir, config, kernel, verbose,
       /*determine_ad_stack_size=*/autodiff_mode == AutodiffMode::kReverse &&
           ad_use_stack,
-      lower_global_access, make_thread_local, make_block_local);
+      lower_global_access, make_thread_local, make_block_local, &amgr);
 }
 
 void compile_function(IRNode *ir,
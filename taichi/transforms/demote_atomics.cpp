@@ -36,6 +36,11 @@ class DemoteAtomics : public BasicStmtVisitor {
       if (stmt->dest->is<ThreadLocalPtrStmt>()) {
         demote = true;
       }
+      if (stmt->dest->is<BlockLocalPtrStmt>() &&
+          arch_is_cpu(current_offloaded->device)) {
+        // A block is processed by a single thread on CPU.
+        demote = true;
+      }
       if (current_offloaded->task_type == OffloadedTaskType::serial) {
         demote = true;
       }
@@ -61,19 +61,55 @@ void convert_to_range_for(OffloadedStmt *offloaded) {
     }
     total_n /= snode->num_cells_per_container;
     extracted = generate_div(&body_header, extracted, total_n);
+    // Morton layouts: bricks of 2^m cells per axis in row-major order, and
+    // Z-order within a brick (see ScalarPointerLowerer).
+    const int m = snode->morton_bits;
+    int d = 0;
+    for (auto p : physical_indices) {
+      d += (int)snode->extractors[p].active;
+    }
+    Stmt *code = nullptr;
+    if (m > 0) {
+      code = generate_mod(&body_header, extracted, 1 << (m * d));
+      extracted = generate_div(&body_header, extracted, 1 << (m * d));
+    }
     bool is_first_extraction = true;
+    int q = 0;
     for (int j = 0; j < (int)physical_indices.size(); j++) {
       auto p = physical_indices[j];
       auto ext = snode->extractors[p];
       if (!ext.active)
         continue;
+      // Shape and accumulated shape of the row-major part of the layout.
+      int shape = ext.shape;
+      int acc_shape = ext.acc_shape;
+      Stmt *morton_index = nullptr;
+      if (m > 0) {
+        // The number of active axes after this one.
+        const int num_minor_axes = d - 1 - q++;
+        auto bits = generate_div(&body_header, code, 1 << num_minor_axes);
+        morton_index = generate_morton_gather(&body_header, bits, m, d);
+        shape >>= m;
+        acc_shape >>= m * num_minor_axes;
+      }
       Stmt *index = extracted;
-      if (is_first_extraction) {  // first extraction doesn't need a mod
-        is_first_extraction = false;
+      if (shape == 1) {
+        index = body_header.push_back<ConstStmt>(TypedConstant(0));
       } else {
-        index = generate_mod(&body_header, index, ext.acc_shape * ext.shape);
+        if (is_first_extraction) {  // first extraction doesn't need a mod
+          is_first_extraction = false;
+        } else {
+          index = generate_mod(&body_header, index, acc_shape * shape);
+        }
+        index = generate_div(&body_header, index, acc_shape);
+      }
+      if (morton_index) {
+        auto brick_bits = body_header.push_back<ConstStmt>(TypedConstant(m));
+        index = body_header.push_back<BinaryOpStmt>(BinaryOpType::bit_shl,
+                                                    index, brick_bits);
+        index = body_header.push_back<BinaryOpStmt>(BinaryOpType::bit_or,
+                                                    index, morton_index);
       }
-      index = generate_div(&body_header, index, ext.acc_shape);
       total_shape[p] /= ext.shape;
       auto multiplier =
           body_header.push_back<ConstStmt>(TypedConstant(total_shape[p]));
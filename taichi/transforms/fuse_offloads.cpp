@@ -0,0 +1,446 @@
+#include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/ir/visitors.h"
+#include "taichi/system/profiler.h"
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <typeinfo>
+
+namespace taichi::lang {
+
+namespace {
+
+using TaskType = OffloadedStmt::TaskType;
+
+// The global memory accesses of an offloaded task, grouped by what they may
+// alias.
+struct TaskAccesses {
+  struct SNodeAccess {
+    bool read{false};
+    bool written{false};
+    // The index tuples of the GlobalPtrStmts; nullopt if the SNode is also
+    // accessed in a way we don't analyze (e.g. through a MatrixPtrStmt).
+    std::optional<std::vector<std::vector<Stmt *>>> indices{
+        std::vector<std::vector<Stmt *>>()};
+  };
+
+  std::map<SNode *, SNodeAccess> snodes;
+  std::set<std::size_t> temporaries_read, temporaries_written;
+  bool externals_read{false};
+  bool externals_written{false};
+  // Contains statements that must stay in their own task.
+  bool unfusable{false};
+};
+
+// Structural equality of index expressions of the tasks |a| and |b|, where
+// the loop indices of |a| and |b| are considered the same.
+bool equivalent_index(Stmt *x, Stmt *y, Stmt *a, Stmt *b) {
+  if (x == y) {
+    return true;
+  }
+  if (typeid(*x) != typeid(*y) || x->ret_type != y->ret_type) {
+    return false;
+  }
+  if (auto x_index = x->cast<LoopIndexStmt>()) {
+    auto y_index = y->as<LoopIndexStmt>();
+    return (x_index->loop == a || x_index->loop == b) &&
+           (y_index->loop == a || y_index->loop == b) &&
+           x_index->index == y_index->index;
+  }
+  if (auto x_const = x->cast<ConstStmt>()) {
+    return x_const->val.equal_type_and_value(y->as<ConstStmt>()->val);
+  }
+  if (auto x_unary = x->cast<UnaryOpStmt>()) {
+    auto y_unary = y->as<UnaryOpStmt>();
+    return x_unary->same_operation(y_unary) &&
+           equivalent_index(x_unary->operand, y_unary->operand, a, b);
+  }
+  if (auto x_binary = x->cast<BinaryOpStmt>()) {
+    auto y_binary = y->as<BinaryOpStmt>();
+    return x_binary->op_type == y_binary->op_type &&
+           equivalent_index(x_binary->lhs, y_binary->lhs, a, b) &&
+           equivalent_index(x_binary->rhs, y_binary->rhs, a, b);
+  }
+  return false;
+}
+
+std::optional<int64> get_const_int(Stmt *stmt) {
+  if (auto c = stmt->cast<ConstStmt>(); c && is_integral(c->ret_type)) {
+    return c->val.val_as_int64();
+  }
+  return std::nullopt;
+}
+
+// Strips additions of constants, e.g. the lower bounds of ti.ndrange.
+Stmt *strip_offset(Stmt *stmt) {
+  while (auto bin = stmt->cast<BinaryOpStmt>()) {
+    if ((bin->op_type == BinaryOpType::add ||
+         bin->op_type == BinaryOpType::sub) &&
+        get_const_int(bin->rhs)) {
+      stmt = bin->lhs;
+    } else if (bin->op_type == BinaryOpType::add && get_const_int(bin->lhs)) {
+      stmt = bin->rhs;
+    } else {
+      break;
+    }
+  }
+  return stmt;
+}
+
+using Matcher = std::function<bool(Stmt *)>;
+
+// Returns n if |stmt| = y / n for a positive constant n.
+std::optional<int64> get_divisor(Stmt *stmt) {
+  auto bin = stmt->cast<BinaryOpStmt>();
+  if (!bin) {
+    return std::nullopt;
+  }
+  auto rhs = get_const_int(bin->rhs);
+  if (!rhs) {
+    return std::nullopt;
+  }
+  if ((bin->op_type == BinaryOpType::div ||
+       bin->op_type == BinaryOpType::floordiv) &&
+      *rhs > 0) {
+    return rhs;
+  }
+  if (bin->op_type == BinaryOpType::bit_shr && *rhs >= 0 && *rhs < 62) {
+    return int64(1) << *rhs;
+  }
+  return std::nullopt;
+}
+
+// Matches |stmt| = x / n for a statement x matched by |x|.
+bool is_quotient(Stmt *stmt, const Matcher &x, int64 n) {
+  return get_divisor(stmt) == n && x(stmt->as<BinaryOpStmt>()->lhs);
+}
+
+// Matches |stmt| = x % n for a statement x matched by |x|.
+bool is_remainder(Stmt *stmt, const Matcher &x, int64 n) {
+  auto bin = stmt->cast<BinaryOpStmt>();
+  if (!bin) {
+    return false;
+  }
+  auto rhs = get_const_int(bin->rhs);
+  if (bin->op_type == BinaryOpType::mod) {
+    return rhs && *rhs == n && x(bin->lhs);
+  }
+  if (bin->op_type == BinaryOpType::bit_and) {
+    return rhs && *rhs == n - 1 && (n & (n - 1)) == 0 && x(bin->lhs);
+  }
+  if (bin->op_type == BinaryOpType::sub) {
+    // x - x / n * n, as emitted for ti.ndrange.
+    auto mul = bin->rhs->cast<BinaryOpStmt>();
+    if (!mul || mul->op_type != BinaryOpType::mul || !x(bin->lhs)) {
+      return false;
+    }
+    auto quotient = get_const_int(mul->rhs) ? mul->lhs : mul->rhs;
+    auto factor = get_const_int(mul->rhs) ? mul->rhs : mul->lhs;
+    return get_const_int(factor) == n && is_quotient(quotient, x, n);
+  }
+  return false;
+}
+
+// Whether the value matched by |x| can be reconstructed from |components|,
+// i.e. whether |components| is an injective function of it.
+bool determines(const Matcher &x,
+                const std::vector<Stmt *> &components,
+                int depth) {
+  for (auto component : components) {
+    if (x(component)) {
+      return true;
+    }
+  }
+  if (depth == 0) {
+    return false;
+  }
+  // (x / n, x % n) determines x.
+  for (auto component : components) {
+    auto n = get_divisor(component);
+    if (n && is_quotient(component, x, *n) &&
+        determines([&](Stmt *s) { return is_remainder(s, x, *n); },
+                   components, depth - 1)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Whether different iterations of |task| access different elements through
+// |indices|.
+bool is_injective(OffloadedStmt *task, const std::vector<Stmt *> &indices) {
+  std::vector<Stmt *> components;
+  for (auto index : indices) {
+    components.push_back(strip_offset(index));
+  }
+  // The loop indices of a struct-for are numbered by physical index.
+  std::vector<int> loop_indices{0};
+  if (task->task_type == TaskType::struct_for) {
+    loop_indices.clear();
+    for (int i = 0; i < task->snode->num_active_indices; i++) {
+      loop_indices.push_back(task->snode->physical_index_position[i]);
+    }
+  }
+  for (int i : loop_indices) {
+    auto is_loop_index = [&](Stmt *s) {
+      auto loop_index = s->cast<LoopIndexStmt>();
+      return loop_index && loop_index->loop == task && loop_index->index == i;
+    };
+    if (!determines(is_loop_index, components, (int)components.size())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TaskAccesses gather_accesses(OffloadedStmt *task) {
+  TaskAccesses accesses;
+  irpass::analysis::gather_statements(task->body.get(), [&](Stmt *stmt) {
+    if (stmt->is<FuncCallStmt>() || stmt->is<ReturnStmt>() ||
+        stmt->is<PrintStmt>() || stmt->is<SNodeOpStmt>() ||
+        stmt->is<ExternalFuncCallStmt>() || stmt->is<InternalFuncStmt>() ||
+        stmt->is<TextureOpStmt>() || stmt->is<ReferenceStmt>()) {
+      accesses.unfusable = true;
+    } else if (auto cont = stmt->cast<ContinueStmt>()) {
+      // A continue of the task would skip the body of the next task too.
+      if (cont->scope == nullptr || cont->scope == task) {
+        accesses.unfusable = true;
+      }
+    }
+
+    Stmt *ptr = nullptr;
+    bool read = false, write = false;
+    if (auto load = stmt->cast<GlobalLoadStmt>()) {
+      ptr = load->src;
+      read = true;
+    } else if (auto store = stmt->cast<GlobalStoreStmt>()) {
+      ptr = store->dest;
+      write = true;
+    } else if (auto atomic = stmt->cast<AtomicOpStmt>()) {
+      ptr = atomic->dest;
+      read = write = true;
+    }
+    if (!ptr || ptr->is<AllocaStmt>()) {
+      return false;
+    }
+    bool analyzed = true;
+    if (auto matrix_ptr = ptr->cast<MatrixPtrStmt>()) {
+      ptr = matrix_ptr->origin;
+      analyzed = false;
+    }
+    if (ptr->is<AllocaStmt>()) {
+      return false;
+    } else if (auto global_ptr = ptr->cast<GlobalPtrStmt>()) {
+      auto &access = accesses.snodes[global_ptr->snode];
+      access.read |= read;
+      access.written |= write;
+      if (!analyzed) {
+        access.indices = std::nullopt;
+      } else if (access.indices) {
+        access.indices->push_back(global_ptr->indices);
+      }
+    } else if (auto temp = ptr->cast<GlobalTemporaryStmt>()) {
+      if (read) {
+        accesses.temporaries_read.insert(temp->offset);
+      }
+      if (write) {
+        accesses.temporaries_written.insert(temp->offset);
+      }
+    } else if (ptr->is<ExternalPtrStmt>()) {
+      accesses.externals_read |= read;
+      accesses.externals_written |= write;
+    } else {
+      accesses.unfusable = true;
+    }
+    return false;
+  });
+  return accesses;
+}
+
+bool has_conflict(const std::set<std::size_t> &written,
+                  const std::set<std::size_t> &read,
+                  const std::set<std::size_t> &other_written) {
+  for (auto offset : written) {
+    if (read.count(offset) || other_written.count(offset)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* This pass fuses adjacent offloaded range-fors (with the same constant
+ * bounds) or dense struct-fors (over the same SNode) into one task, when the
+ * second task only depends on the first one pointwise. For example,
+ *
+ *   for i in x:
+ *     y[i] = x[i] * 2
+ *   for i in x:
+ *     z[i] = y[i] + 1
+ *
+ * becomes a single task that computes y[i] and z[i] in the same iteration, so
+ * the two loops cost one launch and, after store-to-load forwarding, one pass
+ * over memory.
+ *
+ * Two tasks are fused if, for every SNode written by one task and accessed by
+ * the other, all accesses in both tasks use the same index expressions and
+ * these expressions are injective in the loop index (e.g. x[i], x[i + 1] or
+ * the div/mod decomposition of ti.ndrange). The iteration that writes an
+ * element is then the only one that accesses it in either task. Ndarrays and
+ * global temporaries written by one task must not be accessed by the other at
+ * all, since different arguments may alias and temporaries are not indexed.
+ * Written SNodes must be dense and not bit-level, so that writes don't
+ * activate or share storage with other elements.
+ */
+class FuseOffloads {
+ public:
+  explicit FuseOffloads(const CompileConfig &config) : config_(config) {
+  }
+
+  bool run(Block *block) {
+    bool modified = false;
+    OffloadedStmt *current = nullptr;
+    TaskAccesses current_accesses;
+    std::vector<Stmt *> to_erase;
+    for (auto &stmt : block->statements) {
+      auto task = stmt->cast<OffloadedStmt>();
+      if (!task || !is_candidate(task)) {
+        current = nullptr;
+        continue;
+      }
+      auto accesses = gather_accesses(task);
+      if (current && same_iteration_space(current, task) &&
+          can_fuse(current, current_accesses, task, accesses)) {
+        fuse(current, task);
+        to_erase.push_back(task);
+        current_accesses = gather_accesses(current);
+        modified = true;
+      } else {
+        current = task;
+        current_accesses = std::move(accesses);
+      }
+    }
+    for (auto stmt : to_erase) {
+      block->erase(stmt);
+    }
+    return modified;
+  }
+
+ private:
+  bool is_candidate(OffloadedStmt *task) const {
+    if (task->task_type == TaskType::range_for) {
+      return task->const_begin && task->const_end && !task->reversed;
+    }
+    return task->task_type == TaskType::struct_for &&
+           task->snode->is_path_all_dense && config_.demote_dense_struct_fors;
+  }
+
+  static bool same_iteration_space(OffloadedStmt *a, OffloadedStmt *b) {
+    if (a->task_type != b->task_type || a->grid_dim != b->grid_dim ||
+        a->block_dim != b->block_dim ||
+        a->num_cpu_threads != b->num_cpu_threads ||
+        a->is_bit_vectorized != b->is_bit_vectorized ||
+        !a->mem_access_opt.get_all().empty() ||
+        !b->mem_access_opt.get_all().empty()) {
+      return false;
+    }
+    if (a->task_type == TaskType::range_for) {
+      return a->begin_value == b->begin_value && a->end_value == b->end_value;
+    }
+    return a->snode == b->snode && a->index_offsets == b->index_offsets;
+  }
+
+  static bool can_fuse(OffloadedStmt *a,
+                       const TaskAccesses &a_accesses,
+                       OffloadedStmt *b,
+                       const TaskAccesses &b_accesses) {
+    if (a_accesses.unfusable || b_accesses.unfusable) {
+      return false;
+    }
+    if ((a_accesses.externals_written &&
+         (b_accesses.externals_read || b_accesses.externals_written)) ||
+        (a_accesses.externals_read && b_accesses.externals_written)) {
+      return false;
+    }
+    if (has_conflict(a_accesses.temporaries_written,
+                     b_accesses.temporaries_read,
+                     b_accesses.temporaries_written) ||
+        has_conflict(b_accesses.temporaries_written,
+                     a_accesses.temporaries_read, {})) {
+      return false;
+    }
+    for (auto *accesses : {&a_accesses, &b_accesses}) {
+      for (auto &[snode, access] : accesses->snodes) {
+        if (access.written && (!snode->is_path_all_dense ||
+                               snode->is_bit_level)) {
+          return false;
+        }
+      }
+    }
+    for (auto &[snode, a_access] : a_accesses.snodes) {
+      auto it = b_accesses.snodes.find(snode);
+      if (it == b_accesses.snodes.end()) {
+        continue;
+      }
+      auto &b_access = it->second;
+      if (!a_access.written && !b_access.written) {
+        continue;
+      }
+      if (!a_access.indices || !b_access.indices) {
+        return false;
+      }
+      const auto &reference = a_access.indices->front();
+      if (!is_injective(a, reference)) {
+        return false;
+      }
+      for (auto *all_indices : {&*a_access.indices, &*b_access.indices}) {
+        for (auto &indices : *all_indices) {
+          if (indices.size() != reference.size()) {
+            return false;
+          }
+          for (int i = 0; i < (int)indices.size(); i++) {
+            if (!equivalent_index(indices[i], reference[i], a, b)) {
+              return false;
+            }
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  static void fuse(OffloadedStmt *a, OffloadedStmt *b) {
+    irpass::replace_all_usages_with(b->body.get(), b, a);
+    for (auto &stmt : b->body->statements) {
+      a->body->insert(std::move(stmt));
+    }
+    b->body->statements.clear();
+  }
+
+  const CompileConfig &config_;
+};
+
+}  // namespace
+
+namespace irpass {
+
+bool fuse_offloads(IRNode *root, const CompileConfig &config) {
+  TI_AUTO_PROF;
+  auto block = root->cast<Block>();
+  if (!block) {
+    return false;
+  }
+  bool modified = FuseOffloads(config).run(block);
+  if (modified) {
+    re_id(root);
+  }
+  return modified;
+}
+
+}  // namespace irpass
+
+}  // namespace taichi::lang
@@ -6,6 +6,9 @@
 #include "taichi/ir/transforms.h"
 #include "taichi/ir/visitors.h"
 #include "taichi/ir/frontend_ir.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/system/compile_profiler.h"
+#include "taichi/system/timer.h"
 #include "taichi/util/str.h"
 
 namespace taichi::lang {
@@ -700,6 +703,9 @@ class IRPrinter : public IRVisitor {
       details =
           fmt::format("range_for({}, {}) grid_dim={} block_dim={}", begin_str,
                       end_str, stmt->grid_dim, stmt->block_dim);
+      if (stmt->tile_volume > 1) {
+        details += fmt::format(" tile_volume={}", stmt->tile_volume);
+      }
     } else if (stmt->task_type == OffloadedTaskType::struct_for) {
       details =
           fmt::format("struct_for({}) grid_dim={} block_dim={} bls={}",
@@ -986,16 +992,49 @@ std::function<void(const std::string &)> make_pass_printer(
     bool print_ir_dbg_info,
     const std::string &kernel_name,
     IRNode *ir) {
-  if (!verbose) {
-    return [](const std::string &) {};
-  }
-  return [ir, kernel_name, print_ir_dbg_info](const std::string &pass) {
+  auto print = [ir, kernel_name, print_ir_dbg_info](const std::string &pass) {
     TI_INFO("[{}] {}:", kernel_name, pass);
     std::cout << std::flush;
     irpass::re_id(ir);
     irpass::print(ir, /*output=*/nullptr, print_ir_dbg_info);
     std::cout << std::flush;
   };
+  if (!CompileProfiler::get_instance().get_enabled()) {
+    if (!verbose) {
+      return [](const std::string &) {};
+    }
+    return print;
+  }
+
+  // Each call closes the step that ran since the previous call (or since the
+  // printer was made), which is the pass named by the caller.
+  struct State {
+    float64 last_time;
+    int last_count;
+  };
+  auto state = std::make_shared<State>(
+      State{Time::get_time(), irpass::analysis::count_statements(ir)});
+  std::string task;
+  if (auto offload = ir->cast<OffloadedStmt>()) {
+    task = offload->task_name();
+  } else if (auto block = ir->cast<Block>();
+             block && block->size() == 1 &&
+             block->statements[0]->is<OffloadedStmt>()) {
+    // A single task cloned out of the kernel for codegen.
+    task = block->statements[0]->as<OffloadedStmt>()->task_name();
+  }
+  return [=](const std::string &pass) {
+    const int count = irpass::analysis::count_statements(ir);
+    CompileProfiler::get_instance().insert_record(
+        {kernel_name, task, pass, state->last_time, Time::get_time(),
+         state->last_count, count});
+    if (verbose) {
+      print(pass);
+    }
+    // Printing is not part of the next pass.
+    state->last_time = Time::get_time();
+    state->last_count = count;
+  };
 }
 
 }  // namespace irpass
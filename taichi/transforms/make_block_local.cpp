@@ -11,8 +11,9 @@ namespace {
 
 void make_block_local_offload(OffloadedStmt *offload,
                               const CompileConfig &config,
-                              const std::string &kernel_name,
-                              bool verbose) {
+                              const MakeBlockLocalPass::Args &args) {
+  const auto &kernel_name = args.kernel_name;
+  const bool verbose = args.verbose;
   if (offload->task_type != OffloadedStmt::TaskType::struct_for)
     return;
 
@@ -65,6 +66,11 @@ void make_block_local_offload(OffloadedStmt *offload,
     bool bls_has_write = pad.second.total_flags & AccessFlag::write;
     bool bls_has_accumulate = pad.second.total_flags & AccessFlag::accumulate;
 
+    if (args.accumulation_only &&
+        (bls_has_read || bls_has_write || !bls_has_accumulate)) {
+      continue;
+    }
+
     TI_ASSERT_INFO(!bls_has_write, "BLS with write accesses is not supported.")
     TI_ASSERT_INFO(!(bls_has_accumulate && bls_has_read),
                    "BLS with both read and accumulation is not supported.")
@@ -103,6 +109,75 @@ void make_block_local_offload(OffloadedStmt *offload,
             block = std::make_unique<Block>();
             block->set_parent_stmt(offload);
           }
+          // Fills |element_block| with the operation on one BLS element.
+          auto create_element = [&](Block *element_block,
+                                    Stmt *bls_element_id) {
+            auto bls_element_offset_bytes =
+                element_block->push_back<BinaryOpStmt>(
+                    BinaryOpType::mul, bls_element_id,
+                    element_block->push_back<ConstStmt>(
+                        TypedConstant(dtype_size)));
+
+            bls_element_offset_bytes = element_block->push_back<BinaryOpStmt>(
+                BinaryOpType::add, bls_element_offset_bytes,
+                element_block->push_back<ConstStmt>(
+                    TypedConstant((int32)bls_offset_in_bytes)));
+
+            std::vector<Stmt *> global_indices(dim);
+
+            // Convert bls_element_id to global indices
+            // via a series of % and /.
+            auto bls_element_id_partial = bls_element_id;
+            for (int i = dim - 1; i >= 0; i--) {
+              auto pad_size_stmt = element_block->push_back<ConstStmt>(
+                  TypedConstant(pad.second.pad_size[i]));
+
+              auto bls_coord = element_block->push_back<BinaryOpStmt>(
+                  BinaryOpType::mod, bls_element_id_partial, pad_size_stmt);
+              bls_element_id_partial = element_block->push_back<BinaryOpStmt>(
+                  BinaryOpType::div, bls_element_id_partial, pad_size_stmt);
+
+              auto global_index_this_dim =
+                  element_block->push_back<BinaryOpStmt>(
+                      BinaryOpType::add, bls_coord,
+                      element_block->push_back<ConstStmt>(
+                          TypedConstant(pad.second.bounds[i].low)));
+
+              auto block_corner =
+                  element_block->push_back<BlockCornerIndexStmt>(offload, i);
+              if (pad.second.coefficients[i] > 1) {
+                block_corner = element_block->push_back<BinaryOpStmt>(
+                    BinaryOpType::mul, block_corner,
+                    element_block->push_back<ConstStmt>(
+                        TypedConstant(pad.second.coefficients[i])));
+              }
+
+              global_index_this_dim = element_block->push_back<BinaryOpStmt>(
+                  BinaryOpType::add, global_index_this_dim, block_corner);
+
+              global_indices[i] = global_index_this_dim;
+            }
+
+            operation(element_block, global_indices, bls_element_offset_bytes);
+            // TODO: do not use GlobalStore for BLS ptr.
+          };
+
+          if (arch_is_cpu(config.arch)) {
+            // A block is processed by a single thread on CPU, so the thread
+            // walks over the whole BLS buffer in a serial loop.
+            auto begin = block->push_back<ConstStmt>(TypedConstant(0));
+            auto end =
+                block->push_back<ConstStmt>(TypedConstant(bls_num_elements));
+            auto loop = block->push_back<RangeForStmt>(
+                begin, end, std::make_unique<Block>(),
+                /*is_bit_vectorized=*/false, /*num_cpu_threads=*/1,
+                /*block_dim=*/1, /*strictly_serialized=*/true);
+            auto loop_body = loop->as<RangeForStmt>()->body.get();
+            create_element(loop_body,
+                           loop_body->push_back<LoopIndexStmt>(loop, 0));
+            return;
+          }
+
           // Equivalent to CUDA threadIdx
           Stmt *thread_idx_stmt =
               block->push_back<LoopLinearIndexStmt>(offload);
@@ -147,15 +222,6 @@ void make_block_local_offload(OffloadedStmt *offload,
             auto bls_element_id_this_iteration = block->push_back<BinaryOpStmt>(
                 BinaryOpType::add, loop_offset_stmt, thread_idx_stmt);
 
-            auto bls_element_offset_bytes = block->push_back<BinaryOpStmt>(
-                BinaryOpType::mul, bls_element_id_this_iteration,
-                block->push_back<ConstStmt>(TypedConstant(dtype_size)));
-
-            bls_element_offset_bytes = block->push_back<BinaryOpStmt>(
-                BinaryOpType::add, bls_element_offset_bytes,
-                block->push_back<ConstStmt>(
-                    TypedConstant((int32)bls_offset_in_bytes)));
-
             if (loop_offset + block_dim > bls_num_elements) {
               // Need to create an IfStmt to safeguard since bls size may not be
               // a multiple of block_size, and this iteration some threads may
@@ -173,43 +239,7 @@ void make_block_local_offload(OffloadedStmt *offload,
               element_block = block.get();
             }
 
-            std::vector<Stmt *> global_indices(dim);
-
-            // Convert bls_element_id to global indices
-            // via a series of % and /.
-            auto bls_element_id_partial = bls_element_id_this_iteration;
-            for (int i = dim - 1; i >= 0; i--) {
-              auto pad_size_stmt = element_block->push_back<ConstStmt>(
-                  TypedConstant(pad.second.pad_size[i]));
-
-              auto bls_coord = element_block->push_back<BinaryOpStmt>(
-                  BinaryOpType::mod, bls_element_id_partial, pad_size_stmt);
-              bls_element_id_partial = element_block->push_back<BinaryOpStmt>(
-                  BinaryOpType::div, bls_element_id_partial, pad_size_stmt);
-
-              auto global_index_this_dim =
-                  element_block->push_back<BinaryOpStmt>(
-                      BinaryOpType::add, bls_coord,
-                      element_block->push_back<ConstStmt>(
-                          TypedConstant(pad.second.bounds[i].low)));
-
-              auto block_corner =
-                  element_block->push_back<BlockCornerIndexStmt>(offload, i);
-              if (pad.second.coefficients[i] > 1) {
-                block_corner = element_block->push_back<BinaryOpStmt>(
-                    BinaryOpType::mul, block_corner,
-                    element_block->push_back<ConstStmt>(
-                        TypedConstant(pad.second.coefficients[i])));
-              }
-
-              global_index_this_dim = element_block->push_back<BinaryOpStmt>(
-                  BinaryOpType::add, global_index_this_dim, block_corner);
-
-              global_indices[i] = global_index_this_dim;
-            }
-
-            operation(element_block, global_indices, bls_element_offset_bytes);
-            // TODO: do not use GlobalStore for BLS ptr.
+            create_element(element_block, bls_element_id_this_iteration);
 
             loop_offset += block_dim;
           }
@@ -381,12 +411,10 @@ void make_block_local(IRNode *root,
 
   if (auto root_block = root->cast<Block>()) {
     for (auto &offload : root_block->statements) {
-      make_block_local_offload(offload->cast<OffloadedStmt>(), config,
-                               args.kernel_name, args.verbose);
+      make_block_local_offload(offload->cast<OffloadedStmt>(), config, args);
     }
   } else {
-    make_block_local_offload(root->as<OffloadedStmt>(), config,
-                             args.kernel_name, args.verbose);
+    make_block_local_offload(root->as<OffloadedStmt>(), config, args);
   }
   type_check(root, config);
 }
@@ -11,6 +11,9 @@ class MakeBlockLocalPass : public Pass {
   struct Args {
     std::string kernel_name;
     bool verbose;
+    // Only cache the fields that are accumulated to, e.g. on CPUs, where the
+    // hardware caches already serve the reads.
+    bool accumulation_only{false};
   };
 };
 
@@ -109,6 +109,21 @@ class MakeCPUMultithreadedRangeFor : public BasicStmtVisitor {
         BinaryOpType::floordiv, saturated_total_range, num_threads));
     block_range = offloaded_body->insert(Stmt::make_typed<BinaryOpStmt>(
         BinaryOpType::max, block_range, minimal_block_range));
+    if (offloaded->tile_volume > 1) {
+      // Round up to whole tiles, see tile_dense_struct_fors.
+      auto tile_volume = offloaded_body->insert(Stmt::make_typed<ConstStmt>(
+          TypedConstant(PrimitiveType::i32, offloaded->tile_volume)));
+      auto num_tiles = offloaded_body->insert(Stmt::make_typed<BinaryOpStmt>(
+          BinaryOpType::floordiv,
+          offloaded_body->insert(Stmt::make_typed<BinaryOpStmt>(
+              BinaryOpType::sub,
+              offloaded_body->insert(Stmt::make_typed<BinaryOpStmt>(
+                  BinaryOpType::add, block_range, tile_volume)),
+              one)),
+          tile_volume));
+      block_range = offloaded_body->insert(Stmt::make_typed<BinaryOpStmt>(
+          BinaryOpType::mul, num_tiles, tile_volume));
+    }
 
     // Inner loop begins at
     // begin + block_range * thread_id
@@ -142,6 +157,7 @@ class MakeCPUMultithreadedRangeFor : public BasicStmtVisitor {
     offloaded->body = std::move(offloaded_body);
     offloaded->body->set_parent_stmt(offloaded);
     offloaded->block_dim = 1;
+    offloaded->tile_volume = 1;
     modified = true;
   }
 
@@ -14,6 +14,16 @@ namespace taichi::lang {
 
 namespace {
 
+// Reductions to fields with constant indices, e.g. the adjoints of a few
+// global parameters read by every iteration, are only demoted while the TLS
+// buffer stays within this size.
+constexpr std::size_t kMaxConstantIndexedTLSBytes = 256;
+
+bool has_constant_indices(GlobalPtrStmt *ptr) {
+  return std::all_of(ptr->indices.begin(), ptr->indices.end(),
+                     [](Stmt *index) { return index->is<ConstStmt>(); });
+}
+
 // Find the destinations of global atomic reductions that can be demoted into
 // TLS buffer.
 template <typename T>
@@ -107,10 +117,10 @@ void make_thread_local_offload(OffloadedStmt *offload) {
     auto valid_global_ptrs = find_global_reduction_destinations<GlobalPtrStmt>(
         offload, [](GlobalPtrStmt *dest) {
           // We can only optimized reductions to global ptrs with form like
-          // loss[None] (0-D fields) for now.
+          // loss[None] (0-D fields) or w[0, 1] for now.
           // No TLS on quant types.
           return (dest->snode->type == SNodeType::place) &&
-                 dest->indices.empty() &&
+                 has_constant_indices(dest) &&
                  (dest->ret_type.ptr_removed()->is<PrimitiveType>() ||
                   dest->ret_type.ptr_removed()->is<TensorType>());
         });
@@ -137,6 +147,11 @@ void make_thread_local_offload(OffloadedStmt *offload) {
   for (auto dest : valid_reduction_values) {
     auto data_type = dest.first->ret_type.ptr_removed();
     auto dtype_size = data_type_size(data_type);
+    if (auto global_ptr = dest.first->cast<GlobalPtrStmt>();
+        global_ptr && !global_ptr->indices.empty() &&
+        tls_offset + dtype_size > kMaxConstantIndexedTLSBytes) {
+      continue;
+    }
     // Step 1:
     // Create thread local storage
     {
@@ -196,10 +211,22 @@ void make_thread_local_offload(OffloadedStmt *offload) {
           tls_offset, TypeFactory::get_instance().get_pointer_type(data_type));
       // TODO: do not use global load from TLS.
       auto tls_load = offload->tls_epilogue->push_back<GlobalLoadStmt>(tls_ptr);
-      auto global_ptr = offload->tls_epilogue->insert(
-          std::unique_ptr<Stmt>(
-              (Stmt *)irpass::analysis::clone(dest.first).release()),
-          -1);
+      Stmt *global_ptr = nullptr;
+      if (auto ptr = dest.first->cast<GlobalPtrStmt>();
+          ptr && !ptr->indices.empty()) {
+        // The indices live in the loop body.
+        std::vector<Stmt *> indices;
+        for (auto index : ptr->indices) {
+          indices.push_back(offload->tls_epilogue->insert(index->clone(), -1));
+        }
+        global_ptr = offload->tls_epilogue->push_back<GlobalPtrStmt>(
+            ptr->snode, indices, ptr->activate, ptr->is_cell_access);
+      } else {
+        global_ptr = offload->tls_epilogue->insert(
+            std::unique_ptr<Stmt>(
+                (Stmt *)irpass::analysis::clone(dest.first).release()),
+            -1);
+      }
       offload->tls_epilogue->insert(
           AtomicOpStmt::make_for_reduction(dest.second, global_ptr, tls_load),
           -1);
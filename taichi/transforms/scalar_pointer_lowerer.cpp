@@ -54,6 +54,7 @@ void ScalarPointerLowerer::run() {
     }
     std::vector<Stmt *> lowered_indices;
     std::vector<int> strides;
+    std::vector<Stmt *> morton_indices;
     // extract lowered indices
     for (int k_ = 0; k_ < (int)indices_.size(); k_++) {
       int k = leaf_snode->physical_index_position[k_];
@@ -74,9 +75,42 @@ void ScalarPointerLowerer::run() {
       }
       extracted = generate_div(lowered_, extracted, next);
       is_first_extraction[k] = false;
+      if (snode->morton_bits > 0) {
+        // Bricks of 2^morton_bits cells per axis in row-major order, and
+        // Z-order within a brick.
+        const int brick_size = 1 << snode->morton_bits;
+        morton_indices.push_back(generate_mod(lowered_, extracted, brick_size));
+        if (snode->extractors[k].shape > brick_size) {
+          lowered_indices.push_back(
+              generate_div(lowered_, extracted, brick_size));
+          strides.push_back(snode->extractors[k].shape / brick_size);
+        }
+        continue;
+      }
       lowered_indices.push_back(extracted);
       strides.push_back(snode->extractors[k].shape);
     }
+    if (!morton_indices.empty()) {
+      // Bit t of the q-th active axis goes to bit t * d + (d - 1 - q) of the
+      // Morton code, so that the last axis varies fastest as in row-major.
+      const int d = (int)morton_indices.size();
+      Stmt *code = nullptr;
+      for (int q = 0; q < d; q++) {
+        auto *spread = generate_morton_spread(lowered_, morton_indices[q],
+                                              snode->morton_bits, d);
+        if (q != d - 1) {
+          auto *shift =
+              lowered_->push_back<ConstStmt>(TypedConstant(d - 1 - q));
+          spread = lowered_->push_back<BinaryOpStmt>(BinaryOpType::bit_shl,
+                                                     spread, shift);
+        }
+        code = code ? lowered_->push_back<BinaryOpStmt>(BinaryOpType::bit_or,
+                                                        code, spread)
+                    : spread;
+      }
+      lowered_indices.push_back(code);
+      strides.push_back(1 << (snode->morton_bits * d));
+    }
     // linearize
     auto *linearized =
         lowered_->push_back<LinearizeStmt>(lowered_indices, strides);
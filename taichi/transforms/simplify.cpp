@@ -7,6 +7,7 @@
 #include "taichi/program/kernel.h"
 #include "taichi/program/program.h"
 #include "taichi/transforms/utils.h"
+#include <functional>
 #include <set>
 #include <unordered_set>
 #include <utility>
@@ -519,6 +520,72 @@ bool simplify(IRNode *root, const CompileConfig &config) {
   return modified;
 }
 
+namespace {
+
+// The passes of full_simplify that only look inside the IR node they run on.
+bool simplify_locally(IRNode *root,
+                      const CompileConfig &config,
+                      const std::function<void(const std::string &)> &print) {
+  bool modified = false;
+  if (extract_constant(root, config))
+    modified = true;
+  print("extract_constant");
+  if (unreachable_code_elimination(root))
+    modified = true;
+  print("unreachable_code_elimination");
+  if (binary_op_simplify(root, config))
+    modified = true;
+  print("binary_op_simplify");
+  if (config.constant_folding && constant_fold(root))
+    modified = true;
+  print("constant_fold");
+  if (die(root))
+    modified = true;
+  print("die");
+  if (alg_simp(root, config))
+    modified = true;
+  print("alg_simp");
+  if (loop_invariant_code_motion(root, config))
+    modified = true;
+  print("loop_invariant_code_motion");
+  if (die(root))
+    modified = true;
+  print("die");
+  if (simplify(root, config))
+    modified = true;
+  print("simplify");
+  if (die(root))
+    modified = true;
+  print("die");
+  if (config.opt_level > 0 && whole_kernel_cse(root))
+    modified = true;
+  return modified;
+}
+
+// Offloaded tasks do not share statements, so the local passes can run on
+// them one at a time. Before offloading, the whole root is a single unit.
+std::vector<IRNode *> get_simplify_units(IRNode *root) {
+  std::vector<IRNode *> units;
+  if (auto block = root->cast<Block>(); block && !block->statements.empty()) {
+    for (auto &stmt : block->statements) {
+      if (!stmt->is<OffloadedStmt>()) {
+        return {root};
+      }
+      units.push_back(stmt.get());
+    }
+    return units;
+  }
+  return {root};
+}
+
+uint64 get_fingerprint(IRNode *node) {
+  std::string text;
+  print(node, &text);
+  return std::hash<std::string>()(text);
+}
+
+}  // namespace
+
 void full_simplify(IRNode *root,
                    const CompileConfig &config,
                    const FullSimplifyPass::Args &args) {
@@ -526,52 +593,85 @@ void full_simplify(IRNode *root,
                                  args.kernel_name + ".simplify", root);
   TI_AUTO_PROF;
   if (config.advanced_optimization) {
-    bool first_iteration = true;
-    while (true) {
-      bool modified = false;
-      if (extract_constant(root, config))
-        modified = true;
-      print("extract_constant");
-      if (unreachable_code_elimination(root))
-        modified = true;
-      print("unreachable_code_elimination");
-      if (binary_op_simplify(root, config))
-        modified = true;
-      print("binary_op_simplify");
-      if (config.constant_folding && constant_fold(root))
-        modified = true;
-      print("constant_fold");
-      if (die(root))
-        modified = true;
-      print("die");
-      if (alg_simp(root, config))
-        modified = true;
-      print("alg_simp");
-      if (loop_invariant_code_motion(root, config))
-        modified = true;
-      print("loop_invariant_code_motion");
-      if (die(root))
-        modified = true;
-      print("die");
-      if (simplify(root, config))
-        modified = true;
-      print("simplify");
-      if (die(root))
-        modified = true;
-      print("die");
-      if (config.opt_level > 0 && whole_kernel_cse(root))
-        modified = true;
-      // Don't do this time-consuming optimization pass again if the IR is
-      // not modified.
-      if (config.opt_level > 0 && first_iteration && config.cfg_optimization &&
-          cfg_optimization(
-              root, args.after_lower_access, args.autodiff_enabled,
-              !config.real_matrix_scalarize && !config.force_scalarize_matrix))
-        modified = true;
+    const bool run_cfg_optimization =
+        config.opt_level > 0 && config.cfg_optimization;
+    auto cfg_optimize = [&]() {
+      bool modified = cfg_optimization(
+          root, args.after_lower_access, args.autodiff_enabled,
+          !config.real_matrix_scalarize && !config.force_scalarize_matrix);
       print("cfg_optimization");
-      first_iteration = false;
-      if (!modified)
-        break;
+      return modified;
+    };
+
+    if (!args.amgr) {
+      bool first_iteration = true;
+      while (true) {
+        bool modified = simplify_locally(root, config, print);
+        // Don't do this time-consuming optimization pass again if the IR is
+        // not modified.
+        if (first_iteration && run_cfg_optimization && cfg_optimize())
+          modified = true;
+        first_iteration = false;
+        if (!modified)
+          break;
+      }
+      return;
+    }
+
+    // Same fixpoint as above, but units left unchanged since the last call
+    // with these arguments are already at the fixpoint of the local passes
+    // and are skipped.
+    const PassID pass_id =
+        fmt::format("{}:{}:{}", FullSimplifyPass::id, args.after_lower_access,
+                    args.autodiff_enabled);
+    const PassID cfg_pass_id = pass_id + ":cfg";
+    auto units = get_simplify_units(root);
+    std::vector<uint64> fingerprints(units.size());
+    std::vector<bool> dirty(units.size());
+    for (std::size_t i = 0; i < units.size(); i++) {
+      fingerprints[i] = get_fingerprint(units[i]);
+      dirty[i] = !args.amgr->is_clean(pass_id, units[i], fingerprints[i]);
+    }
+    auto root_fingerprint = [&]() {
+      uint64 ret = units.size();
+      for (auto fingerprint : fingerprints) {
+        ret = ret * 1000003 ^ fingerprint;
+      }
+      return ret;
+    };
+
+    bool modified = false;
+    for (std::size_t i = 0; i < units.size(); i++) {
+      if (dirty[i]) {
+        dirty[i] = simplify_locally(units[i], config, print);
+        modified |= dirty[i];
+      }
+    }
+    // cfg_optimization is only known to be at its fixpoint if it did not
+    // modify the IR and nothing did afterwards.
+    bool cfg_clean = true;
+    if (run_cfg_optimization &&
+        (modified ||
+         !args.amgr->is_clean(cfg_pass_id, root, root_fingerprint())) &&
+        cfg_optimize()) {
+      // We do not know which units were touched, or whether some are gone
+      units = get_simplify_units(root);
+      fingerprints.resize(units.size());
+      dirty.assign(units.size(), true);
+      cfg_clean = false;
+    }
+    for (std::size_t i = 0; i < units.size(); i++) {
+      while (dirty[i] && simplify_locally(units[i], config, print)) {
+        cfg_clean = false;
+      }
+    }
+
+    for (std::size_t i = 0; i < units.size(); i++) {
+      fingerprints[i] = get_fingerprint(units[i]);
+      args.amgr->mark_clean(pass_id, units[i], fingerprints[i]);
+    }
+    if (run_cfg_optimization && cfg_clean) {
+      args.amgr->mark_clean(cfg_pass_id, root, root_fingerprint());
     }
     return;
   }
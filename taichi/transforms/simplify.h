@@ -15,6 +15,9 @@ class FullSimplifyPass : public Pass {
     bool autodiff_enabled;
     std::string kernel_name = "";
     bool verbose = false;
+    // If set, subtrees left unchanged since a previous full_simplify with the
+    // same arguments are not simplified again
+    AnalysisManager *amgr = nullptr;
   };
 };
 
@@ -0,0 +1,446 @@
+// The superword-level-parallelism (SLP) vectorizer
+
+#include "taichi/ir/ir.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/ir/type_factory.h"
+#include "taichi/ir/visitors.h"
+#include "taichi/system/profiler.h"
+
+#include <algorithm>
+#include <map>
+
+namespace taichi::lang {
+
+namespace {
+
+bool is_slp_vectorizable_op(BinaryOpType op, DataType dt, bool debug) {
+  if (!dt->is<PrimitiveType>()) {
+    return false;
+  }
+  if (dt->is_primitive(PrimitiveTypeID::f32) ||
+      dt->is_primitive(PrimitiveTypeID::f64)) {
+    return op == BinaryOpType::add || op == BinaryOpType::sub ||
+           op == BinaryOpType::mul || op == BinaryOpType::div;
+  }
+  if (dt->is_primitive(PrimitiveTypeID::i32) ||
+      dt->is_primitive(PrimitiveTypeID::i64) ||
+      dt->is_primitive(PrimitiveTypeID::u32) ||
+      dt->is_primitive(PrimitiveTypeID::u64)) {
+    // Integer arithmetic goes through overflow-checking runtime functions in
+    // debug mode.
+    if (debug && (op == BinaryOpType::add || op == BinaryOpType::sub ||
+                  op == BinaryOpType::mul)) {
+      return false;
+    }
+    return op == BinaryOpType::add || op == BinaryOpType::sub ||
+           op == BinaryOpType::mul || op == BinaryOpType::bit_and ||
+           op == BinaryOpType::bit_or || op == BinaryOpType::bit_xor;
+  }
+  return false;
+}
+
+}  // namespace
+
+// The SLPVectorize pass packs isomorphic scalar BinaryOpStmts within a basic
+// block into a single BinaryOpStmt on TensorType operands, which CodeGenLLVM
+// emits as an LLVM vector operation. This recovers the vector math that
+// scalarize() breaks up (e.g. per-component vec3 arithmetic).
+//
+// Packs are grown bottom-up: starting from a seed pack of independent
+// isomorphic statements, the lane-wise operands are packed recursively while
+// they are isomorphic too. Other operands become MatrixInitStmts (gathers),
+// and lanes used outside of the tree are extracted through a local TensorType
+// alloca. A tree is only rewritten if that is cheaper than the scalar code
+// under a simple cost model.
+class SLPVectorize : public BasicStmtVisitor {
+ private:
+  using BasicStmtVisitor::visit;
+
+  struct PackNode {
+    std::vector<Stmt *> lanes;
+    // Whether |lanes| are replaced by one vector op; otherwise |lanes| are
+    // gathered into a MatrixInitStmt.
+    bool vectorized{false};
+    int lhs{-1};
+    int rhs{-1};
+    // For vector ops, the statement right after the last operand of the
+    // lanes (|ready|); the vector op is inserted right before it, which may be
+    // earlier than the lanes as they have no side effects. For gathers, the
+    // statement before which the MatrixInitStmt was inserted.
+    Stmt *anchor{nullptr};
+    int ready{-1};
+    Stmt *vector_stmt{nullptr};
+  };
+
+  const CompileConfig &config_;
+  std::unordered_map<Stmt *, std::vector<std::pair<Stmt *, int>>> usages_;
+  DelayedIRModifier modifier_;
+
+  // Statements already replaced by vector ops.
+  std::unordered_set<Stmt *> claimed_;
+  // Lanes extracted from those vector ops, which are only inserted into the
+  // block at the end, mapped to the position of the statement they are
+  // inserted before, minus one.
+  std::unordered_map<Stmt *, int> extracted_position_;
+
+  // Per-block state.
+  Block *block_{nullptr};
+  std::unordered_map<Stmt *, int> position_;
+
+  // Per-tree state.
+  std::vector<PackNode> nodes_;
+  std::map<std::vector<Stmt *>, int> node_of_lanes_;
+  std::unordered_set<Stmt *> tree_lanes_;
+
+ public:
+  SLPVectorize(IRNode *root, const CompileConfig &config)
+      : config_(config),
+        usages_(irpass::analysis::gather_statement_usages(root)) {
+  }
+
+  void visit(Block *block) override {
+    BasicStmtVisitor::visit(block);
+    vectorize_block(block);
+  }
+
+  static bool run(IRNode *root, const CompileConfig &config) {
+    SLPVectorize pass(root, config);
+    root->accept(&pass);
+    return pass.modifier_.modify_ir();
+  }
+
+ private:
+  int max_lanes() const {
+    return std::max(config_.max_vector_width, 1);
+  }
+
+  bool is_candidate(Stmt *stmt) const {
+    auto bin = stmt->cast<BinaryOpStmt>();
+    return bin && stmt->parent == block_ && !claimed_.count(stmt) &&
+           !tree_lanes_.count(stmt) &&
+           is_slp_vectorizable_op(bin->op_type, bin->ret_type, config_.debug);
+  }
+
+  int position_in_block(Stmt *stmt) const {
+    // Users in nested blocks are ordered by their enclosing statement.
+    while (stmt && stmt->parent != block_) {
+      stmt = stmt->parent ? stmt->parent->parent_stmt() : nullptr;
+    }
+    if (!stmt) {
+      return -1;
+    }
+    auto it = position_.find(stmt);
+    return it == position_.end() ? -1 : it->second;
+  }
+
+  // Whether |later| (transitively) depends on |earlier| within the block.
+  bool depends_on(Stmt *later, Stmt *earlier) const {
+    const int lower_bound = position_.at(earlier);
+    std::vector<Stmt *> stack{later};
+    std::unordered_set<Stmt *> visited;
+    while (!stack.empty()) {
+      auto stmt = stack.back();
+      stack.pop_back();
+      for (auto op : stmt->get_operands()) {
+        if (op == earlier) {
+          return true;
+        }
+        if (!op || op->parent != block_ || visited.count(op)) {
+          continue;
+        }
+        auto it = position_.find(op);
+        if (it != position_.end() && it->second > lower_bound) {
+          visited.insert(op);
+          stack.push_back(op);
+        }
+      }
+    }
+    return false;
+  }
+
+  bool isomorphic_and_independent(const std::vector<Stmt *> &lanes) const {
+    auto first = lanes[0]->cast<BinaryOpStmt>();
+    std::unordered_set<Stmt *> distinct;
+    for (auto lane : lanes) {
+      if (!is_candidate(lane) || !distinct.insert(lane).second) {
+        return false;
+      }
+      auto bin = lane->as<BinaryOpStmt>();
+      if (bin->op_type != first->op_type || bin->ret_type != first->ret_type) {
+        return false;
+      }
+    }
+    for (int i = 0; i < (int)lanes.size(); i++) {
+      for (int j = 0; j < (int)lanes.size(); j++) {
+        if (position_.at(lanes[i]) < position_.at(lanes[j]) &&
+            depends_on(lanes[j], lanes[i])) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  int build(const std::vector<Stmt *> &lanes) {
+    auto it = node_of_lanes_.find(lanes);
+    if (it != node_of_lanes_.end()) {
+      return it->second;
+    }
+    PackNode node;
+    node.lanes = lanes;
+    if (isomorphic_and_independent(lanes)) {
+      node.vectorized = true;
+      for (auto lane : lanes) {
+        tree_lanes_.insert(lane);
+      }
+    }
+    int index = (int)nodes_.size();
+    nodes_.push_back(node);
+    node_of_lanes_[lanes] = index;
+    if (node.vectorized) {
+      std::vector<Stmt *> lhs, rhs;
+      for (auto lane : lanes) {
+        lhs.push_back(lane->as<BinaryOpStmt>()->lhs);
+        rhs.push_back(lane->as<BinaryOpStmt>()->rhs);
+      }
+      int lhs_index = build(lhs);
+      int rhs_index = build(rhs);
+      int ready = -1;
+      for (int child : {lhs_index, rhs_index}) {
+        if (nodes_[child].vectorized) {
+          ready = std::max(ready, nodes_[child].ready);
+        } else {
+          for (auto lane : nodes_[child].lanes) {
+            auto it = extracted_position_.find(lane);
+            ready = std::max(ready, it != extracted_position_.end()
+                                        ? it->second
+                                        : position_in_block(lane));
+          }
+        }
+      }
+      nodes_[index].lhs = lhs_index;
+      nodes_[index].rhs = rhs_index;
+      nodes_[index].ready = ready;
+      // The lanes come after their operands, so there is such a statement.
+      nodes_[index].anchor = block_->statements[ready + 1].get();
+    }
+    return index;
+  }
+
+  // Users of |lane| that are not lanes of vector ops in the current tree.
+  std::vector<std::pair<Stmt *, int>> external_usages(Stmt *lane) const {
+    std::vector<std::pair<Stmt *, int>> result;
+    auto it = usages_.find(lane);
+    if (it == usages_.end()) {
+      return result;
+    }
+    for (auto &usage : it->second) {
+      // Lanes of previously vectorized trees are already gone.
+      if (!tree_lanes_.count(usage.first) && !claimed_.count(usage.first)) {
+        result.push_back(usage);
+      }
+    }
+    return result;
+  }
+
+  // Returns the cost difference (scalar - vector), or a negative value if the
+  // tree cannot be vectorized.
+  int evaluate_tree() const {
+    int scalar_cost = 0, vector_cost = 0;
+    for (auto &node : nodes_) {
+      const int num_lanes = (int)node.lanes.size();
+      if (!node.vectorized) {
+        std::unordered_set<Stmt *> distinct;
+        bool all_const = true;
+        for (auto lane : node.lanes) {
+          // Gathering a value that this tree replaces would need it to be
+          // extracted first.
+          if (tree_lanes_.count(lane)) {
+            return -1;
+          }
+          if (lane->ret_type != node.lanes[0]->ret_type) {
+            return -1;
+          }
+          distinct.insert(lane);
+          all_const &= lane->is<ConstStmt>();
+        }
+        if (!all_const) {
+          // A broadcast when all lanes are the same value, one insertion per
+          // lane otherwise.
+          vector_cost += distinct.size() == 1 ? 1 : num_lanes;
+        }
+        continue;
+      }
+      scalar_cost += num_lanes;
+      vector_cost += 1;
+      const int anchor_position = position_.at(node.anchor);
+      bool has_external_usages = false;
+      for (auto lane : node.lanes) {
+        for (auto &usage : external_usages(lane)) {
+          // The extracted value is only available after the vector op.
+          if (position_in_block(usage.first) < anchor_position) {
+            return -1;
+          }
+          has_external_usages = true;
+        }
+      }
+      if (has_external_usages) {
+        vector_cost += num_lanes;
+      }
+    }
+    return scalar_cost - vector_cost;
+  }
+
+  Stmt *emit(int index) {
+    auto &node = nodes_[index];
+    if (node.vector_stmt) {
+      return node.vector_stmt;
+    }
+    auto *lhs = emit_operand(node.lhs, node.anchor);
+    auto *rhs = emit_operand(node.rhs, node.anchor);
+    auto *first = node.lanes[0]->as<BinaryOpStmt>();
+    auto tensor_type = TypeFactory::create_tensor_type(
+        {(int)node.lanes.size()}, first->ret_type);
+
+    auto vector_stmt = Stmt::make<BinaryOpStmt>(first->op_type, lhs, rhs);
+    vector_stmt->ret_type = tensor_type;
+    node.vector_stmt = vector_stmt.get();
+    modifier_.insert_before(node.anchor, std::move(vector_stmt));
+
+    // Extract the lanes that are used outside of the tree.
+    Stmt *alloca = nullptr;
+    for (int i = 0; i < (int)node.lanes.size(); i++) {
+      auto usages = external_usages(node.lanes[i]);
+      if (usages.empty()) {
+        continue;
+      }
+      VecStatement extraction;
+      if (!alloca) {
+        alloca = extraction.push_back<AllocaStmt>(tensor_type);
+        extraction.push_back<LocalStoreStmt>(alloca, node.vector_stmt);
+      }
+      auto offset =
+          extraction.push_back<ConstStmt>(TypedConstant(PrimitiveType::i32, i));
+      auto ptr = extraction.push_back<MatrixPtrStmt>(alloca, offset);
+      auto value = extraction.push_back<LocalLoadStmt>(ptr);
+      value->ret_type = first->ret_type;
+      extracted_position_[value] = position_.at(node.anchor) - 1;
+      for (auto &[user, operand_index] : usages) {
+        user->set_operand(operand_index, value);
+      }
+      modifier_.insert_before(node.anchor, std::move(extraction));
+    }
+    for (auto lane : node.lanes) {
+      claimed_.insert(lane);
+      modifier_.erase(lane);
+    }
+    return node.vector_stmt;
+  }
+
+  Stmt *emit_operand(int index, Stmt *anchor) {
+    auto &node = nodes_[index];
+    if (node.vectorized) {
+      return emit(index);
+    }
+    // A gather shared by several vector ops can only be reused if it was
+    // inserted before the current one.
+    if (node.vector_stmt &&
+        position_.at(node.anchor) <= position_.at(anchor)) {
+      return node.vector_stmt;
+    }
+    auto gather = Stmt::make<MatrixInitStmt>(node.lanes);
+    gather->ret_type = TypeFactory::create_tensor_type(
+        {(int)node.lanes.size()}, node.lanes[0]->ret_type);
+    node.vector_stmt = gather.get();
+    node.anchor = anchor;
+    modifier_.insert_before(anchor, std::move(gather));
+    return node.vector_stmt;
+  }
+
+  bool try_vectorize(const std::vector<Stmt *> &seed) {
+    nodes_.clear();
+    node_of_lanes_.clear();
+    tree_lanes_.clear();
+    int root = build(seed);
+    bool profitable = nodes_[root].vectorized && evaluate_tree() > 0;
+    if (profitable) {
+      emit(root);
+    }
+    nodes_.clear();
+    node_of_lanes_.clear();
+    tree_lanes_.clear();
+    return profitable;
+  }
+
+  void vectorize_block(Block *block) {
+    block_ = block;
+    position_.clear();
+    extracted_position_.clear();
+    for (int i = 0; i < (int)block->statements.size(); i++) {
+      position_[block->statements[i].get()] = i;
+    }
+
+    // Group the candidates by operation and type, in program order.
+    std::map<std::pair<int, std::string>, std::vector<Stmt *>> groups;
+    std::vector<std::pair<std::vector<Stmt *> *, int>> roots;
+    for (auto &stmt : block->statements) {
+      if (is_candidate(stmt.get())) {
+        auto bin = stmt->as<BinaryOpStmt>();
+        auto &group = groups[{(int)bin->op_type, bin->ret_type->to_string()}];
+        roots.emplace_back(&group, (int)group.size());
+        group.push_back(stmt.get());
+      }
+    }
+
+    // Seed bottom-up: the last statements of the block are the most likely
+    // roots of an expression tree. The lanes of a seed need not be adjacent,
+    // as the lanes of unrolled code are usually interleaved with each other.
+    for (auto it = roots.rbegin(); it != roots.rend(); it++) {
+      auto &candidates = *it->first;
+      const int end = it->second;
+      if (claimed_.count(candidates[end])) {
+        continue;
+      }
+      // Collect the latest statements of the group before candidates[end]
+      // that are independent of the ones collected so far.
+      std::vector<Stmt *> seed{candidates[end]};
+      for (int i = end - 1; i >= 0 && (int)seed.size() < max_lanes(); i--) {
+        auto stmt = candidates[i];
+        if (claimed_.count(stmt)) {
+          continue;
+        }
+        bool independent = true;
+        for (auto lane : seed) {
+          if (depends_on(lane, stmt)) {
+            independent = false;
+            break;
+          }
+        }
+        if (independent) {
+          seed.push_back(stmt);
+        }
+      }
+      std::reverse(seed.begin(), seed.end());
+      for (int width = (int)seed.size(); width >= 2; width--) {
+        std::vector<Stmt *> lanes(seed.end() - width, seed.end());
+        if (try_vectorize(lanes)) {
+          break;
+        }
+      }
+    }
+    block_ = nullptr;
+  }
+};
+
+namespace irpass {
+
+bool slp_vectorize(IRNode *root, const CompileConfig &config) {
+  TI_AUTO_PROF;
+  return SLPVectorize::run(root, config);
+}
+
+}  // namespace irpass
+
+}  // namespace taichi::lang
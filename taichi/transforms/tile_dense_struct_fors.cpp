@@ -0,0 +1,256 @@
+#include "taichi/ir/ir.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/ir/visitors.h"
+#include "taichi/transforms/utils.h"
+#include "taichi/system/profiler.h"
+
+#include <cmath>
+
+namespace taichi::lang {
+
+namespace {
+
+using TaskType = OffloadedStmt::TaskType;
+
+// Target footprint of an automatically chosen tile, in bytes of the iterated
+// cells. Small enough for a tile and its stencil halo to stay in L1/L2.
+constexpr int64 kAutoTileBytes = 32 * 1024;
+// Target length of the innermost (contiguous) axis of an automatic tile, so
+// that the innermost loop still vectorizes.
+constexpr int kAutoTileRowLength = 64;
+
+int largest_divisor_at_most(int n, int bound) {
+  for (int d = std::min(n, std::max(bound, 1)); d > 1; d--) {
+    if (n % d == 0) {
+      return d;
+    }
+  }
+  return 1;
+}
+
+/* This pass converts CPU struct-fors over dense SNodes with two or more
+ * indices into range-fors that visit the index space tile by tile, instead of
+ * the row-major order produced by demote_dense_struct_fors. For example, with
+ * 8x64 tiles,
+ *
+ *   for i, j in x:  # x = ti.field(ti.f32, shape=(512, 512))
+ *     ...
+ *
+ * becomes:
+ *
+ *   for l in range(512 * 512):
+ *     tile = l >> 9
+ *     i = (tile >> 3) * 8 + ((l & 511) >> 6)
+ *     j = (tile & 7) * 64 + (l & 63)
+ *     ...
+ *
+ * Consecutive iterations then stay within a cache-sized block of the field,
+ * which improves the reuse of neighbouring cells in stencils. The tile volume
+ * is recorded in OffloadedStmt::tile_volume so that the CPU thread pool, and
+ * make_cpu_multithreaded_range_for, only split the loop on tile boundaries.
+ *
+ * The tile edge along each axis is a divisor of the extent of that axis, so no
+ * tile is partial. With config.cpu_loop_tile_size == 0 the tile is chosen
+ * from the SNode layout: layouts that are already blocked (more than one
+ * dense level with several cells, or a Morton dense level) and fields that fit
+ * in a single tile are left alone. Serialized loops keep their order.
+ */
+class TileDenseStructFors : public BasicStmtVisitor {
+ public:
+  using BasicStmtVisitor::visit;
+
+  explicit TileDenseStructFors(const CompileConfig &config) : config(config) {
+  }
+
+  void visit(Block *block) override {
+    for (auto &s_ : block->statements) {
+      s_->accept(this);
+    }
+  }
+
+  void visit(OffloadedStmt *offloaded) override {
+    if (offloaded->task_type != TaskType::struct_for ||
+        !offloaded->snode->is_path_all_dense ||
+        offloaded->is_bit_vectorized || offloaded->num_cpu_threads == 1) {
+      return;
+    }
+
+    std::vector<SNode *> snodes;
+    int num_blocked_levels = 0;
+    bool has_morton_level = false;
+    int64 total_n = 1;
+    std::array<int, taichi_max_num_indices> total_shape;
+    total_shape.fill(1);
+    for (auto *snode = offloaded->snode; snode->type != SNodeType::root;
+         snode = snode->parent) {
+      snodes.push_back(snode);
+      for (int j = 0; j < taichi_max_num_indices; j++) {
+        total_shape[j] *= snode->extractors[j].shape;
+      }
+      total_n *= snode->num_cells_per_container;
+      if (snode->num_cells_per_container > 1) {
+        num_blocked_levels++;
+      }
+      has_morton_level |= snode->morton_bits > 0;
+    }
+    if (snodes.empty() || total_n > std::numeric_limits<int>::max()) {
+      return;
+    }
+    auto *leaf = snodes.front();
+    const int num_loop_vars = leaf->num_active_indices;
+    if (num_loop_vars < 2) {
+      return;
+    }
+
+    std::vector<int> physical_indices;
+    std::vector<int> shape, tile;
+    for (int i = 0; i < num_loop_vars; i++) {
+      physical_indices.push_back(leaf->physical_index_position[i]);
+      shape.push_back(total_shape[physical_indices.back()]);
+    }
+
+    if (config.cpu_loop_tile_size > 0) {
+      for (int i = 0; i < num_loop_vars; i++) {
+        tile.push_back(
+            largest_divisor_at_most(shape[i], config.cpu_loop_tile_size));
+      }
+    } else {
+      const int64 cell_bytes = std::max<int64>(leaf->cell_size_bytes, 1);
+      const int64 budget = std::max<int64>(kAutoTileBytes / cell_bytes, 1);
+      if (num_blocked_levels > 1 || has_morton_level || total_n <= budget) {
+        return;
+      }
+      tile.resize(num_loop_vars);
+      tile.back() = largest_divisor_at_most(shape.back(), kAutoTileRowLength);
+      const double edge = std::pow(double(budget / tile.back()),
+                                   1.0 / double(num_loop_vars - 1));
+      for (int i = 0; i + 1 < num_loop_vars; i++) {
+        tile[i] = largest_divisor_at_most(shape[i], int(edge));
+      }
+    }
+
+    int64 num_cells = 1;
+    int tile_volume = 1;
+    for (int i = 0; i < num_loop_vars; i++) {
+      num_cells *= shape[i];
+      tile_volume *= tile[i];
+    }
+    if (num_cells != total_n) {
+      return;
+    }
+    if (tile_volume == 1 || tile_volume == total_n) {
+      return;
+    }
+    tile_loop(offloaded, physical_indices, shape, tile, tile_volume, total_n);
+    modified = true;
+  }
+
+  static bool run(IRNode *root, const CompileConfig &config) {
+    TileDenseStructFors pass(config);
+    root->accept(&pass);
+    return pass.modified;
+  }
+
+ private:
+  static void tile_loop(OffloadedStmt *offloaded,
+                        const std::vector<int> &physical_indices,
+                        const std::vector<int> &shape,
+                        const std::vector<int> &tile,
+                        int tile_volume,
+                        int64 total_n) {
+    offloaded->const_begin = true;
+    offloaded->const_end = true;
+    offloaded->begin_value = 0;
+    offloaded->end_value = total_n;
+
+    auto body = std::move(offloaded->body);
+    const int num_loop_vars = (int)physical_indices.size();
+
+    VecStatement body_header;
+    auto main_loop_var = body_header.push_back<LoopIndexStmt>(nullptr, 0);
+    // We will set main_loop_var->loop later.
+
+    auto tile_index = generate_div(&body_header, main_loop_var, tile_volume);
+    auto index_in_tile =
+        generate_mod(&body_header, main_loop_var, tile_volume);
+
+    // Both the tiles and the cells within a tile are visited in row-major
+    // order, i.e. the last index is the fastest varying one.
+    std::vector<Stmt *> new_loop_vars(num_loop_vars);
+    int64 tile_stride = 1, cell_stride = 1;
+    for (int i = num_loop_vars - 1; i >= 0; i--) {
+      const int num_tiles = shape[i] / tile[i];
+      Stmt *tile_coord = tile_index;
+      Stmt *cell_coord = index_in_tile;
+      if (tile_stride > 1) {
+        tile_coord = generate_div(&body_header, tile_coord, tile_stride);
+      }
+      if (cell_stride > 1) {
+        cell_coord = generate_div(&body_header, cell_coord, cell_stride);
+      }
+      if (i != 0) {  // the outermost coordinates don't need a mod
+        tile_coord = generate_mod(&body_header, tile_coord, num_tiles);
+        cell_coord = generate_mod(&body_header, cell_coord, tile[i]);
+      }
+      auto tile_edge =
+          body_header.push_back<ConstStmt>(TypedConstant(tile[i]));
+      auto corner = body_header.push_back<BinaryOpStmt>(BinaryOpType::mul,
+                                                        tile_coord, tile_edge);
+      new_loop_vars[i] = body_header.push_back<BinaryOpStmt>(
+          BinaryOpType::add, corner, cell_coord);
+      tile_stride *= num_tiles;
+      cell_stride *= tile[i];
+    }
+
+    irpass::replace_statements(
+        body.get(), /*filter=*/
+        [&](Stmt *s) {
+          if (auto loop_index = s->cast<LoopIndexStmt>()) {
+            return loop_index->loop == offloaded;
+          } else {
+            return false;
+          }
+        },
+        /*finder=*/
+        [&](Stmt *s) {
+          auto index =
+              std::find(physical_indices.begin(), physical_indices.end(),
+                        s->as<LoopIndexStmt>()->index);
+          TI_ASSERT(index != physical_indices.end());
+          return new_loop_vars[index - physical_indices.begin()];
+        });
+
+    body->insert(std::move(body_header), 0);
+
+    offloaded->body = std::move(body);
+    offloaded->body->set_parent_stmt(offloaded);
+    main_loop_var->loop = offloaded;
+
+    offloaded->task_type = TaskType::range_for;
+    offloaded->tile_volume = tile_volume;
+    // The thread pool hands out whole tiles.
+    offloaded->block_dim =
+        (offloaded->block_dim + tile_volume - 1) / tile_volume * tile_volume;
+  }
+
+  const CompileConfig &config;
+  bool modified{false};
+};
+
+}  // namespace
+
+namespace irpass {
+
+bool tile_dense_struct_fors(IRNode *root, const CompileConfig &config) {
+  TI_AUTO_PROF;
+  bool modified = TileDenseStructFors::run(root, config);
+  if (modified) {
+    re_id(root);
+  }
+  return modified;
+}
+
+}  // namespace irpass
+
+}  // namespace taichi::lang
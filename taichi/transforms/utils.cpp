@@ -1,3 +1,4 @@
+#include "taichi/ir/snode.h"
 #include "taichi/ir/statements.h"
 
 namespace taichi::lang {
@@ -21,4 +22,47 @@ Stmt *generate_div(VecStatement *stmts, Stmt *x, int y) {
   return stmts->push_back<BinaryOpStmt>(BinaryOpType::div, x, const_stmt);
 }
 
+namespace {
+
+Stmt *generate_shift_or_and(VecStatement *stmts,
+                            Stmt *x,
+                            BinaryOpType shift_op,
+                            int shift,
+                            int mask) {
+  auto shift_stmt = stmts->push_back<ConstStmt>(TypedConstant(shift));
+  auto shifted = stmts->push_back<BinaryOpStmt>(shift_op, x, shift_stmt);
+  auto ored = stmts->push_back<BinaryOpStmt>(BinaryOpType::bit_or, x, shifted);
+  auto mask_stmt = stmts->push_back<ConstStmt>(TypedConstant(mask));
+  return stmts->push_back<BinaryOpStmt>(BinaryOpType::bit_and, ored, mask_stmt);
+}
+
+}  // namespace
+
+Stmt *generate_morton_spread(VecStatement *stmts,
+                             Stmt *x,
+                             int num_bits,
+                             int stride) {
+  for (auto [shift, mask] : SNode::morton_dilation_steps(num_bits, stride)) {
+    x = generate_shift_or_and(stmts, x, BinaryOpType::bit_shl, shift, mask);
+  }
+  return x;
+}
+
+Stmt *generate_morton_gather(VecStatement *stmts,
+                             Stmt *x,
+                             int num_bits,
+                             int stride) {
+  const auto steps = SNode::morton_dilation_steps(num_bits, stride);
+  const int low_bits = (1 << num_bits) - 1;
+  auto mask_stmt = stmts->push_back<ConstStmt>(
+      TypedConstant(steps.empty() ? low_bits : steps.back().second));
+  x = stmts->push_back<BinaryOpStmt>(BinaryOpType::bit_and, x, mask_stmt);
+  for (int i = (int)steps.size() - 1; i >= 0; i--) {
+    const int mask = i > 0 ? steps[i - 1].second : low_bits;
+    x = generate_shift_or_and(stmts, x, BinaryOpType::bit_shr, steps[i].first,
+                              mask);
+  }
+  return x;
+}
+
 }  // namespace taichi::lang
@@ -8,4 +8,15 @@ namespace taichi::lang {
 Stmt *generate_mod(VecStatement *stmts, Stmt *x, int y);
 Stmt *generate_div(VecStatement *stmts, Stmt *x, int y);
 
+// Moves bit t of the |num_bits|-bit x to bit t * |stride|, and back. Used for
+// the Z-order index math of Morton dense SNodes.
+Stmt *generate_morton_spread(VecStatement *stmts,
+                             Stmt *x,
+                             int num_bits,
+                             int stride);
+Stmt *generate_morton_gather(VecStatement *stmts,
+                             Stmt *x,
+                             int num_bits,
+                             int stride);
+
 }  // namespace taichi::lang
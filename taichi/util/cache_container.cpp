@@ -0,0 +1,303 @@
+#include "taichi/util/cache_container.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(TI_PLATFORM_WINDOWS)
+#include "taichi/platform/windows/windows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace taichi {
+
+namespace {
+
+constexpr std::size_t kMagicSize = 4;
+constexpr std::size_t kHeaderSize = kMagicSize + sizeof(std::uint32_t);
+constexpr std::size_t kFooterMagicSize = 8;
+constexpr std::size_t kFooterSize = sizeof(std::uint64_t) + kFooterMagicSize;
+
+template <typename T>
+bool read_pod(const char *data, std::size_t size, std::size_t &pos, T &out) {
+  if (size - pos < sizeof(T)) {
+    return false;
+  }
+  std::memcpy(&out, data + pos, sizeof(T));
+  pos += sizeof(T);
+  return true;
+}
+
+template <typename T>
+void write_pod(std::ostream &os, const T &value) {
+  os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void write_header(std::ostream &os, std::uint64_t &pos) {
+  os.write(CacheContainer::kMagic, kMagicSize);
+  write_pod(os, CacheContainer::kFormatVersion);
+  pos = kHeaderSize;
+}
+
+// Writes |blob| at the next aligned position after |pos|.
+CacheContainer::Entry write_blob(std::ostream &os,
+                                 std::uint64_t &pos,
+                                 std::string_view blob) {
+  const char padding[CacheContainer::kAlignment] = {};
+  const auto pad = (CacheContainer::kAlignment -
+                    pos % CacheContainer::kAlignment) %
+                   CacheContainer::kAlignment;
+  os.write(padding, pad);
+  pos += pad;
+  CacheContainer::Entry entry{pos, blob.size()};
+  os.write(blob.data(), blob.size());
+  pos += blob.size();
+  return entry;
+}
+
+void write_index(
+    std::ostream &os,
+    std::uint64_t pos,
+    const std::unordered_map<std::string, CacheContainer::Entry> &index) {
+  const std::uint64_t index_offset = pos;
+  write_pod(os, (std::uint64_t)index.size());
+  for (const auto &[key, entry] : index) {
+    write_pod(os, (std::uint64_t)key.size());
+    os.write(key.data(), key.size());
+    write_pod(os, entry.offset);
+    write_pod(os, entry.size);
+  }
+  write_pod(os, index_offset);
+  os.write(CacheContainer::kFooterMagic, kFooterMagicSize);
+}
+
+}  // namespace
+
+MappedFile::~MappedFile() {
+#if defined(TI_PLATFORM_WINDOWS)
+  if (data_) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_handle_) {
+    CloseHandle(mapping_handle_);
+  }
+  if (file_handle_) {
+    CloseHandle(file_handle_);
+  }
+#else
+  if (data_) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+#endif
+}
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::string &path) {
+  std::unique_ptr<MappedFile> file(new MappedFile());
+#if defined(TI_PLATFORM_WINDOWS)
+  // FILE_SHARE_DELETE lets writers replace the file while it is mapped.
+  HANDLE handle = CreateFileA(
+      path.c_str(), GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return nullptr;
+  }
+  file->file_handle_ = handle;
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+    return nullptr;
+  }
+  file->size_ = size.QuadPart;
+  file->mapping_handle_ =
+      CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!file->mapping_handle_) {
+    return nullptr;
+  }
+  file->data_ = static_cast<const char *>(
+      MapViewOfFile(file->mapping_handle_, FILE_MAP_READ, 0, 0, 0));
+  if (!file->data_) {
+    return nullptr;
+  }
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    return nullptr;
+  }
+  void *ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+  if (ptr == MAP_FAILED) {
+    return nullptr;
+  }
+  file->data_ = static_cast<const char *>(ptr);
+  file->size_ = st.st_size;
+#endif
+  return file;
+}
+
+std::unique_ptr<CacheContainer> CacheContainer::open(const std::string &path) {
+  auto file = MappedFile::open(path);
+  if (!file) {
+    return nullptr;
+  }
+  std::unique_ptr<CacheContainer> container(new CacheContainer());
+  container->file_ = std::move(file);
+  if (!container->load_index()) {
+    return nullptr;
+  }
+  return container;
+}
+
+bool CacheContainer::load_index() {
+  const char *data = file_->data();
+  const std::size_t size = file_->size();
+  if (size < kHeaderSize + kFooterSize ||
+      std::memcmp(data, kMagic, kMagicSize) != 0 ||
+      std::memcmp(data + size - kFooterMagicSize, kFooterMagic,
+                  kFooterMagicSize) != 0) {
+    return false;
+  }
+  std::uint32_t version;
+  std::memcpy(&version, data + kMagicSize, sizeof(version));
+  if (version != kFormatVersion) {
+    return false;
+  }
+
+  std::uint64_t index_offset;
+  std::memcpy(&index_offset, data + size - kFooterSize, sizeof(index_offset));
+  const std::size_t index_end = size - kFooterSize;
+  if (index_offset < kHeaderSize || index_offset > index_end) {
+    return false;
+  }
+  std::size_t pos = index_offset;
+  std::uint64_t num_entries;
+  if (!read_pod(data, index_end, pos, num_entries)) {
+    return false;
+  }
+  index_.reserve(num_entries);
+  for (std::uint64_t i = 0; i < num_entries; i++) {
+    std::uint64_t key_size;
+    if (!read_pod(data, index_end, pos, key_size) ||
+        index_end - pos < key_size) {
+      return false;
+    }
+    std::string key(data + pos, key_size);
+    pos += key_size;
+    Entry entry;
+    if (!read_pod(data, index_end, pos, entry.offset) ||
+        !read_pod(data, index_end, pos, entry.size)) {
+      return false;
+    }
+    // Blobs always precede the index that refers to them.
+    if (entry.offset < kHeaderSize || entry.offset > index_offset ||
+        index_offset - entry.offset < entry.size) {
+      return false;
+    }
+    index_[std::move(key)] = entry;
+  }
+  return pos == index_end;
+}
+
+std::optional<std::string_view> CacheContainer::find(
+    const std::string &key) const {
+  auto iter = index_.find(key);
+  if (iter == index_.end()) {
+    return std::nullopt;
+  }
+  return std::string_view(file_->data() + iter->second.offset,
+                          iter->second.size);
+}
+
+bool CacheContainer::append(
+    const std::string &path,
+    const std::vector<std::pair<std::string, std::string>> &blobs) {
+  std::unordered_map<std::string, Entry> index;
+  std::uint64_t end = 0;
+  if (auto existing = open(path)) {
+    index = existing->index_;
+    end = existing->file_->size();
+  } else if (std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+             ifs.is_open()) {
+    // An unreadable tail (e.g. an interrupted append) loses the old entries,
+    // but the file is still only appended to.
+    end = ifs.tellg();
+    char magic[kMagicSize];
+    ifs.seekg(0);
+    if (end > 0 && (end < kHeaderSize || !ifs.read(magic, kMagicSize) ||
+                    std::memcmp(magic, kMagic, kMagicSize) != 0)) {
+      return false;
+    }
+  }
+
+  std::ofstream os(path, std::ios::binary | std::ios::app);
+  if (!os.is_open()) {
+    return false;
+  }
+  std::uint64_t pos = end;
+  if (pos == 0) {
+    write_header(os, pos);
+  }
+  for (const auto &[key, blob] : blobs) {
+    index[key] = write_blob(os, pos, blob);
+  }
+  write_index(os, pos, index);
+  os.flush();
+  return bool(os);
+}
+
+bool CacheContainer::compact(
+    const std::string &path,
+    const std::unordered_set<std::string> &keys,
+    const std::vector<std::pair<std::string, std::string>> &blobs) {
+  auto existing = open(path);
+  const auto tmp_path = path + ".tmp";
+  {
+    std::ofstream os(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!os.is_open()) {
+      return false;
+    }
+    std::unordered_map<std::string, Entry> index;
+    std::uint64_t pos = 0;
+    write_header(os, pos);
+    std::unordered_set<std::string> new_keys;
+    for (const auto &[key, _] : blobs) {
+      new_keys.insert(key);
+    }
+    if (existing) {
+      for (const auto &[key, _] : existing->index_) {
+        if (keys.count(key) && !new_keys.count(key)) {
+          index[key] = write_blob(os, pos, *existing->find(key));
+        }
+      }
+    }
+    for (const auto &[key, blob] : blobs) {
+      index[key] = write_blob(os, pos, blob);
+    }
+    write_index(os, pos, index);
+    os.flush();
+    if (!os) {
+      os.close();
+      std::error_code ec;
+      std::filesystem::remove(tmp_path, ec);
+      return false;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp_path, ec);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace taichi
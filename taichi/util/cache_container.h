@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "taichi/common/platform_macros.h"
+
+namespace taichi {
+
+// A read-only memory mapping of a whole file.
+class MappedFile {
+ public:
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile();
+
+  // Returns nullptr if |path| cannot be opened or mapped.
+  static std::unique_ptr<MappedFile> open(const std::string &path);
+
+  const char *data() const {
+    return data_;
+  }
+
+  std::size_t size() const {
+    return size_;
+  }
+
+ private:
+  MappedFile() = default;
+
+  const char *data_{nullptr};
+  std::size_t size_{0};
+#if defined(TI_PLATFORM_WINDOWS)
+  void *file_handle_{nullptr};
+  void *mapping_handle_{nullptr};
+#endif
+};
+
+// A single-file, append-only container of keyed blobs (e.g. serialized
+// CompiledKernelData), read through a memory mapping.
+//
+// Layout:
+//   header:  magic "TICC", u32 format version
+//   records: blobs, each aligned to kAlignment
+//   index:   u64 number of entries, then for each entry
+//            u64 key size, key, u64 offset, u64 size
+//   footer:  u64 index offset, magic "TICCIDX"
+//
+// Appending writes the new blobs, then a complete index and footer after the
+// current end of the file. Existing bytes are never modified, so readers that
+// mapped an older version stay valid; the stale index is simply skipped.
+// Compacting writes the live blobs to a new file and renames it over the old
+// one, which readers that mapped the old file keep seeing.
+// Writers must be serialized by the caller (e.g. with the cache lock file).
+class CacheContainer {
+ public:
+  static constexpr char kMagic[] = "TICC";
+  static constexpr char kFooterMagic[] = "TICCIDX";
+  static constexpr std::uint32_t kFormatVersion = 1;
+  static constexpr std::size_t kAlignment = 16;
+
+  struct Entry {
+    std::uint64_t offset{0};
+    std::uint64_t size{0};
+  };
+
+  // Returns nullptr if |path| does not exist or is not a valid container.
+  static std::unique_ptr<CacheContainer> open(const std::string &path);
+
+  // Appends |blobs| (key, data) to the container at |path|, creating it if
+  // needed. A key that already exists is shadowed by the new blob. Returns
+  // false on IO errors.
+  static bool append(
+      const std::string &path,
+      const std::vector<std::pair<std::string, std::string>> &blobs);
+
+  // Rewrites the container at |path| with only the blobs of |keys|, followed
+  // by |blobs|. Stale indices, shadowed blobs and the blobs of other keys are
+  // dropped. Returns false on IO errors, leaving the old container in place.
+  static bool compact(
+      const std::string &path,
+      const std::unordered_set<std::string> &keys,
+      const std::vector<std::pair<std::string, std::string>> &blobs = {});
+
+  // The returned view points into the mapping and lives as long as |this|.
+  std::optional<std::string_view> find(const std::string &key) const;
+
+  bool contains(const std::string &key) const {
+    return index_.count(key) != 0;
+  }
+
+  const std::unordered_map<std::string, Entry> &index() const {
+    return index_;
+  }
+
+  // Including the stale bytes.
+  std::size_t file_size() const {
+    return file_->size();
+  }
+
+ private:
+  CacheContainer() = default;
+
+  bool load_index();
+
+  std::unique_ptr<MappedFile> file_;
+  std::unordered_map<std::string, Entry> index_;
+};
+
+}  // namespace taichi
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace taichi {
+
+// A 128-bit digest, e.g. of a kernel AST.
+struct Hash128 {
+  std::uint64_t lo{0};
+  std::uint64_t hi{0};
+
+  bool operator==(const Hash128 &other) const {
+    return lo == other.lo && hi == other.hi;
+  }
+
+  bool operator!=(const Hash128 &other) const {
+    return !(*this == other);
+  }
+
+  // 32 lowercase hex digits.
+  std::string to_hex() const {
+    static constexpr char kDigits[] = "0123456789abcdef";
+    std::string hex(32, '0');
+    for (int i = 0; i < 16; i++) {
+      hex[15 - i] = kDigits[(hi >> (4 * i)) & 15];
+      hex[31 - i] = kDigits[(lo >> (4 * i)) & 15];
+    }
+    return hex;
+  }
+};
+
+// Incremental, non-cryptographic 128-bit hashing. The digest is
+// MurmurHash3_x64_128 (seed 0) of the concatenation of all updates, so it is
+// stable across runs and platforms and can be used in on-disk cache keys.
+class Hash128Builder {
+ public:
+  void update(const void *data, std::size_t size) {
+    auto bytes = static_cast<const std::uint8_t *>(data);
+    total_size_ += size;
+    if (tail_size_ > 0) {
+      const auto n = std::min(size, kBlockSize - tail_size_);
+      std::memcpy(tail_ + tail_size_, bytes, n);
+      tail_size_ += n;
+      bytes += n;
+      size -= n;
+      if (tail_size_ < kBlockSize) {
+        return;
+      }
+      mix_block(tail_);
+      tail_size_ = 0;
+    }
+    for (; size >= kBlockSize; bytes += kBlockSize, size -= kBlockSize) {
+      mix_block(bytes);
+    }
+    std::memcpy(tail_, bytes, size);
+    tail_size_ = size;
+  }
+
+  template <typename T>
+  void update_pod(const T &val) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    update(&val, sizeof(T));
+  }
+
+  void update(const Hash128 &hash) {
+    update_pod(hash.lo);
+    update_pod(hash.hi);
+  }
+
+  Hash128 finish() const {
+    std::uint64_t h1 = h1_, h2 = h2_;
+    if (tail_size_ > 0) {
+      std::uint8_t block[kBlockSize] = {};
+      std::memcpy(block, tail_, tail_size_);
+      std::uint64_t k1, k2;
+      std::memcpy(&k1, block, 8);
+      std::memcpy(&k2, block + 8, 8);
+      if (tail_size_ > 8) {
+        h2 ^= rotl(k2 * kC2, 33) * kC1;
+      }
+      h1 ^= rotl(k1 * kC1, 31) * kC2;
+    }
+    h1 ^= total_size_;
+    h2 ^= total_size_;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix(h1);
+    h2 = fmix(h2);
+    h1 += h2;
+    h2 += h1;
+    return Hash128{h1, h2};
+  }
+
+ private:
+  static constexpr std::size_t kBlockSize = 16;
+  static constexpr std::uint64_t kC1 = 0x87c37b91114253d5ULL;
+  static constexpr std::uint64_t kC2 = 0x4cf5ad432745937fULL;
+
+  static std::uint64_t rotl(std::uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+  }
+
+  static std::uint64_t fmix(std::uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+  }
+
+  void mix_block(const std::uint8_t *block) {
+    std::uint64_t k1, k2;
+    std::memcpy(&k1, block, 8);
+    std::memcpy(&k2, block + 8, 8);
+    h1_ ^= rotl(k1 * kC1, 31) * kC2;
+    h1_ = rotl(h1_, 27) + h2_;
+    h1_ = h1_ * 5 + 0x52dce729;
+    h2_ ^= rotl(k2 * kC2, 33) * kC1;
+    h2_ = rotl(h2_, 31) + h1_;
+    h2_ = h2_ * 5 + 0x38495ab5;
+  }
+
+  std::uint64_t h1_{0};
+  std::uint64_t h2_{0};
+  std::uint64_t total_size_{0};
+  std::uint8_t tail_[kBlockSize];
+  std::size_t tail_size_{0};
+};
+
+}  // namespace taichi
@@ -2,7 +2,7 @@
 
 namespace taichi::lang::offline_cache {
 
-constexpr std::size_t offline_cache_key_length = 65;
+constexpr std::size_t offline_cache_key_length = 33;
 constexpr std::size_t min_mangled_name_length = offline_cache_key_length + 2;
 
 void disable_offline_cache_if_needed(CompileConfig *config) {
@@ -34,7 +34,7 @@ std::string get_cache_path_by_arch(const std::string &base_path, Arch arch) {
 
 std::string mangle_name(const std::string &primal_name,
                         const std::string &key) {
-  // Result: {primal_name}{key: char[65]}_{(checksum(primal_name)) ^
+  // Result: {primal_name}{key: char[33]}_{(checksum(primal_name)) ^
   // checksum(key)}
   if (key.size() != offline_cache_key_length) {
     return primal_name;
@@ -93,7 +93,8 @@ std::size_t clean_offline_cache_files(const std::string &path) {
     const auto ext = taichi::filename_extension(name);
     return ext == kLlvmCacheFilenameBCExt || ext == kLlvmCacheFilenameLLExt ||
            ext == kSpirvCacheFilenameExt || ext == kMetalCacheFilenameExt ||
-           ext == kTiCacheFilenameExt || ext == "lock" || ext == "tcb";
+           ext == kTiCacheFilenameExt || ext == kTiCacheContainerFilenameExt ||
+           ext == kTiCacheJournalFilenameExt || ext == "lock" || ext == "tcb";
   };
 
   std::size_t count = 0;
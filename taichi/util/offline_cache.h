@@ -23,6 +23,8 @@ constexpr char kLlvmCacheFilenameBCExt[] = "bc";
 constexpr char kSpirvCacheFilenameExt[] = "spv";
 constexpr char kMetalCacheFilenameExt[] = "metal";
 constexpr char kTiCacheFilenameExt[] = "tic";
+constexpr char kTiCacheContainerFilenameExt[] = "ticc";
+constexpr char kTiCacheJournalFilenameExt[] = "tcj";
 constexpr char kLlvmCachSubPath[] = "llvm";
 constexpr char kSpirvCacheSubPath[] = "gfx";
 constexpr char kMetalCacheSubPath[] = "metal";
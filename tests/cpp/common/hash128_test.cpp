@@ -0,0 +1,34 @@
+#include "gtest/gtest.h"
+
+#include "taichi/util/hash128.h"
+
+namespace taichi {
+
+TEST(Hash128, MurmurHash3) {
+  const std::string str = "The quick brown fox jumps over the lazy dog";
+  Hash128Builder hasher;
+  hasher.update(str.data(), str.size());
+  EXPECT_EQ(hasher.finish().to_hex(), "7a433ca9c49a9347e34bbc7bbc071b6c");
+  EXPECT_EQ(Hash128Builder().finish(), Hash128());
+}
+
+TEST(Hash128, Incremental) {
+  std::string str;
+  for (int i = 0; i < 100; i++) {
+    str += std::to_string(i);
+  }
+  Hash128Builder whole;
+  whole.update(str.data(), str.size());
+  // Updates of any size that do not line up with the 16-byte blocks.
+  Hash128Builder pieces;
+  for (std::size_t i = 0, n = 1; i < str.size(); i += n, n = n % 7 + 1) {
+    pieces.update(str.data() + i, std::min(n, str.size() - i));
+  }
+  EXPECT_EQ(whole.finish(), pieces.finish());
+
+  Hash128Builder other;
+  other.update(str.data(), str.size() - 1);
+  EXPECT_NE(whole.finish(), other.finish());
+}
+
+}  // namespace taichi
@@ -0,0 +1,62 @@
+#include "gtest/gtest.h"
+
+#include <thread>
+
+#include "taichi/ir/statements.h"
+#include "taichi/ir/stmt_arena.h"
+
+namespace taichi::lang {
+
+TEST(StmtArena, ReuseFreedStatements) {
+  if (!StmtArena::kEnabled) {
+    GTEST_SKIP();
+  }
+  auto stmt = std::make_unique<ConstStmt>(TypedConstant(1));
+  auto *addr = stmt.get();
+  stmt.reset();
+  auto other = std::make_unique<ConstStmt>(TypedConstant(2));
+  EXPECT_EQ(other.get(), addr);
+}
+
+TEST(StmtArena, FreeOnAnotherThread) {
+  if (!StmtArena::kEnabled) {
+    GTEST_SKIP();
+  }
+  // Few enough for their slabs to be kept in the pool.
+  constexpr int kNumStmts = 1000;
+  std::vector<pStmt> stmts;
+  for (int i = 0; i < kNumStmts; i++) {
+    stmts.push_back(std::make_unique<ConstStmt>(TypedConstant(i)));
+  }
+  const auto num_slabs = StmtArena::get_stats().num_slabs;
+  // The worker's cache is handed back to the shared pool when it exits.
+  std::thread([&] { stmts.clear(); }).join();
+  for (int i = 0; i < kNumStmts; i++) {
+    stmts.push_back(std::make_unique<ConstStmt>(TypedConstant(i)));
+  }
+  EXPECT_EQ(StmtArena::get_stats().num_slabs, num_slabs);
+}
+
+TEST(StmtArena, ReturnFreeSlabs) {
+  if (!StmtArena::kEnabled) {
+    GTEST_SKIP();
+  }
+  constexpr std::size_t kNumSlabs = 64;
+  const auto num_stmts = kNumSlabs * StmtArena::kSlabSize / sizeof(ConstStmt);
+  std::vector<pStmt> stmts;
+  for (std::size_t i = 0; i < num_stmts; i++) {
+    stmts.push_back(std::make_unique<ConstStmt>(TypedConstant((int32)i)));
+  }
+  const auto num_slabs = StmtArena::get_stats().num_slabs;
+  stmts.clear();
+  // The pool keeps a few free slabs around until it can return a batch.
+  EXPECT_LE(StmtArena::get_stats().num_slabs + kNumSlabs / 2, num_slabs);
+}
+
+TEST(StmtArena, LargeAllocations) {
+  auto *ptr = StmtArena::allocate(StmtArena::kMaxSize + 1);
+  ASSERT_NE(ptr, nullptr);
+  StmtArena::deallocate(ptr, StmtArena::kMaxSize + 1);
+}
+
+}  // namespace taichi::lang
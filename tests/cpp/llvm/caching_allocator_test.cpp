@@ -0,0 +1,58 @@
+#include "gtest/gtest.h"
+
+#include "taichi/rhi/llvm/allocator.h"
+
+namespace taichi::lang {
+
+namespace {
+
+constexpr std::size_t kPage = taichi_page_size;
+
+uint64_t *at(std::vector<uint8_t> &buffer, std::size_t offset) {
+  return reinterpret_cast<uint64_t *>(buffer.data() + offset);
+}
+
+}  // namespace
+
+TEST(CachingAllocator, BestFit) {
+  std::vector<uint8_t> buffer(64 * kPage);
+  CachingAllocator allocator(/*merge_upon_release=*/false);
+
+  // Free blocks of 8, 3 and 5 pages, not adjacent
+  allocator.release(8 * kPage, at(buffer, 0));
+  allocator.release(3 * kPage, at(buffer, 16 * kPage));
+  allocator.release(5 * kPage, at(buffer, 32 * kPage));
+
+  EXPECT_EQ(allocator.allocate_from_cache(2 * kPage), at(buffer, 16 * kPage));
+  EXPECT_EQ(allocator.allocate_from_cache(4 * kPage), at(buffer, 32 * kPage));
+  // The remainders (1 page of each) are still cached
+  EXPECT_EQ(allocator.allocate_from_cache(kPage), at(buffer, 18 * kPage));
+  EXPECT_EQ(allocator.allocate_from_cache(kPage), at(buffer, 36 * kPage));
+  EXPECT_EQ(allocator.allocate_from_cache(8 * kPage), at(buffer, 0));
+  EXPECT_EQ(allocator.allocate_from_cache(kPage), nullptr);
+}
+
+TEST(CachingAllocator, Coalescing) {
+  std::vector<uint8_t> buffer(64 * kPage);
+  CachingAllocator allocator(/*merge_upon_release=*/true);
+
+  allocator.release(2 * kPage, at(buffer, 0));
+  allocator.release(2 * kPage, at(buffer, 4 * kPage));
+  EXPECT_EQ(allocator.get_stats().num_free_blocks, 2);
+  EXPECT_DOUBLE_EQ(allocator.get_stats().fragmentation, 0.5);
+
+  // Filling the gap merges all three blocks
+  allocator.release(2 * kPage, at(buffer, 2 * kPage));
+  auto stats = allocator.get_stats();
+  EXPECT_EQ(stats.num_free_blocks, 1);
+  EXPECT_EQ(stats.bytes_cached, 6 * kPage);
+  EXPECT_EQ(stats.largest_free_block, 6 * kPage);
+  EXPECT_DOUBLE_EQ(stats.fragmentation, 0.0);
+
+  EXPECT_EQ(allocator.allocate_from_cache(6 * kPage), at(buffer, 0));
+  stats = allocator.get_stats();
+  EXPECT_EQ(stats.num_free_blocks, 0);
+  EXPECT_EQ(stats.bytes_cached, 0);
+}
+
+}  // namespace taichi::lang
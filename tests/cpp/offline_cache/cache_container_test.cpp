@@ -0,0 +1,42 @@
+#include <cstdio>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "taichi/util/cache_container.h"
+
+namespace taichi {
+namespace {
+
+TEST(CacheContainer, CompactDropsStaleBlobs) {
+  const std::string path = std::string(std::tmpnam(nullptr)) + ".ticc";
+  const std::string blob(1000, 'x');
+  ASSERT_TRUE(CacheContainer::append(path, {{"a", blob}, {"b", blob}}));
+  // Shadow "a" and add "c", which leaves a stale blob and a stale index.
+  ASSERT_TRUE(CacheContainer::append(
+      path, {{"a", std::string(1000, 'y')}, {"c", blob}}));
+  std::size_t appended_size = 0;
+  {
+    auto container = CacheContainer::open(path);
+    ASSERT_NE(container, nullptr);
+    EXPECT_EQ(container->index().size(), 3);
+    appended_size = container->file_size();
+    EXPECT_GT(appended_size, 4 * blob.size());
+  }
+
+  // Drop "b", keep "a" and "c", and add "d".
+  ASSERT_TRUE(CacheContainer::compact(path, {"a", "c"}, {{"d", blob}}));
+  auto container = CacheContainer::open(path);
+  ASSERT_NE(container, nullptr);
+  EXPECT_EQ(container->index().size(), 3);
+  EXPECT_FALSE(container->contains("b"));
+  EXPECT_EQ(*container->find("a"), std::string(1000, 'y'));
+  EXPECT_EQ(*container->find("c"), blob);
+  EXPECT_EQ(*container->find("d"), blob);
+  EXPECT_LT(container->file_size(), appended_size);
+  EXPECT_LT(container->file_size(), 3 * blob.size() + 256);
+  container.reset();
+  std::remove(path.c_str());
+}
+
+}  // namespace
+}  // namespace taichi
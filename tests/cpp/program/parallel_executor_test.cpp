@@ -0,0 +1,63 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "taichi/program/parallel_executor.h"
+
+namespace taichi::lang {
+
+TEST(ParallelExecutor, Priority) {
+  ParallelExecutor executor("test", /*num_threads=*/1);
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  executor.enqueue([released] { released.wait(); });
+
+  // The only worker is blocked, so the tasks below are popped in priority
+  // order once it is released.
+  std::vector<int> order;
+  for (int priority : {0, 2, 1, 2}) {
+    executor.enqueue([&order, priority] { order.push_back(priority); },
+                     priority);
+  }
+  release.set_value();
+  executor.flush();
+  EXPECT_EQ(order, (std::vector<int>{2, 2, 1, 0}));
+}
+
+TEST(ParallelExecutor, BoundedQueue) {
+  constexpr int kNumTasks = 1000;
+  std::atomic<int> counter{0};
+  {
+    ParallelExecutor executor("test", /*num_threads=*/4,
+                              /*max_queued_tasks=*/2);
+    for (int i = 0; i < kNumTasks; i++) {
+      executor.enqueue([&counter] { counter++; }, i % 3);
+    }
+    executor.flush();
+    EXPECT_EQ(counter.load(), kNumTasks);
+  }
+}
+
+TEST(ParallelExecutor, ConcurrentFlush) {
+  ParallelExecutor executor("test", /*num_threads=*/2);
+  std::atomic<int> counter{0};
+  std::vector<std::thread> callers;
+  for (int t = 0; t < 4; t++) {
+    callers.emplace_back([&executor, &counter] {
+      for (int i = 0; i < 100; i++) {
+        executor.enqueue([&counter] { counter++; });
+        // Every caller must be woken up once the executor goes idle.
+        executor.flush();
+      }
+    });
+  }
+  for (auto &caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(counter.load(), 400);
+}
+
+}  // namespace taichi::lang
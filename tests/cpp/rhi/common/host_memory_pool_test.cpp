@@ -1,5 +1,9 @@
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <thread>
+#include <vector>
+
 #include "taichi/rhi/common/host_memory_pool.h"
 
 namespace taichi::lang {
@@ -34,4 +38,105 @@ TEST(HostMemoryPool, AllocateMemory) {
   HostMemoryPoolTestHelper::setDefaultAllocatorSize(oldAllocatorSize);
 }
 
+TEST(HostMemoryPool, ReuseReleasedMemory) {
+  HostMemoryPool pool;
+
+  void *ptr1 = pool.allocate(1000, 16);
+  pool.release(1000, ptr1);
+  // Same size class, served by the block just released
+  void *ptr2 = pool.allocate(1020, 16);
+  EXPECT_EQ(ptr1, ptr2);
+
+  // Page-aligned (ndarray-like) allocations are recycled as well
+  void *ptr3 = pool.allocate(5000, HostMemoryPool::page_size, true);
+  EXPECT_EQ((std::size_t)ptr3 % HostMemoryPool::page_size, 0);
+  pool.release(5000, ptr3, HostMemoryPool::page_size);
+  void *ptr4 = pool.allocate(5000, HostMemoryPool::page_size, true);
+  EXPECT_EQ(ptr3, ptr4);
+
+  // Large allocations get a dedicated chunk that is returned on release
+  const std::size_t large_size = 4 << 20;
+  void *ptr5 = pool.allocate(large_size, HostMemoryPool::page_size, true);
+  auto reserved = pool.get_stats().bytes_reserved;
+  pool.release(large_size, ptr5, HostMemoryPool::page_size);
+  EXPECT_EQ(pool.get_stats().bytes_reserved, reserved - large_size);
+}
+
+TEST(HostMemoryPool, RecycledMemoryIsZeroed) {
+  HostMemoryPool pool;
+
+  for (std::size_t size : {24, 1000, 5000, 100000}) {
+    auto *ptr1 = (char *)pool.allocate(size, 16);
+    std::fill(ptr1, ptr1 + size, (char)0x5a);
+    pool.release(size, ptr1, 16);
+    auto *ptr2 = (char *)pool.allocate(size, 16);
+    EXPECT_EQ(ptr1, ptr2);
+    for (std::size_t i = 0; i < size; i++) {
+      ASSERT_EQ(ptr2[i], 0);
+    }
+    pool.release(size, ptr2, 16);
+  }
+}
+
+TEST(HostMemoryPool, Stats) {
+  HostMemoryPool pool;
+
+  std::vector<void *> ptrs;
+  for (int i = 0; i < 8; i++) {
+    ptrs.push_back(pool.allocate(1000, 16));
+  }
+  auto stats = pool.get_stats();
+  EXPECT_EQ(stats.bytes_in_use, 8000);
+  EXPECT_EQ(stats.high_water_mark, 8000);
+  EXPECT_GT(stats.bytes_reserved, 0);
+  EXPECT_GT(stats.fragmentation, 0.0);
+  EXPECT_LT(stats.fragmentation, 1.0);
+
+  for (void *ptr : ptrs) {
+    pool.release(1000, ptr);
+  }
+  stats = pool.get_stats();
+  EXPECT_EQ(stats.bytes_in_use, 0);
+  EXPECT_EQ(stats.high_water_mark, 8000);
+  EXPECT_GE(stats.bytes_cached, 8000);
+  EXPECT_DOUBLE_EQ(stats.fragmentation, 1.0);
+
+  pool.reset();
+  stats = pool.get_stats();
+  EXPECT_EQ(stats.high_water_mark, 0);
+  EXPECT_EQ(stats.bytes_cached, 0);
+}
+
+TEST(HostMemoryPool, ConcurrentAllocateRelease) {
+  HostMemoryPool pool;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&pool, t]() {
+      std::vector<std::pair<std::size_t, void *>> live;
+      for (int i = 0; i < 2000; i++) {
+        const std::size_t size = 16 + (i * 37 + t * 101) % 4000;
+        auto *ptr = (char *)pool.allocate(size, 8);
+        std::fill(ptr, ptr + size, (char)t);
+        live.emplace_back(size, ptr);
+        if (live.size() > 16) {
+          auto [old_size, old_ptr] = live[i % live.size()];
+          for (std::size_t j = 0; j < old_size; j++) {
+            ASSERT_EQ(((char *)old_ptr)[j], (char)t);
+          }
+          pool.release(old_size, old_ptr);
+          live.erase(live.begin() + i % live.size());
+        }
+      }
+      for (auto [size, ptr] : live) {
+        pool.release(size, ptr);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(pool.get_stats().bytes_in_use, 0);
+}
+
 }  // namespace taichi::lang
@@ -2,6 +2,7 @@
 
 #include "gtest/gtest.h"
 #include "taichi/analysis/arithmetic_interpretor.h"
+#include "taichi/ir/analysis.h"
 #include "taichi/ir/ir_builder.h"
 #include "taichi/ir/snode.h"
 #include "taichi/ir/statements.h"
@@ -190,5 +191,53 @@ TEST_F(MakeBlockLocalTest, Basic) {
   }
 }
 
+TEST_F(MakeBlockLocalTest, AccumulationOnCpu) {
+  initialize(/*pointer_size=*/2, /*block_size=*/4);
+
+  // x[block_size * i + k, block_size * j] += 1.0 for k in [0, 3). This is
+  // what the adjoint of a stencil gathering x looks like.
+  auto *loop_idx0_ = builder_.get_loop_index(for_stmt_.get(), /*index=*/0);
+  auto *loop_idx1_ = builder_.get_loop_index(for_stmt_.get(), /*index=*/1);
+  auto *idx0 = builder_.create_mul(loop_idx0_,
+                                   builder_.get_int32(get_block_size(0)));
+  auto *idx1 = builder_.create_mul(loop_idx1_,
+                                   builder_.get_int32(get_block_size(1)));
+  constexpr int kNumScatters = 3;
+  for (int k = 0; k < kNumScatters; k++) {
+    auto *glb_ptr = builder_.create_global_ptr(
+        bls_place_snode_,
+        /*indices=*/{builder_.create_add(idx0, builder_.get_int32(k)), idx1});
+    builder_.create_atomic_add(glb_ptr, builder_.get_float32(1.0f));
+  }
+
+  CompileConfig config;
+  config.arch = Arch::x64;
+  irpass::make_block_local(for_stmt_.get(), config,
+                           {"accumulation_on_cpu", /*verbose=*/false,
+                            /*accumulation_only=*/true});
+  irpass::demote_atomics(for_stmt_.get(), config);
+
+  auto count_atomics = [](Block *block, bool global) {
+    return irpass::analysis::gather_statements(block, [&](Stmt *stmt) {
+             auto atomic = stmt->cast<AtomicOpStmt>();
+             return atomic && (global ? atomic->dest->is<GlobalPtrStmt>()
+                                      : atomic->dest->is<BlockLocalPtrStmt>());
+           })
+        .size();
+  };
+  // The loop body accumulates to the BLS buffer without atomics, since the
+  // buffer is private to the thread processing the block.
+  EXPECT_EQ(count_atomics(for_stmt_->body.get(), /*global=*/true), 0);
+  EXPECT_EQ(count_atomics(for_stmt_->body.get(), /*global=*/false), 0);
+  // The epilogue adds the buffer to the field in a serial loop, with a single
+  // global atomic in its body.
+  ASSERT_NE(for_stmt_->bls_epilogue, nullptr);
+  EXPECT_EQ(count_atomics(for_stmt_->bls_epilogue.get(), /*global=*/true), 1);
+  auto loops = irpass::analysis::gather_statements(
+      for_stmt_->bls_epilogue.get(),
+      [](Stmt *stmt) { return stmt->is<RangeForStmt>(); });
+  EXPECT_EQ(loops.size(), 1);
+}
+
 }  // namespace
 }  // namespace taichi::lang
@@ -2,6 +2,7 @@
 
 #include "taichi/ir/statements.h"
 #include "taichi/ir/transforms.h"
+#include "taichi/ir/pass.h"
 #include "tests/cpp/program/test_program.h"
 
 namespace taichi::lang {
@@ -51,4 +52,55 @@ TEST(Simplify, SimplifyLinearizedWithTrivialInputs) {
   }
 }
 
+TEST(Simplify, FullSimplifySkipsUnchangedTasks) {
+  TestProgram test_prog;
+  test_prog.setup();
+  const auto &config = test_prog.prog()->compile_config();
+
+  auto root = std::make_unique<Block>();
+  // Stores c + c to the global temporary at |offset|
+  auto add_store = [](Block *body, int c, int offset) {
+    auto val = body->push_back<ConstStmt>(TypedConstant(c));
+    auto sum = body->push_back<BinaryOpStmt>(BinaryOpType::add, val, val);
+    auto addr =
+        body->push_back<GlobalTemporaryStmt>(offset, PrimitiveType::i32);
+    body->push_back<GlobalStoreStmt>(addr, sum);
+  };
+  std::vector<OffloadedStmt *> tasks;
+  for (int i = 0; i < 2; i++) {
+    tasks.push_back(root->push_back<OffloadedStmt>(
+        OffloadedStmt::TaskType::serial, Arch::x64, nullptr));
+    add_store(tasks[i]->body.get(), 1, i * 4);
+  }
+  irpass::type_check(root.get(), config);
+
+  AnalysisManager amgr;
+  FullSimplifyPass::Args args{false, false, "fake_kernel", false, &amgr};
+  irpass::full_simplify(root.get(), config, args);
+  for (auto task : tasks) {
+    // const 2, global tmp, store
+    EXPECT_EQ(task->body->size(), 3);
+  }
+
+  // Only the second task changes; it must still be simplified
+  add_store(tasks[1]->body.get(), 5, 8);
+  irpass::type_check(root.get(), config);
+  irpass::full_simplify(root.get(), config, args);
+  EXPECT_EQ(tasks[0]->body->size(), 3);
+  EXPECT_EQ(tasks[1]->body->size(), 6);
+  for (auto &stmt : tasks[1]->body->statements) {
+    EXPECT_FALSE(stmt->is<BinaryOpStmt>());
+  }
+}
+
+TEST(Simplify, AnalysisManagerDirtyTracking) {
+  AnalysisManager amgr;
+  Block block;
+  EXPECT_FALSE(amgr.is_clean("pass", &block, 1));
+  amgr.mark_clean("pass", &block, 1);
+  EXPECT_TRUE(amgr.is_clean("pass", &block, 1));
+  EXPECT_FALSE(amgr.is_clean("pass", &block, 2));
+  EXPECT_FALSE(amgr.is_clean("other_pass", &block, 1));
+}
+
 }  // namespace taichi::lang
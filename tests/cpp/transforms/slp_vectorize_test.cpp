@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/ir/type_factory.h"
+
+namespace taichi::lang {
+
+namespace {
+
+int count_binary_ops(Block *block, bool vector) {
+  int count = 0;
+  for (auto &stmt : block->statements) {
+    if (stmt->is<BinaryOpStmt>() &&
+        stmt->ret_type->is<TensorType>() == vector) {
+      count++;
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST(SLPVectorize, ArithmeticTree) {
+  auto block = std::make_unique<Block>();
+
+  /*
+    for i in 0..2:
+      t_i = c_i * c_i
+      u_i = t_i + c_i
+      v_i = u_i * u_i
+      a_i = v_i
+  */
+  std::vector<Stmt *> allocas;
+  std::vector<Stmt *> consts;
+  for (int i = 0; i < 3; i++) {
+    allocas.push_back(block->push_back<AllocaStmt>(PrimitiveType::f32));
+    consts.push_back(
+        block->push_back<ConstStmt>(TypedConstant(float32(i + 1))));
+  }
+  for (int i = 0; i < 3; i++) {
+    auto t = block->push_back<BinaryOpStmt>(BinaryOpType::mul, consts[i],
+                                            consts[i]);
+    t->ret_type = PrimitiveType::f32;
+    auto u = block->push_back<BinaryOpStmt>(BinaryOpType::add, t, consts[i]);
+    u->ret_type = PrimitiveType::f32;
+    auto v = block->push_back<BinaryOpStmt>(BinaryOpType::mul, u, u);
+    v->ret_type = PrimitiveType::f32;
+    block->push_back<LocalStoreStmt>(allocas[i], v);
+  }
+
+  CompileConfig config;
+  config.max_vector_width = 4;
+  EXPECT_TRUE(irpass::slp_vectorize(block.get(), config));
+
+  EXPECT_EQ(count_binary_ops(block.get(), /*vector=*/true), 3);
+  EXPECT_EQ(count_binary_ops(block.get(), /*vector=*/false), 0);
+
+  // Each lane of the root is extracted for its store.
+  int num_stores = 0;
+  for (auto &stmt : block->statements) {
+    if (auto store = stmt->cast<LocalStoreStmt>();
+        store && store->val->is<LocalLoadStmt>()) {
+      num_stores++;
+    }
+  }
+  EXPECT_EQ(num_stores, 3);
+}
+
+TEST(SLPVectorize, DependentLanes) {
+  auto block = std::make_unique<Block>();
+
+  // a = c + c; b = a + c; lanes that depend on each other stay scalar.
+  auto alloca = block->push_back<AllocaStmt>(PrimitiveType::f32);
+  auto c = block->push_back<ConstStmt>(TypedConstant(1.0f));
+  auto a = block->push_back<BinaryOpStmt>(BinaryOpType::add, c, c);
+  a->ret_type = PrimitiveType::f32;
+  auto b = block->push_back<BinaryOpStmt>(BinaryOpType::add, a, c);
+  b->ret_type = PrimitiveType::f32;
+  block->push_back<LocalStoreStmt>(alloca, b);
+
+  CompileConfig config;
+  EXPECT_FALSE(irpass::slp_vectorize(block.get(), config));
+  EXPECT_EQ(count_binary_ops(block.get(), /*vector=*/false), 2);
+}
+
+}  // namespace taichi::lang
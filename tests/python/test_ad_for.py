@@ -1,3 +1,5 @@
+import math
+
 import taichi as ti
 from tests import test_utils
 
@@ -1037,3 +1039,60 @@ def test_for_loop_index():
     for i in range(N):
         for j in range(M):
             assert test_utils.allclose(x.grad[i, j], my_x_grad[i, j])
+
+
+def _recurrence_grad(x0, steps):
+    v = x0
+    grad = 1.0
+    for _ in range(steps):
+        grad *= 0.9 * math.cos(v)
+        v = 0.9 * math.sin(v) + 0.1
+    return grad
+
+
+@test_utils.test(require=ti.extension.adstack, ad_stack_size=32, ad_checkpointing=True)
+def test_ad_checkpointing_long_loop():
+    steps = 200
+    x = ti.field(dtype=float, shape=4, needs_grad=True)
+    loss = ti.field(dtype=float, shape=(), needs_grad=True)
+
+    @ti.kernel
+    def recurrence():
+        for i in x:
+            v = x[i]
+            for t in range(steps):
+                v = 0.9 * ti.sin(v) + 0.1
+            loss[None] += v
+
+    for i in range(4):
+        x[i] = 0.2 * i
+    with ti.ad.Tape(loss=loss):
+        recurrence()
+
+    for i in range(4):
+        assert test_utils.allclose(x.grad[i], _recurrence_grad(0.2 * i, steps), rel=1e-3)
+
+
+@test_utils.test(require=ti.extension.adstack, ad_stack_size=0, ad_checkpointing=True)
+def test_ad_checkpointing_dynamic_range():
+    x = ti.field(dtype=float, shape=4, needs_grad=True)
+    loss = ti.field(dtype=float, shape=(), needs_grad=True)
+
+    @ti.kernel
+    def recurrence(steps: ti.i32):
+        for i in x:
+            v = x[i]
+            for t in range(steps):
+                v = 0.9 * ti.sin(v) + 0.1
+            loss[None] += v
+
+    for i in range(4):
+        x[i] = 0.2 * i
+    for steps in [1, 7, 150]:
+        x.grad.fill(0)
+        loss[None] = 0
+        loss.grad[None] = 1
+        recurrence(steps)
+        recurrence.grad(steps)
+        for i in range(4):
+            assert test_utils.allclose(x.grad[i], _recurrence_grad(0.2 * i, steps), rel=1e-3)
@@ -118,6 +118,8 @@ user_api[ti] = [
     "cache_read_only",
     "cast",
     "ceil",
+    "compile_profiler_clear",
+    "compile_profiler_save",
     "cos",
     "cpu",
     "cuda",
@@ -0,0 +1,67 @@
+import taichi as ti
+from taichi.lang import impl
+from tests import test_utils
+
+
+@test_utils.test()
+def test_compile_kernels_warm_up():
+    x = ti.field(ti.i32, shape=8)
+
+    @ti.kernel
+    def fill(v: ti.i32):
+        for i in x:
+            x[i] = v
+
+    @ti.kernel
+    def inc():
+        for i in x:
+            x[i] += 1
+
+    kernels = []
+    for kernel, args in ((fill, (0,)), (inc, ())):
+        primal = kernel._primal
+        key = primal.ensure_compiled(*args)
+        kernels.append(primal.compiled_kernels[key])
+
+    prog = impl.get_runtime().prog
+    # Duplicates in the batch are compiled once.
+    prog.compile_kernels(prog.config(), prog.get_device_caps(), kernels + kernels)
+
+    fill(3)
+    inc()
+    assert (x.to_numpy() == 4).all()
+
+
+@test_utils.test(arch=ti.cpu, num_compile_threads=2)
+def test_compile_kernels_more_than_threads():
+    n = 8
+    x = ti.field(ti.i32, shape=16)
+
+    # Each kernel has several offloaded tasks, which are compiled on the
+    # workers shared by all the kernels of the batch.
+    def make_kernel(k):
+        @ti.kernel
+        def step():
+            for i in x:
+                x[i] += k
+            for i in x:
+                x[i] *= 2
+            for i in x:
+                x[i] -= k
+
+        return step
+
+    steps = [make_kernel(k) for k in range(n)]
+    kernels = []
+    for step in steps:
+        primal = step._primal
+        kernels.append(primal.compiled_kernels[primal.ensure_compiled()])
+
+    prog = impl.get_runtime().prog
+    prog.compile_kernels(prog.config(), prog.get_device_caps(), kernels)
+
+    expected = 0
+    for k, step in enumerate(steps):
+        step()
+        expected = (expected + k) * 2 - k
+    assert (x.to_numpy() == expected).all()
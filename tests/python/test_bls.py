@@ -1,3 +1,5 @@
+import numpy as np
+
 import taichi as ti
 from tests import test_utils
 
@@ -181,6 +183,48 @@ def test_bls_large_block():
     foo()
 
 
+def _test_bls_adjoint_accumulation():
+    N = 128
+    bs = 16
+    x, y = ti.field(ti.f32), ti.field(ti.f32)
+    ti.root.pointer(ti.i, N // bs).dense(ti.i, bs).place(x, y)
+    ti.root.lazy_grad()
+
+    @ti.kernel
+    def activate():
+        for i in range(bs, N - bs):
+            y[i] = 0
+
+    @ti.kernel
+    def stencil():
+        ti.block_local(x)
+        for i in y:
+            y[i] = x[i - 1] + 2 * x[i] + x[i + 1]
+
+    activate()
+    for i in range(bs, N - bs):
+        y.grad[i] = i
+    stencil.grad()
+
+    expected = np.zeros(N, dtype=np.float32)
+    for i in range(bs, N - bs):
+        expected[i - 1] += i
+        expected[i] += 2 * i
+        expected[i + 1] += i
+    np.testing.assert_allclose(x.grad.to_numpy(), expected)
+
+
+@test_utils.test(require=ti.extension.bls)
+def test_bls_adjoint_accumulation():
+    _test_bls_adjoint_accumulation()
+
+
+@test_utils.test(arch=ti.cpu)
+def test_bls_adjoint_accumulation_cpu():
+    # Only the accumulations are lowered to block-local buffers on CPU
+    _test_bls_adjoint_accumulation()
+
+
 # TODO: BLS on CPU
 # TODO: BLS boundary out of bound
 # TODO: BLS with TLS
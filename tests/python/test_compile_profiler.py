@@ -0,0 +1,41 @@
+import json
+import os
+import tempfile
+
+import taichi as ti
+from tests import test_utils
+
+
+@test_utils.test(arch=ti.cpu, compile_profiler=True, offline_cache=False)
+def test_compile_profiler():
+    x = ti.field(ti.i32, shape=16)
+
+    @ti.kernel
+    def fill():
+        for i in x:
+            x[i] = i * 2
+        for i in range(4):
+            x[i] += 1
+
+    ti.compile_profiler_clear()
+    fill()
+
+    with tempfile.TemporaryDirectory() as tmpdir:
+        fn = os.path.join(tmpdir, "compile_profile.json")
+        ti.compile_profiler_save(fn)
+        with open(fn) as f:
+            passes = json.load(f)["passes"]
+
+    passes = [p for p in passes if p["kernel"].startswith("fill")]
+    names = {p["pass"] for p in passes}
+    assert "Offloaded" in names
+    assert "codegen" in names
+    assert "llvm_optimize" in names
+    # Both offloaded tasks are lowered and generated separately.
+    codegen_tasks = [p["task"] for p in passes if p["pass"] == "codegen"]
+    assert len(codegen_tasks) >= 2
+    assert all(codegen_tasks)
+    for p in passes:
+        assert p["time_us"] >= 0
+        if p["pass"] not in ("codegen", "link", "llvm_optimize"):
+            assert p["stmts_before"] >= 0 and p["stmts_after"] >= 0
@@ -0,0 +1,59 @@
+import numpy as np
+
+import taichi as ti
+from tests import test_utils
+
+
+@test_utils.test(arch=ti.cpu, cpu_async_launch=True)
+def test_async_launch_field_chain():
+    n = 1024
+    x = ti.field(dtype=ti.i32, shape=n)
+
+    @ti.kernel
+    def inc():
+        for i in x:
+            x[i] += i
+
+    for _ in range(100):
+        inc()
+    ti.sync()
+
+    for i in range(n):
+        assert x[i] == 100 * i
+
+
+@test_utils.test(arch=ti.cpu, cpu_async_launch=True)
+def test_async_launch_ndarray():
+    n = 1024
+    a = ti.ndarray(dtype=ti.f32, shape=n)
+
+    @ti.kernel
+    def scale(arr: ti.types.ndarray(), k: ti.f32):
+        for i in arr:
+            arr[i] = arr[i] * k + 1.0
+
+    a.fill(1.0)
+    for _ in range(10):
+        scale(a, 2.0)
+
+    expected = 1.0
+    for _ in range(10):
+        expected = expected * 2.0 + 1.0
+    assert np.allclose(a.to_numpy(), expected)
+
+
+@test_utils.test(arch=ti.cpu, cpu_async_launch=True)
+def test_async_launch_return_value():
+    x = ti.field(dtype=ti.i32, shape=())
+
+    @ti.kernel
+    def inc():
+        x[None] += 1
+
+    @ti.kernel
+    def get() -> ti.i32:
+        return x[None]
+
+    for _ in range(50):
+        inc()
+    assert get() == 50
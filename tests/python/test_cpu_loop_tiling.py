@@ -0,0 +1,102 @@
+import numpy as np
+
+import taichi as ti
+from tests import test_utils
+
+
+def _stencil_3d(n):
+    x = ti.field(ti.f32, shape=(n, n, n))
+    y = ti.field(ti.f32, shape=(n, n, n))
+
+    @ti.kernel
+    def fill():
+        for i, j, k in x:
+            x[i, j, k] = i * 10000 + j * 100 + k
+
+    @ti.kernel
+    def stencil():
+        for i, j, k in y:
+            s = 0.0
+            for di, dj, dk in ti.static(ti.ndrange((-1, 2), (-1, 2), (-1, 2))):
+                s += x[
+                    ti.max(0, ti.min(n - 1, i + di)),
+                    ti.max(0, ti.min(n - 1, j + dj)),
+                    ti.max(0, ti.min(n - 1, k + dk)),
+                ]
+            y[i, j, k] = s
+
+    fill()
+    stencil()
+
+    a = x.to_numpy()
+    p = np.pad(a, 1, mode="edge")
+    expected = sum(
+        p[1 + di : 1 + di + n, 1 + dj : 1 + dj + n, 1 + dk : 1 + dk + n]
+        for di in range(-1, 2)
+        for dj in range(-1, 2)
+        for dk in range(-1, 2)
+    )
+    np.testing.assert_allclose(y.to_numpy(), expected, rtol=1e-5)
+
+
+@test_utils.test(arch=ti.cpu)
+def test_stencil_3d_auto_tile():
+    _stencil_3d(36)
+
+
+@test_utils.test(arch=ti.cpu, cpu_loop_tile_size=4)
+def test_stencil_3d_pow2_tile():
+    _stencil_3d(36)
+
+
+@test_utils.test(arch=ti.cpu, cpu_loop_tile_size=6)
+def test_stencil_3d_non_pow2_tile():
+    _stencil_3d(36)
+
+
+@test_utils.test(arch=ti.cpu, cpu_loop_tiling=False)
+def test_stencil_3d_untiled():
+    _stencil_3d(36)
+
+
+@test_utils.test(arch=ti.cpu, cpu_loop_tile_size=8)
+def test_visits_every_cell_once():
+    x = ti.field(ti.i32, shape=(48, 40))
+
+    @ti.kernel
+    def count():
+        for i, j in x:
+            x[i, j] += 1
+
+    count()
+    count()
+    assert (x.to_numpy() == 2).all()
+
+
+@test_utils.test(arch=ti.cpu, cpu_loop_tile_size=4, make_cpu_multithreading_loop=False)
+def test_without_multithreading_loop():
+    x = ti.field(ti.i32, shape=(32, 24, 20))
+
+    @ti.kernel
+    def fill():
+        for i, j, k in x:
+            x[i, j, k] = i * 10000 + j * 100 + k
+
+    fill()
+    i, j, k = np.meshgrid(np.arange(32), np.arange(24), np.arange(20), indexing="ij")
+    assert (x.to_numpy() == i * 10000 + j * 100 + k).all()
+
+
+@test_utils.test(arch=ti.cpu, cpu_loop_tile_size=4)
+def test_blocked_layout():
+    x = ti.field(ti.i32)
+    ti.root.dense(ti.ij, (6, 5)).dense(ti.ij, (4, 8)).place(x)
+
+    @ti.kernel
+    def fill():
+        for i, j in x:
+            x[i, j] = i * 100 + j
+
+    fill()
+    i, j = np.meshgrid(np.arange(24), np.arange(40), indexing="ij")
+    assert (x.to_numpy() == i * 100 + j).all()
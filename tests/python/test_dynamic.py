@@ -320,3 +320,139 @@ def test_append_matrix_in_struct():
             for k in range(4):
                 assert f[i, j].b[k // 2, k % 2] == i * j * (k + 1) % 256
             assert f[i, j].c == i * j * 5000 % 65536
+
+
+@test_utils.test(require=ti.extension.sparse, exclude=[ti.metal])
+def test_dynamic_many_chunks():
+    n = 64
+    length = 4096
+    x = ti.field(ti.i32)
+    l = ti.field(ti.i32, n)
+    lists = ti.root.dense(ti.i, n).dynamic(ti.j, length, chunk_size=16)
+    lists.place(x)
+
+    @ti.kernel
+    def fill():
+        for i, k in ti.ndrange(n, length // 2):
+            ti.append(lists, i, k)
+
+    @ti.kernel
+    def get_lengths():
+        for i in range(n):
+            l[i] = ti.length(lists, i)
+
+    @ti.kernel
+    def total(i: ti.i32) -> ti.i32:
+        s = 0
+        for j in range(ti.length(lists, i)):
+            s += x[i, j]
+        return s
+
+    expected = (length // 2) * (length // 2 - 1) // 2
+    for _ in range(2):
+        fill()
+        get_lengths()
+        assert (l.to_numpy() == length // 2).all()
+        for i in range(n):
+            assert total(i) == expected
+        # Activating the last element allocates all the chunks before it
+        x[3, length - 1] = 7
+        assert x[3, length - 10] == 0
+        x[3, length - 10] = 5
+        get_lengths()
+        assert l[3] == length
+        assert total(3) == expected + 12
+        lists.deactivate_all()
+        get_lengths()
+        assert (l.to_numpy() == 0).all()
+
+
+@test_utils.test(require=ti.extension.sparse, exclude=[ti.metal])
+def test_dynamic_container_size_is_bounded():
+    n = 8
+    length = 1 << 16
+    x = ti.field(ti.i32)
+    block = ti.root.dense(ti.ijk, n)
+    lists = block.dynamic(ti.l, length, chunk_size=16)
+    lists.place(x)
+
+    @ti.kernel
+    def fill():
+        for i, j, k in ti.ndrange(n, n, n):
+            for l in range((i + j + k) * 300):
+                ti.append(lists, [i, j, k], l)
+
+    @ti.kernel
+    def check() -> ti.i32:
+        errors = 0
+        for i, j, k in ti.ndrange(n, n, n):
+            if ti.length(lists, [i, j, k]) != (i + j + k) * 300:
+                errors += 1
+            for l in range(ti.length(lists, [i, j, k])):
+                if x[i, j, k, l] != l:
+                    errors += 1
+        return errors
+
+    fill()
+    assert check() == 0
+    # Lock, length and a few directory entries, regardless of the length
+    assert block._cell_size_bytes <= 64
+    x[1, 2, 3, length - 1] = 42
+    assert x[1, 2, 3, length - 1] == 42
+    assert x[1, 2, 3, length - 2] == 0
+    lists.deactivate_all()
+    fill()
+    assert check() == 0
+
+
+
+@test_utils.test(require=ti.extension.sparse, exclude=[ti.metal])
+def test_dynamic_append_to_full_list():
+    n = 32
+    x = ti.field(ti.i32)
+    lists = ti.root.dense(ti.i, 3).dynamic(ti.j, n, chunk_size=4)
+    lists.place(x)
+
+    @ti.kernel
+    def fill_neighbours():
+        for i, j in ti.ndrange(3, n):
+            if i != 1:
+                x[i, j] = i * 1000 + j
+
+    @ti.kernel
+    def overflow():
+        ti.loop_config(serialize=True)
+        for j in range(n * 3):
+            ti.append(lists, 1, 1000 + j)
+
+    @ti.kernel
+    def check() -> ti.i32:
+        errors = 0
+        for i in range(3):
+            if ti.length(lists, i) != n:
+                errors += 1
+        for i, j in ti.ndrange(3, n):
+            if x[i, j] != i * 1000 + j:
+                errors += 1
+        return errors
+
+    fill_neighbours()
+    # Appends past the capacity are dropped instead of overwriting the lists
+    # next to the full one.
+    overflow()
+    assert check() == 0
+
+
+@test_utils.test(require=ti.extension.sparse, exclude=[ti.metal], debug=True)
+def test_dynamic_append_to_full_list_debug():
+    x = ti.field(ti.i32)
+    lists = ti.root.dense(ti.i, 3).dynamic(ti.j, 8, chunk_size=4)
+    lists.place(x)
+
+    @ti.kernel
+    def overflow():
+        for j in range(9):
+            ti.append(lists, 1, j)
+
+    with pytest.raises(ti.TaichiAssertionError, match="full dynamic field"):
+        overflow()
@@ -88,3 +88,66 @@ def test_pointer_gc():
 
         # Note that being inactive doesn't mean it's not allocated.
         assert L._num_dynamically_allocated == 1
+
+
+@test_utils.test(require=ti.extension.sparse, cpu_max_num_threads=4)
+def test_pointer_gc_many_blocks():
+    # Enough recycled blocks for the CPU backend to GC on the thread pool
+    N = 8192
+    x = ti.field(dtype=ti.i32)
+
+    L = ti.root.pointer(ti.i, N)
+    L.dense(ti.i, 4).place(x)
+
+    @ti.kernel
+    def activate(val: ti.i32):
+        for i in range(N):
+            x[i * 4] = val
+
+    @ti.kernel
+    def total() -> ti.i32:
+        s = 0
+        for i in x:
+            s += x[i]
+        return s
+
+    for i in range(1, 4):
+        activate(i)
+        # Recycled blocks must come back zero-filled
+        assert total() == N * i
+        assert L._num_dynamically_allocated == N
+        L.deactivate_all()
+
+
+@test_utils.test(require=ti.extension.sparse)
+def test_pointer_gc_nothing_recycled():
+    x = ti.field(dtype=ti.i32)
+
+    L = ti.root.pointer(ti.i, 64)
+    L.dense(ti.i, 4).place(x)
+
+    @ti.kernel
+    def deactivate_above(m: ti.i32):
+        for i in L:
+            if i >= m:
+                ti.deactivate(L, i)
+
+    @ti.kernel
+    def total() -> ti.i32:
+        s = 0
+        for i in x:
+            s += x[i]
+        return s
+
+    for i in range(64):
+        x[i * 4] = 1
+    deactivate_above(32 * 4)
+    for i in range(3):
+        # Deactivates nothing, so GC has nothing to recycle
+        deactivate_above(64 * 4)
+        assert total() == 32
+    for i in range(32, 64):
+        x[i * 4] = 2
+    # The recycled blocks are reused and come back zero-filled
+    assert L._num_dynamically_allocated == 64
+    assert total() == 32 + 64
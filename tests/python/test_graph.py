@@ -461,3 +461,56 @@ def test_texture_struct_for():
 
     graph.run({"tex": tex, "arr": arr})
     assert arr.to_numpy().sum() == 128 * 128
+
+
+def _run_producer_consumer_graph(n, num_dispatches):
+    @ti.kernel
+    def produce(x: ti.types.ndarray(ndim=1), scale: ti.f32):
+        for i in x:
+            x[i] = i * scale
+
+    @ti.kernel
+    def consume(x: ti.types.ndarray(ndim=1), y: ti.types.ndarray(ndim=1)):
+        for i in x:
+            y[i] = x[i] + 1
+
+    @ti.kernel
+    def reduce(y: ti.types.ndarray(ndim=1), total: ti.types.ndarray(ndim=0)):
+        for i in y:
+            total[None] += y[i]
+
+    sym_x = ti.graph.Arg(ti.graph.ArgKind.NDARRAY, "x", ti.f32, ndim=1)
+    sym_y = ti.graph.Arg(ti.graph.ArgKind.NDARRAY, "y", ti.f32, ndim=1)
+    sym_total = ti.graph.Arg(ti.graph.ArgKind.NDARRAY, "total", ti.f32, ndim=0)
+    sym_scale = ti.graph.Arg(ti.graph.ArgKind.SCALAR, "scale", ti.f32)
+    g_builder = ti.graph.GraphBuilder()
+    g_builder.dispatch(produce, sym_x, sym_scale)
+    g_builder.dispatch(consume, sym_x, sym_y)
+    g_builder.dispatch(reduce, sym_y, sym_total)
+    g = g_builder.compile()
+    assert g._compiled_graph.num_dispatches == num_dispatches
+
+    x = ti.ndarray(ti.f32, shape=(n,))
+    y = ti.ndarray(ti.f32, shape=(n,))
+    total = ti.ndarray(ti.f32, shape=())
+    g.run({"x": x, "y": y, "total": total, "scale": 2.0})
+    expected = np.arange(n, dtype=np.float32) * 2 + 1
+    np.testing.assert_allclose(y.to_numpy(), expected)
+    assert total.to_numpy() == test_utils.approx(expected.sum(), rel=1e-5)
+
+    total.fill(0)
+    g.run({"x": y, "y": x, "total": total, "scale": 3.0})
+    expected = np.arange(n, dtype=np.float32) * 3 + 1
+    np.testing.assert_allclose(x.to_numpy(), expected)
+    assert total.to_numpy() == test_utils.approx(expected.sum(), rel=1e-5)
+
+
+@test_utils.test(arch=supported_archs_cgraph)
+def test_graph_fusion():
+    # The three dispatches are launched as one kernel.
+    _run_producer_consumer_graph(128, num_dispatches=1)
+
+
+@test_utils.test(arch=supported_archs_cgraph, graph_fusion=False)
+def test_graph_fusion_disabled():
+    _run_producer_consumer_graph(128, num_dispatches=3)
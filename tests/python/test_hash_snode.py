@@ -0,0 +1,272 @@
+import numpy as np
+
+import taichi as ti
+from tests import test_utils
+
+
+@test_utils.test(arch=[ti.x64, ti.arm64])
+def test_hash_unbounded_domain():
+    x = ti.field(ti.i32)
+    s = ti.field(ti.i32, shape=())
+
+    n = 2**14
+    block = ti.root.hash(ti.ij, (n, n), capacity=1024)
+    block.dense(ti.ij, 4).place(x)
+
+    @ti.kernel
+    def fill():
+        for k in range(300):
+            x[k * 200, (k * 104729) % (n * 4)] = k + 1
+
+    @ti.kernel
+    def count():
+        for i, j in x:
+            s[None] += 1
+
+    fill()
+    count()
+    assert s[None] == 300 * 16
+    for k in range(300):
+        assert x[k * 200, (k * 104729) % (n * 4)] == k + 1
+    assert x[1, 1] == 0
+
+
+@test_utils.test(arch=[ti.x64, ti.arm64])
+def test_hash_struct_for_leaf():
+    x = ti.field(ti.f32)
+    s = ti.field(ti.f32, shape=())
+    ti.root.hash(ti.i, 2**30, capacity=256).place(x)
+
+    @ti.kernel
+    def fill():
+        for k in range(100):
+            x[k * 10000019] = k
+
+    @ti.kernel
+    def total():
+        for i in x:
+            s[None] += x[i]
+
+    fill()
+    total()
+    assert s[None] == sum(range(100))
+
+
+@test_utils.test(arch=[ti.x64, ti.arm64])
+def test_hash_activation():
+    x = ti.field(ti.i32)
+    h = ti.root.hash(ti.i, 2**20, capacity=64)
+    h.place(x)
+
+    @ti.kernel
+    def activate(base: ti.i32):
+        for k in range(50):
+            ti.activate(h, base + k * 1000)
+
+    @ti.kernel
+    def active_cells() -> ti.i32:
+        c = 0
+        for i in x:
+            c += 1
+        return c
+
+    @ti.kernel
+    def is_active(i: ti.i32) -> ti.i32:
+        return ti.is_active(h, i)
+
+    @ti.kernel
+    def deactivate_odd():
+        for i in x:
+            if i % 2000 != 0:
+                ti.deactivate(h, i)
+
+    activate(0)
+    assert active_cells() == 50
+    assert is_active(1000) and not is_active(1)
+    deactivate_odd()
+    assert active_cells() == 25
+    assert not is_active(1000) and is_active(2000)
+
+    # Deactivated slots are reused, although the table only has 64 of them.
+    for base in range(1, 10):
+        h.deactivate_all()
+        activate(base)
+        assert active_cells() == 50
+        assert is_active(base + 49000)
+
+
+@test_utils.test(arch=[ti.x64, ti.arm64], cpu_max_num_threads=8)
+def test_hash_parallel_activation():
+    x = ti.field(ti.i32)
+    n = 2**16
+    ti.root.hash(ti.i, 2**24, capacity=n).place(x)
+
+    @ti.kernel
+    def fill():
+        for k in range(n // 2):
+            # Many threads activate the same cells.
+            ti.atomic_add(x[(k % 1000) * 4099], 1)
+
+    fill()
+    values = np.array([x[k * 4099] for k in range(1000)])
+    expected = np.array([len(range(k, n // 2, 1000)) for k in range(1000)])
+    assert (values == expected).all()
+
+
+@test_utils.test(arch=[ti.x64, ti.arm64], cpu_max_num_threads=8)
+def test_hash_activation_with_concurrent_deactivation():
+    x = ti.field(ti.i32)
+    capacity = 2**12
+    h = ti.root.hash(ti.i, 2**24, capacity=capacity)
+    h.place(x)
+
+    @ti.kernel
+    def activate_cold():
+        for k in range(capacity // 2):
+            x[1000000 + k] = 1
+
+    @ti.kernel
+    def churn():
+        for k in range(capacity * 4):
+            if k % 2 == 0:
+                # Tombstones appear on the probe sequences of the hot cells
+                # while they are being inserted.
+                ti.deactivate(h, 1000000 + k // 8)
+            else:
+                ti.atomic_add(x[k % 64], 1)
+
+    @ti.kernel
+    def active_cells() -> ti.i32:
+        c = 0
+        for i in x:
+            c += 1
+        return c
+
+    @ti.kernel
+    def total() -> ti.i32:
+        s = 0
+        for i in x:
+            if i < 64:
+                s += x[i]
+        return s
+
+    activate_cold()
+    churn()
+    # Every hot cell has exactly one slot: no duplicates in the element list.
+    assert active_cells() == 64
+    assert total() == capacity * 2
+
+
+def hash_home_slot(i, capacity):
+    # hash_cell_index() of the runtime.
+    mask = 2**32 - 1
+    i ^= i >> 16
+    i = (i * 0x85EBCA6B) & mask
+    i ^= i >> 13
+    i = (i * 0xC2B2AE35) & mask
+    i ^= i >> 16
+    return i & (capacity - 1)
+
+
+@test_utils.test(arch=[ti.x64, ti.arm64])
+def test_hash_churn_removes_tombstones():
+    x = ti.field(ti.i32)
+    capacity = 256
+    num_kept = capacity // 4
+    h = ti.root.hash(ti.i, 2**24, capacity=capacity)
+    h.place(x)
+
+    @ti.kernel
+    def activate(base: ti.i32):
+        for k in range(capacity // 2):
+            x[base + k * 7919] = base + k
+
+    @ti.kernel
+    def keep():
+        for k in range(num_kept):
+            x[10000000 + k * 13] = k + 1
+
+    @ti.kernel
+    def deactivate_churned():
+        for i in x:
+            if i < 10000000:
+                ti.deactivate(h, i)
+
+    @ti.kernel
+    def check(base: ti.i32) -> ti.i32:
+        c = 0
+        for k in range(capacity // 2):
+            if x[base + k * 7919] == base + k:
+                c += 1
+        # Cells that were never active still read the ambient value.
+        if x[base + 1] != 0:
+            c = -1
+        return c
+
+    @ti.kernel
+    def check_kept() -> ti.i32:
+        c = 0
+        for k in range(num_kept):
+            if ti.is_active(h, 10000000 + k * 13) and x[10000000 + k * 13] == k + 1:
+                c += 1
+        return c
+
+    @ti.kernel
+    def active_cells() -> ti.i32:
+        c = 0
+        for i in x:
+            c += 1
+        return c
+
+    # Each round leaves a tombstone in half of the slots until GC rebuilds
+    # the table, which moves the cells that stay active.
+    keep()
+    for base in range(2, 40):
+        activate(base)
+        assert check(base) == capacity // 2
+        deactivate_churned()
+        assert check_kept() == num_kept
+        assert active_cells() == num_kept
+    # Writing to the kept cells finds their slots instead of taking new ones.
+    keep()
+    assert active_cells() == num_kept
+
+
+@test_utils.test(arch=[ti.x64, ti.arm64])
+def test_hash_gc_keeps_probe_sequences():
+    x = ti.field(ti.i32)
+    capacity = 8
+    h = ti.root.hash(ti.i, 2**24, capacity=capacity)
+    h.place(x)
+
+    def cell_with_home(home, taken):
+        return next(i for i in range(1, 2**20) if i not in taken and hash_home_slot(i, capacity) == home)
+
+    cells = {}
+    for name, home in [("w", 3), ("v", 4), ("x", 4), ("d1", 3), ("d2", 5)]:
+        cells[name] = cell_with_home(home, cells.values())
+
+    @ti.kernel
+    def deactivate(i: ti.i32, j: ti.i32):
+        ti.deactivate(h, i)
+        ti.deactivate(h, j)
+
+    @ti.kernel
+    def active_cells() -> ti.i32:
+        c = 0
+        for i in x:
+            c += 1
+        return c
+
+    # d1 and d2 sit on the probe sequences of w, v and x, so GC moves all
+    # three of them.
+    for value, name in enumerate(["d1", "w", "d2", "v", "x"]):
+        x[cells[name]] = value + 1
+    deactivate(cells["d1"], cells["d2"])
+    assert active_cells() == 3
+    assert x[cells["w"]] == 2
+    assert x[cells["v"]] == 4
+    assert x[cells["x"]] == 5
+    x[cells["x"]] = 6
+    assert active_cells() == 3
+    assert x[cells["x"]] == 6
@@ -1,5 +1,7 @@
 from random import randrange
 
+import numpy as np
+
 import taichi as ti
 from tests import test_utils
 
@@ -55,3 +57,63 @@ def test_nested_3d():
     for _ in range(1000):
         i, j, k = randrange(n), randrange(n), randrange(n)
         assert x[i, j, k] == (i * n + j) * n + k
+
+
+def _test_sparse_listgen():
+    n = 512
+    x = ti.field(ti.i32)
+    cells = ti.root.pointer(ti.ij, 64).bitmasked(ti.ij, 4)
+    cells.dense(ti.ij, 4).place(x)
+
+    @ti.kernel
+    def activate(step: ti.i32):
+        for i, j in ti.ndrange(n, n):
+            if (i * 7 + j * 3) % step == 0:
+                x[i, j] = 1
+
+    @ti.kernel
+    def deactivate_rows(m: ti.i32):
+        for i, j in cells:
+            if i < m:
+                ti.deactivate(cells, [i, j])
+
+    @ti.kernel
+    def count() -> ti.i32:
+        s = 0
+        for i, j in x:
+            s += 1
+        return s
+
+    def active_cells(step):
+        i, j = np.meshgrid(np.arange(n), np.arange(n), indexing="ij")
+        mask = (i * 7 + j * 3) % step == 0
+        return mask.reshape(n // 4, 4, n // 4, 4).any(axis=(1, 3))
+
+    activate(5)
+    active = active_cells(5)
+    # Nothing is activated between these launches, so their lists are reused
+    for _ in range(3):
+        assert count() == active.sum() * 16
+    activate(3)
+    active |= active_cells(3)
+    for _ in range(2):
+        assert count() == active.sum() * 16
+    deactivate_rows(n // 4)
+    active[: n // 16] = False
+    for _ in range(2):
+        assert count() == active.sum() * 16
+
+
+@test_utils.test(require=ti.extension.sparse)
+def test_sparse_listgen_reuse():
+    _test_sparse_listgen()
+
+
+@test_utils.test(require=ti.extension.sparse, arch=ti.cpu, cpu_max_num_threads=4)
+def test_sparse_listgen_parallel():
+    _test_sparse_listgen()
+
+
+@test_utils.test(require=ti.extension.sparse, listgen_reuse=False)
+def test_sparse_listgen_no_reuse():
+    _test_sparse_listgen()
@@ -0,0 +1,57 @@
+import json
+import os
+import tempfile
+
+import taichi as ti
+from tests import test_utils
+
+
+def _count_codegen(kernel_prefix):
+    with tempfile.TemporaryDirectory() as tmpdir:
+        fn = os.path.join(tmpdir, "compile_profile.json")
+        ti.compile_profiler_save(fn)
+        with open(fn) as f:
+            passes = json.load(f)["passes"]
+    return sum(1 for p in passes if p["pass"] == "codegen" and p["kernel"].startswith(kernel_prefix))
+
+
+@test_utils.test(arch=ti.cpu, compile_profiler=True, offline_cache=False)
+def test_share_identical_tasks():
+    x = ti.field(ti.i32, shape=16)
+    y = ti.field(ti.i32, shape=16)
+    z = ti.field(ti.i32, shape=4)
+
+    @ti.kernel
+    def step(k: ti.template()):
+        for i in x:
+            y[i] = x[i] * 2
+        for i in range(4):
+            z[i] = k
+
+    for i in range(16):
+        x[i] = i
+    ti.compile_profiler_clear()
+    step(1)
+    num_tasks = _count_codegen("step")
+    step(2)
+    # Only the tasks of the second loop differ between the instantiations.
+    assert num_tasks < _count_codegen("step") < 2 * num_tasks
+    for i in range(16):
+        assert y[i] == i * 2
+    for i in range(4):
+        assert z[i] == 2
+
+
+@test_utils.test(arch=ti.cpu, compile_profiler=True, offline_cache=False, llvm_task_cache=False)
+def test_share_identical_tasks_disabled():
+    x = ti.field(ti.i32, shape=16)
+
+    @ti.kernel
+    def fill(k: ti.template()):
+        for i in x:
+            x[i] = i + k
+
+    ti.compile_profiler_clear()
+    fill(1)
+    fill(2)
+    assert _count_codegen("fill") == 2
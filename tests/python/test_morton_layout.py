@@ -0,0 +1,116 @@
+import numpy as np
+import pytest
+
+import taichi as ti
+from tests import test_utils
+
+
+def morton_offset(coords, shape):
+    # Bricks of 2^m cells per axis in row-major order, Z-order within a brick.
+    m = min(s.bit_length() - 1 for s in shape)
+    d = len(shape)
+    brick = 0
+    code = 0
+    for q, (c, s) in enumerate(zip(coords, shape)):
+        brick = brick * (s >> m) + (c >> m)
+        for t in range(m):
+            code |= ((c >> t) & 1) << (t * d + d - 1 - q)
+    return (brick << (m * d)) | code
+
+
+def _test_morton_visit_order(shape):
+    x = ti.field(ti.i32)
+    ti.root.dense(ti.axes(*range(len(shape))), shape, morton=True).place(x)
+
+    @ti.kernel
+    def visit():
+        counter = 0
+        ti.loop_config(serialize=True)
+        for I in ti.grouped(x):
+            x[I] = counter
+            counter += 1
+
+    visit()
+    expected = np.zeros(shape, dtype=np.int32)
+    for coords in np.ndindex(*shape):
+        expected[coords] = morton_offset(coords, shape)
+    assert (x.to_numpy() == expected).all()
+
+
+@pytest.mark.parametrize("shape", [(8, 8), (16, 16, 16), (4, 16), (32, 8, 4)])
+@test_utils.test()
+def test_morton_visit_order(shape):
+    _test_morton_visit_order(shape)
+
+
+@pytest.mark.parametrize("shape", [(8, 8), (4, 16), (32, 8, 4)])
+@test_utils.test(require=ti.extension.sparse, demote_dense_struct_fors=False)
+def test_morton_visit_order_listgen(shape):
+    _test_morton_visit_order(shape)
+
+
+@test_utils.test()
+def test_morton_stencil():
+    n = 32
+    x = ti.field(ti.f32)
+    y = ti.field(ti.f32)
+    ti.root.dense(ti.ijk, n, morton=True).place(x, y)
+
+    @ti.kernel
+    def laplace():
+        for i, j, k in x:
+            if 0 < i < n - 1 and 0 < j < n - 1 and 0 < k < n - 1:
+                y[i, j, k] = (
+                    x[i - 1, j, k]
+                    + x[i + 1, j, k]
+                    + x[i, j - 1, k]
+                    + x[i, j + 1, k]
+                    + x[i, j, k - 1]
+                    + x[i, j, k + 1]
+                    - 6 * x[i, j, k]
+                )
+
+    a = np.random.rand(n, n, n).astype(np.float32)
+    x.from_numpy(a)
+    laplace()
+    expected = np.zeros_like(a)
+    expected[1:-1, 1:-1, 1:-1] = (
+        a[:-2, 1:-1, 1:-1]
+        + a[2:, 1:-1, 1:-1]
+        + a[1:-1, :-2, 1:-1]
+        + a[1:-1, 2:, 1:-1]
+        + a[1:-1, 1:-1, :-2]
+        + a[1:-1, 1:-1, 2:]
+        - 6 * a[1:-1, 1:-1, 1:-1]
+    )
+    assert np.allclose(y.to_numpy(), expected, atol=1e-4)
+
+
+@test_utils.test(require=ti.extension.sparse)
+def test_morton_under_pointer():
+    x = ti.field(ti.i32)
+    s = ti.field(ti.i32, shape=())
+    ti.root.pointer(ti.ij, 4).dense(ti.ij, (8, 16), morton=True).place(x)
+
+    @ti.kernel
+    def fill():
+        for i, j in ti.ndrange(8, 64):
+            x[i + 16, j] = (i + 16) * 1000 + j
+
+    @ti.kernel
+    def check():
+        for i, j in x:
+            if x[i, j] == i * 1000 + j:
+                s[None] += 1
+
+    fill()
+    check()
+    assert s[None] == 8 * 64
+    assert x[19, 37] == 19037
+    assert x[3, 37] == 0
+
+
+@test_utils.test(arch=ti.cpu)
+def test_morton_non_power_of_two():
+    with pytest.raises(ti.TaichiRuntimeError, match="power of two"):
+        ti.root.dense(ti.ij, (8, 12), morton=True)
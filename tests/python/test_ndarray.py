@@ -1,4 +1,5 @@
 import copy
+import gc
 
 import numpy as np
 import pytest
@@ -1161,3 +1162,39 @@ def test_real_func_write_ndarray_cfg():
     a = ti.Vector.ndarray(3, float, shape=(2,))
     foo(a)
     assert (a[0] == vec3(3)).all()
+
+
+@test_utils.test(arch=ti.cpu)
+def test_ndarray_freed_memory_zeroed_for_sparse_snodes():
+    # Freed ndarray memory is recycled by the host memory pool, which also
+    # backs the sparse SNode chunks of the LLVM runtime.
+    for n in [16, 256, 4096, 65536]:
+        a = ti.ndarray(ti.i32, shape=n)
+        a.fill(7)
+        del a
+    gc.collect()
+
+    x = ti.field(ti.i32)
+    y = ti.field(ti.i32)
+    z = ti.field(ti.i32)
+    ti.root.pointer(ti.i, 64).dense(ti.i, 32).place(x, y)
+    ti.root.dynamic(ti.j, 4096, chunk_size=64).place(z)
+
+    @ti.kernel
+    def activate():
+        for i in range(64):
+            x[i * 32] = 1
+        for j in range(16):
+            z[j * 64] = 1
+
+    @ti.kernel
+    def total() -> ti.i32:
+        s = 0
+        for i in x:
+            s += x[i] + y[i]
+        for j in z:
+            s += z[j]
+        return s
+
+    activate()
+    assert total() == 64 + 16
@@ -1,7 +1,9 @@
 import atexit
 import functools
+import json
 import math
 import shutil
+import tempfile
 import threading
 from os import listdir, rmdir, stat
 from os.path import join
@@ -168,6 +170,17 @@ simple_kernels_to_test = [
 ]
 
 
+def compiled_kernels():
+    # Kernels lowered since ti.compile_profiler_clear(); needs
+    # ti.init(compile_profiler=True).
+    with tempfile.TemporaryDirectory() as tmpdir:
+        fn = join(tmpdir, "compile_profile.json")
+        ti.compile_profiler_save(fn)
+        with open(fn) as f:
+            passes = json.load(f)["passes"]
+    return [p["kernel"] for p in passes if p["pass"] == "Offloaded"]
+
+
 def _test_offline_cache_dec(func):
     @functools.wraps(func)
     def wrapped(*args, **kwargs):
@@ -594,3 +607,140 @@ def test_offline_cache_for_kernels_calling_real_func(curr_arch):
 
     ti.reset()
     assert added_files() == expected_num_cache_files(2)
+
+
+@pytest.mark.parametrize("curr_arch", supported_archs_offline_cache)
+@_test_offline_cache_dec
+def test_offline_cache_warm_up(curr_arch):
+    count_of_cache_file = cache_files_cnt()
+
+    def added_files():
+        return cache_files_cnt() - count_of_cache_file
+
+    def run_kernels():
+        for kernel, args, get_res in simple_kernels_to_test:
+            assert kernel(*args) == test_utils.approx(get_res(*args))
+
+    num_kernels = len(simple_kernels_to_test)
+    ti.init(arch=curr_arch, enable_fallback=False, **current_thread_ext_options())
+    run_kernels()
+
+    # Warm up fewer kernels than were cached; the rest are loaded on demand.
+    ti.init(
+        arch=curr_arch,
+        enable_fallback=False,
+        offline_cache_warm_up_kernels=num_kernels - 1,
+        **current_thread_ext_options(),
+    )
+    assert added_files() == expected_num_cache_files(num_kernels)
+    run_kernels()
+
+    ti.reset()
+    assert added_files() == expected_num_cache_files(num_kernels)
+
+
+@pytest.mark.parametrize("curr_arch", supported_archs_offline_cache)
+@_test_offline_cache_dec
+def test_offline_cache_single_file(curr_arch):
+    def run_kernels():
+        for kernel, args, get_res in simple_kernels_to_test:
+            assert kernel(*args) == test_utils.approx(get_res(*args))
+
+    options = {**current_thread_ext_options(), "offline_cache_single_file": True}
+    ti.init(arch=curr_arch, enable_fallback=False, **options)
+    run_kernels()
+
+    ti.init(arch=curr_arch, enable_fallback=False, compile_profiler=True, **options)
+    files = listdir(tmp_offline_cache_file_path())
+    assert "ticache.ticc" in files
+    assert not any(is_offline_cache_file(f) for f in files)
+    ti.compile_profiler_clear()
+    run_kernels()
+
+    # Every kernel is loaded from the container instead of being recompiled.
+    assert compiled_kernels() == []
+
+    ti.reset()
+
+
+@pytest.mark.parametrize("curr_arch", supported_archs_offline_cache)
+@_test_offline_cache_dec
+def test_offline_cache_single_file_cleaning(curr_arch):
+    def run_kernels(max_size):
+        ti.init(
+            arch=curr_arch,
+            enable_fallback=False,
+            offline_cache_single_file=True,
+            offline_cache_cleaning_policy="lru",
+            offline_cache_max_size_of_files=max_size,  # bytes
+            offline_cache_cleaning_factor=1.0,
+            **current_thread_ext_options(),
+        )
+        for kernel, args, get_res in simple_kernels_to_test:
+            assert kernel(*args) == test_utils.approx(get_res(*args))
+        ti.reset()
+
+    container = join(tmp_offline_cache_file_path(), "ticache.ticc")
+    run_kernels(1024**3)  # 1GB (>> size of the container)
+    size = stat(container).st_size
+
+    # Cleaning removes all kernels, so their blobs are dropped from the
+    # container.
+    run_kernels(1)
+    files = listdir(tmp_offline_cache_file_path())
+    assert "ticache.ticc" not in files or stat(container).st_size < size
+
+
+def _multi_process_cache_worker(path, num_compiled):
+    ti.init(
+        arch=ti.cpu,
+        offline_cache=True,
+        offline_cache_file_path=path,
+        offline_cache_multi_process=True,
+        compile_profiler=True,
+    )
+    for kernel, args, get_res in simple_kernels_to_test:
+        assert kernel(*args) == test_utils.approx(get_res(*args))
+    num_compiled.put(len(compiled_kernels()))
+    ti.reset()
+
+
+@test_utils.test(arch=ti.cpu)
+@_test_offline_cache_dec
+def test_offline_cache_multi_process():
+    import multiprocessing
+
+    path = tmp_offline_cache_file_path()
+    ctx = multiprocessing.get_context("spawn")
+    num_compiled = ctx.Queue()
+    workers = [ctx.Process(target=_multi_process_cache_worker, args=(path, num_compiled)) for _ in range(4)]
+    for w in workers:
+        w.start()
+    for w in workers:
+        w.join()
+        assert w.exitcode == 0
+
+    # Each kernel is compiled by exactly one worker; the others load it.
+    counts = [num_compiled.get() for _ in workers]
+    assert sum(counts) == len(simple_kernels_to_test)
+
+    files = listdir(path)
+    # One file per kernel, no leftover claims or temporary files.
+    assert sum(is_offline_cache_file(f) for f in files) == len(simple_kernels_to_test)
+    assert not any(f.endswith((".claim", ".tmp")) for f in files)
+
+    # Cleaning merges the journals left by the workers, so it knows about the
+    # kernels of all of them and removes every one.
+    ti.init(
+        arch=ti.cpu,
+        offline_cache=True,
+        offline_cache_file_path=path,
+        offline_cache_multi_process=True,
+        offline_cache_cleaning_policy="lru",
+        offline_cache_max_size_of_files=1,
+        offline_cache_cleaning_factor=1.0,
+    )
+    ti.reset()
+    files = listdir(path)
+    assert not any(f.endswith(".tcj") for f in files)
+    assert not any(is_offline_cache_file(f) for f in files)
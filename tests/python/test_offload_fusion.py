@@ -0,0 +1,117 @@
+import json
+import os
+import tempfile
+
+import numpy as np
+
+import taichi as ti
+from tests import test_utils
+
+
+def _count_tasks(kernel_name):
+    with tempfile.TemporaryDirectory() as tmpdir:
+        fn = os.path.join(tmpdir, "compile_profile.json")
+        ti.compile_profiler_save(fn)
+        with open(fn) as f:
+            passes = json.load(f)["passes"]
+    ti.compile_profiler_clear()
+    return sum(1 for p in passes if p["pass"] == "codegen" and p["kernel"].startswith(kernel_name))
+
+
+@test_utils.test(arch=ti.cpu, compile_profiler=True, offline_cache=False, llvm_task_cache=False)
+def test_fuse_elementwise_chain():
+    n = 1000
+    x = ti.field(ti.f32, shape=n)
+    y = ti.field(ti.f32, shape=n)
+    z = ti.field(ti.f32, shape=n)
+
+    @ti.kernel
+    def chain():
+        for i in x:
+            y[i] = x[i] * 2
+        for i in x:
+            z[i] = y[i] + 1
+        for i in x:
+            y[i] = z[i] * z[i]
+
+    x.from_numpy(np.arange(n, dtype=np.float32))
+    ti.compile_profiler_clear()
+    chain()
+    assert _count_tasks("chain") == 1
+    expected = (np.arange(n) * 2 + 1) ** 2
+    np.testing.assert_allclose(y.to_numpy(), expected)
+
+
+@test_utils.test(arch=ti.cpu, compile_profiler=True, offline_cache=False, llvm_task_cache=False)
+def test_fuse_ndrange():
+    x = ti.field(ti.i32, shape=(20, 30))
+    y = ti.field(ti.i32, shape=(20, 30))
+
+    @ti.kernel
+    def chain():
+        for i, j in ti.ndrange(20, 30):
+            x[i, j] = i * 100 + j
+        for i, j in ti.ndrange(20, 30):
+            y[i, j] = x[i, j] + 1
+
+    ti.compile_profiler_clear()
+    chain()
+    assert _count_tasks("chain") == 1
+    i, j = np.meshgrid(np.arange(20), np.arange(30), indexing="ij")
+    assert (y.to_numpy() == i * 100 + j + 1).all()
+
+
+@test_utils.test(arch=ti.cpu, compile_profiler=True, offline_cache=False, llvm_task_cache=False)
+def test_no_fusion_across_neighbours():
+    n = 1000
+    x = ti.field(ti.i32, shape=n + 1)
+    y = ti.field(ti.i32, shape=n)
+
+    @ti.kernel
+    def shift():
+        for i in range(n):
+            x[i + 1] = i + 1
+        for i in range(n):
+            y[i] = x[i + 1] - x[i]
+
+    ti.compile_profiler_clear()
+    shift()
+    assert _count_tasks("shift") == 2
+    assert (y.to_numpy() == 1).all()
+
+
+@test_utils.test(arch=ti.cpu, compile_profiler=True, offline_cache=False, llvm_task_cache=False)
+def test_no_fusion_after_reduction():
+    n = 1000
+    x = ti.field(ti.i32, shape=n)
+    s = ti.field(ti.i32, shape=())
+
+    @ti.kernel
+    def normalize():
+        for i in x:
+            s[None] += x[i]
+        for i in x:
+            x[i] = s[None] - x[i]
+
+    x.fill(1)
+    ti.compile_profiler_clear()
+    normalize()
+    assert _count_tasks("normalize") == 2
+    assert (x.to_numpy() == n - 1).all()
+
+
+@test_utils.test(arch=ti.cpu, compile_profiler=True, offline_cache=False, llvm_task_cache=False, offload_fusion=False)
+def test_fusion_disabled():
+    x = ti.field(ti.f32, shape=16)
+    y = ti.field(ti.f32, shape=16)
+
+    @ti.kernel
+    def chain():
+        for i in x:
+            y[i] = x[i] * 2
+        for i in x:
+            x[i] = y[i] + 1
+
+    ti.compile_profiler_clear()
+    chain()
+    assert _count_tasks("chain") == 2
@@ -163,3 +163,26 @@ def test_reduction_ndarray():
     n = 1024
     x = np.ones(n, dtype=np.int32)
     assert reduce(x) == -n
+
+
+@test_utils.test()
+def test_reduction_constant_indices():
+    n = 1000
+    x = ti.field(ti.f32, shape=n)
+    s = ti.field(ti.f32, shape=(2, 3))
+    m = ti.field(ti.i32, shape=4)
+
+    @ti.kernel
+    def reduce():
+        for i in x:
+            s[0, 1] += x[i]
+            s[1, 2] -= 2 * x[i]
+            ti.atomic_max(m[3], i)
+
+    x.fill(1)
+    reduce()
+    expected = np.zeros((2, 3), dtype=np.float32)
+    expected[0, 1] = n
+    expected[1, 2] = -2 * n
+    np.testing.assert_allclose(s.to_numpy(), expected)
+    assert (m.to_numpy() == [0, 0, 0, n - 1]).all()